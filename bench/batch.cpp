@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "bits/ThreadPool.h"
+#include "lexer/lex.h"
+
+using namespace plush;
+
+// Builds the content of a source file, with identifiers shared between files
+// and identifiers unique to the file.
+static std::string makeSource(std::size_t file, std::size_t lineCount) {
+ std::string source;
+ for (std::size_t i = 0; i < lineCount; ++i)
+  source += "let shared_" + std::to_string(i % 64) + " ; file_" +
+            std::to_string(file) + "_" + std::to_string(i % 1024) +
+            " (:module ;|> \"a string\" # comment\n";
+ return source;
+}
+
+int main(int argc, char **argv) {
+ std::size_t const fileCount {(argc > 1) ? std::stoul(argv[1]) : 64};
+ std::size_t const lineCount {(argc > 2) ? std::stoul(argv[2]) : 20000};
+ std::size_t const maxThreads {(argc > 3) ? std::stoul(argv[3])
+                                          : ThreadPool::defaultThreadCount()};
+
+ std::vector<std::string> sources;
+ std::size_t              byteCount {0};
+ for (std::size_t i = 0; i < fileCount; ++i) {
+  sources.push_back(makeSource(i, lineCount));
+  byteCount += sources.back().size();
+ }
+
+ double baseSeconds {0};
+ for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+  SourceManager                                     srcMgr;
+  std::vector<SourceInfo *>                         srcInfos;
+  std::vector<std::unique_ptr<DiagnosticsManager>> diagMgrs;
+  std::vector<DiagnosticsManager *>                 diagMgrPtrs;
+  for (auto &source : sources) {
+   srcInfos.push_back(srcMgr.addShellInput(source));
+   diagMgrPtrs.push_back(
+     diagMgrs.emplace_back(std::make_unique<DiagnosticsManager>()).get());
+  }
+
+  IdTable    idTable {threads > 1};
+  ThreadPool pool {threads};
+
+  auto begin {std::chrono::steady_clock::now()};
+  auto tokBufs {lex(srcInfos, idTable, diagMgrPtrs, pool)};
+  auto end {std::chrono::steady_clock::now()};
+
+  for (auto &diagMgr : diagMgrs)
+   if (diagMgr->dump()) return 1;
+
+  std::size_t tokenCount {0};
+  for (auto &tokBuf : tokBufs) tokenCount += tokBuf.size();
+
+  double seconds {std::chrono::duration<double> {end - begin}.count()};
+  if (1 == threads) baseSeconds = seconds;
+
+  std::cout << "batch: " << fileCount << " files, " << threads << " threads, "
+            << tokenCount << " tokens, "
+            << static_cast<double>(byteCount) / seconds / 1e6 << " MB/s, "
+            << baseSeconds / seconds << "x\n";
+ }
+}
@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Runs commands repeatedly as builtins and, quoting their names, as external
+// binaries, writing to /dev/null. Usage: builtins.o [calls]
+
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "lexer/lex.h"
+#include "parser/parse.h"
+#include "vm/Vm.h"
+#include "vm/compile.h"
+
+using namespace plush;
+
+// Compiles the source and runs it the provided number of times, returning the
+// number of runs per second.
+static double measure(std::string_view source, std::size_t runs, int out) {
+ IdTable            idTable;
+ SourceManager      srcMgr;
+ DiagnosticsManager diagMgr;
+ TokenBuffer tokBuf {lex(srcMgr.addShellInput(std::string {source}), idTable,
+                         diagMgr)};
+ ast::Ast    ast {parse(tokBuf, diagMgr)};
+ vm::BuiltinRegistry builtins {idTable};
+ auto                eChunk {vm::compile(ast, builtins)};
+ if (diagMgr.dump() || !eChunk) return 0;
+
+ vm::Vm vm;
+ auto   begin {std::chrono::steady_clock::now()};
+ for (std::size_t i = 0; i < runs; ++i)
+  if (!vm.run(*eChunk, 0, out)) return 0;
+ auto end {std::chrono::steady_clock::now()};
+ return static_cast<double>(runs) /
+        std::chrono::duration<double> {end - begin}.count();
+}
+
+int main(int argc, char **argv) {
+ std::size_t const calls {(argc > 1) ? std::stoul(argv[1]) : 1000};
+ int               out {::open("/dev/null", O_WRONLY | O_CLOEXEC)};
+ if (out < 0) return 1;
+
+ // Each pair runs the same commands, as builtins then as external binaries.
+ std::pair<std::string_view, std::string_view> const cases[] {
+   {"true", "\"true\""},
+   {"echo \"hello\"", "\"echo\" \"hello\""},
+   {"printf \"%s %d\\n\" a \"1\"", "\"printf\" \"%s %d\\n\" a \"1\""},
+   {"test a \"=\" a", "\"test\" a \"=\" a"},
+   {"echo \"hello\" |> cat", "\"echo\" \"hello\" |> \"cat\""},
+ };
+ for (auto [builtin, external] : cases) {
+  double builtinRate {measure(builtin, calls * 100, out)};
+  double externalRate {measure(external, calls, out)};
+  std::cout << "builtins: " << builtin << ": builtin " << builtinRate
+            << " calls/s, external " << externalRate << " calls/s ("
+            << builtinRate / externalRate << "x)\n";
+ }
+ ::close(out);
+}
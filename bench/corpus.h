@@ -0,0 +1,168 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Seeded generator of synthetic Plush sources for benchmarks.
+
+#pragma once
+
+#ifndef PLUSH_BENCH_CORPUS_H
+#define PLUSH_BENCH_CORPUS_H
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace plush::bench {
+
+// Mix of tokens a corpus is biased towards.
+enum class Mix : std::uint8_t { ID, STRING, COMMENT, UNICODE, PIPE };
+
+constexpr std::array<Mix, 5> MIXES {Mix::ID, Mix::STRING, Mix::COMMENT,
+                                    Mix::UNICODE, Mix::PIPE};
+
+constexpr std::string_view mixToString(Mix mix) {
+ switch (mix) {
+  case Mix::ID:
+   return "id";
+  case Mix::STRING:
+   return "string";
+  case Mix::COMMENT:
+   return "comment";
+  case Mix::UNICODE:
+   return "unicode";
+  case Mix::PIPE:
+   return "pipe";
+ }
+ return "";
+}
+
+// Generates lines of Plush source until at least size bytes are produced. The
+// output only depends on the mix, size and seed.
+class CorpusGenerator final {
+ // Only the raw engine output is used, distributions aren't required to produce
+ // the same sequences across standard libraries.
+ std::mt19937_64 mEngine;
+ std::string     mOut;
+
+ std::uint64_t pick(std::uint64_t n) { return mEngine() % n; }
+
+ void id() {
+  constexpr std::string_view KEYWORDS[] {"if",     "do",     "let",
+                                         "module", "import", "as"};
+  constexpr std::string_view HEAD {"abcdefghijklmnopqrstuvwxyz"
+                                   "ABCDEFGHIJKLMNOPQRSTUVWXYZ_"};
+  constexpr std::string_view TAIL {"abcdefghijklmnopqrstuvwxyz_0123456789"};
+
+  if (!pick(8)) {
+   mOut += KEYWORDS[pick(std::size(KEYWORDS))];
+   return;
+  }
+  // Reuse a small vocabulary most of the time, as real sources do.
+  std::uint64_t size {1 + pick(12)};
+  std::uint64_t seed {pick(4) ? pick(512) : mEngine()};
+  mOut += HEAD[seed % HEAD.size()];
+  for (std::uint64_t i = 1; i < size; ++i)
+   mOut += TAIL[(seed >> (i % 32)) * (i + 1) % TAIL.size()];
+ }
+
+ void string(bool unicode) {
+  constexpr std::string_view UNICODE_TEXT[] {"é", "ü", "ß", "λ", "→", "字",
+                                             "😀"};
+  mOut += '"';
+  std::uint64_t size {pick(64)};
+  for (std::uint64_t i = 0; i < size; ++i) {
+   if (unicode && !pick(3))
+    mOut += UNICODE_TEXT[pick(std::size(UNICODE_TEXT))];
+   else if (!pick(32))
+    mOut += "\\n";
+   else
+    mOut += static_cast<char>('a' + pick(26));
+  }
+  mOut += '"';
+ }
+
+ void comment(bool unicode) {
+  mOut += "# ";
+  std::uint64_t size {pick(80)};
+  for (std::uint64_t i = 0; i < size; ++i)
+   if (unicode && !pick(4))
+    mOut += "ü";
+   else
+    mOut += static_cast<char>(' ' + pick('~' - ' '));
+  mOut += '\n';
+ }
+
+ void punctuator() {
+  constexpr std::string_view PUNCTUATORS[] {"(", ")", "[", "]",
+                                            "{", "}", ":", ";"};
+  mOut += PUNCTUATORS[pick(std::size(PUNCTUATORS))];
+ }
+
+ void pipeline() {
+  std::uint64_t size {2 + pick(6)};
+  for (std::uint64_t i = 0; i < size; ++i) {
+   if (i) mOut += pick(4) ? " |> " : " <| ";
+   id();
+   if (!pick(3)) {
+    mOut += ' ';
+    id();
+   }
+  }
+ }
+
+ void separator(bool unicode) {
+  if (unicode && !pick(4))
+   // NO-BREAK SPACE and IDEOGRAPHIC SPACE.
+   mOut += pick(2) ? "\xc2\xa0" : "\xe3\x80\x80";
+  else
+   mOut += pick(16) ? " " : "\n";
+ }
+
+ void line(Mix mix) {
+  std::uint64_t count {1 + pick(10)};
+  for (std::uint64_t i = 0; i < count; ++i) {
+   if (i) separator(Mix::UNICODE == mix);
+   std::uint64_t roll {pick(16)};
+   switch (mix) {
+    case Mix::ID:
+     roll < 13 ? id() : roll < 15 ? punctuator() : string(false);
+     break;
+    case Mix::STRING:
+     roll < 11 ? string(false) : roll < 14 ? id() : punctuator();
+     break;
+    case Mix::COMMENT:
+     if (roll < 3) id();
+     break;
+    case Mix::UNICODE:
+     roll < 6 ? string(true) : roll < 12 ? id() : punctuator();
+     break;
+    case Mix::PIPE:
+     roll < 10 ? pipeline() : roll < 13 ? id() : punctuator();
+     break;
+   }
+  }
+
+  if (Mix::COMMENT == mix || (Mix::UNICODE == mix && !pick(4))) {
+   mOut += ' ';
+   comment(Mix::UNICODE == mix);
+  } else
+   mOut += '\n';
+ }
+
+public:
+ explicit CorpusGenerator(std::uint64_t seed) : mEngine {seed} {}
+
+ std::string generate(Mix mix, std::size_t size) {
+  mOut.clear();
+  mOut.reserve(size + 256);
+  while (mOut.size() < size) line(mix);
+  return std::move(mOut);
+ }
+};
+
+} // namespace plush::bench
+
+#endif // PLUSH_BENCH_CORPUS_H
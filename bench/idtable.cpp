@@ -0,0 +1,52 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "basic/IdTable.h"
+
+using namespace plush;
+
+// Generates a distinct identifier for every index.
+static std::string makeId(std::size_t i) {
+ std::string id {"id_"};
+ do {
+  id += static_cast<char>('a' + i % 26);
+  i /= 26;
+ } while (i);
+ return id;
+}
+
+int main(int argc, char **argv) {
+ std::size_t const lookupRounds {(argc > 1) ? std::stoul(argv[1]) : 4};
+
+ for (std::size_t distinct : {10000, 100000, 1000000}) {
+  std::vector<std::string> ids;
+  ids.reserve(distinct);
+  for (std::size_t i = 0; i < distinct; ++i) ids.push_back(makeId(i));
+
+  IdTable idTable;
+
+  auto   begin {std::chrono::steady_clock::now()};
+  IdInfo *last {nullptr};
+  for (auto &id : ids) last = idTable.get(id);
+  auto middle {std::chrono::steady_clock::now()};
+  for (std::size_t r = 0; r < lookupRounds; ++r)
+   for (auto &id : ids) last = idTable.get(id);
+  auto end {std::chrono::steady_clock::now()};
+
+  if (!last) return 1;
+
+  double insertNs {
+    std::chrono::duration<double, std::nano> {middle - begin}.count()};
+  double lookupNs {
+    std::chrono::duration<double, std::nano> {end - middle}.count()};
+
+  std::cout << "idtable: " << distinct << " distinct, "
+            << insertNs / distinct << " ns/insert, "
+            << lookupNs / (distinct * lookupRounds) << " ns/lookup\n";
+ }
+}
@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Runs a fan-out script of independent statements, each launching a command
+// that sleeps, with doubling job counts. The critical path is a single sleep.
+// Usage: jobs.o [statements] [sleep seconds] [max jobs]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "lexer/lex.h"
+#include "parser/parse.h"
+#include "vm/Schedule.h"
+
+using namespace plush;
+
+int main(int argc, char **argv) {
+ std::size_t const statements {(argc > 1) ? std::stoul(argv[1]) : 32};
+ std::string const seconds {(argc > 2) ? argv[2] : "0.05"};
+ std::size_t const maxJobs {(argc > 3) ? std::stoul(argv[3]) : 32};
+
+ std::string source;
+ for (std::size_t i = 0; i < statements; ++i)
+  source += "sh \"-c\" \"sleep " + seconds + "; echo " + std::to_string(i) +
+            "\" |> tr \"0-9\" \"a-j\";\n";
+
+ IdTable            idTable;
+ SourceManager      srcMgr;
+ DiagnosticsManager diagMgr;
+ TokenBuffer tokBuf {lex(srcMgr.addShellInput(std::move(source)), idTable,
+                         diagMgr)};
+ ast::Ast    ast {parse(tokBuf, diagMgr)};
+ if (diagMgr.dump()) return 1;
+ vm::BuiltinRegistry builtins {idTable};
+ auto                eSchedule {vm::Schedule::analyze(ast, builtins)};
+ if (!eSchedule) return 1;
+
+ int devNull {::open("/dev/null", O_WRONLY | O_CLOEXEC)};
+ for (std::size_t jobs = 1;; jobs = std::min(jobs * 2, maxJobs)) {
+  vm::Vm           vm;
+  WorkStealingPool pool {jobs};
+  auto             begin {std::chrono::steady_clock::now()};
+  auto             eStatus {(*eSchedule).run(vm, pool, 0, devNull)};
+  auto             end {std::chrono::steady_clock::now()};
+  if (!eStatus || *eStatus) return 1;
+
+  double ms {std::chrono::duration<double, std::milli> {end - begin}.count()};
+  std::cout << "jobs: " << statements << " statements, " << jobs
+            << " jobs, " << ms << " ms, critical path " << seconds << " s\n";
+  if (jobs == maxJobs) break;
+ }
+ ::close(devNull);
+}
@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "lexer/lex.h"
+
+using namespace plush;
+
+// Source line repeated to build the benchmark input, covering every lexlet.
+static constexpr char const *LINE {
+  "let hi there (:module ;|><| \"im in a string!\\n\" # comment\n"};
+
+int main(int argc, char **argv) {
+ std::size_t const lineCount {(argc > 1) ? std::stoul(argv[1]) : 200000};
+ std::size_t const iterations {(argc > 2) ? std::stoul(argv[2]) : 5};
+
+ std::string input;
+ for (std::size_t i = 0; i < lineCount; ++i) input += LINE;
+
+ std::size_t tokenCount {0};
+ double      seconds {0};
+
+ for (std::size_t i = 0; i < iterations; ++i) {
+  DiagnosticsManager diagMgr;
+  IdTable            idTable;
+  SourceManager      srcMgr;
+  SourceInfo        *srcInfo {srcMgr.addShellInput(input)};
+
+  auto begin {std::chrono::steady_clock::now()};
+  auto tokBuf {lex(srcInfo, idTable, diagMgr)};
+  auto end {std::chrono::steady_clock::now()};
+
+  if (diagMgr.dump()) return 1;
+
+  tokenCount += tokBuf.tokens().size();
+  seconds += std::chrono::duration<double> {end - begin}.count();
+ }
+
+ std::cout << "lex: " << input.size() << " bytes, " << tokenCount / iterations
+           << " tokens, " << static_cast<double>(tokenCount) / seconds
+           << " tokens/s, "
+           << static_cast<double>(input.size() * iterations) / seconds / 1e6
+           << " MB/s\n";
+}
@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Loads a generated tree of modules, each importing a few modules of the next
+// layer, with doubling thread counts up to every hardware thread.
+// Usage: modules.o [modules] [statements] [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "driver/ModuleLoader.h"
+
+using namespace plush;
+
+int main(int argc, char **argv) {
+ std::size_t const moduleCount {(argc > 1) ? std::stoul(argv[1]) : 500};
+ std::size_t const statements {(argc > 2) ? std::stoul(argv[2]) : 500};
+ std::size_t const iterations {(argc > 3) ? std::stoul(argv[3]) : 5};
+
+ auto dir {std::filesystem::temp_directory_path() /
+           ("plush_modules_" + std::to_string(::getpid()))};
+ std::filesystem::create_directories(dir);
+
+ // Module i imports modules 2i + 1 to 2i + 3, forming a graph where most
+ // modules are imported twice.
+ for (std::size_t i = 0; i < moduleCount; ++i) {
+  std::ofstream out {dir / ("m" + std::to_string(i) + ".psh")};
+  out << "module m" << i << ";\n";
+  for (std::size_t j = 2 * i + 1; j <= 2 * i + 3 && j < moduleCount; ++j)
+   out << "import \"m" << j << ".psh\" as m" << j << ";\n";
+  for (std::size_t j = 0; j < statements; ++j)
+   out << "if test \"" << j << "\" \"-lt\" \"" << i
+       << "\" { echo \"statement\" |> tr \"a-z\" \"A-Z\" } { false };\n";
+ }
+
+ std::size_t const maxThreads {ThreadPool::defaultThreadCount()};
+ for (std::size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+  double best {0};
+  for (std::size_t i = 0; i < iterations; ++i) {
+   auto begin {std::chrono::steady_clock::now()};
+
+   FileManager          fileMgr;
+   SourceManager        srcMgr;
+   IdTable              idTable {threads > 1};
+   ThreadPool           pool {threads};
+   driver::ModuleLoader loader {fileMgr, srcMgr, idTable, pool};
+   auto                 eModules {loader.load({dir / "m0.psh"})};
+   if (!eModules || (*eModules).size() != moduleCount) return 1;
+
+   auto   end {std::chrono::steady_clock::now()};
+   double ms {std::chrono::duration<double, std::milli> {end - begin}.count()};
+   best = i ? std::min(best, ms) : ms;
+  }
+  std::cout << "modules: " << moduleCount << " modules, " << threads
+            << " threads, " << best << " ms\n";
+  if (threads == maxThreads) break;
+ }
+
+ std::filesystem::remove_all(dir);
+}
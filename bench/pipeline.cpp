@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Moves data through a pipe of cat stages run by the Vm, with builtin then
+// external stages, comparing against the same pipeline run by /bin/sh.
+// Usage: pipeline.o [bytes] [stages] [iterations]
+
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "lexer/lex.h"
+#include "parser/parse.h"
+#include "vm/Vm.h"
+#include "vm/compile.h"
+
+using namespace plush;
+
+int main(int argc, char **argv) {
+ std::size_t const byteCount {(argc > 1) ? std::stoul(argv[1]) : 1ul << 30};
+ std::size_t const stageCount {(argc > 2) ? std::stoul(argv[2]) : 10};
+ std::size_t const iterations {(argc > 3) ? std::stoul(argv[3]) : 3};
+
+ std::string const head {"head \"-c\" \"" + std::to_string(byteCount) +
+                         "\" \"/dev/zero\""};
+ // A quoted name launches the external command instead of the builtin.
+ std::string builtinSource {head}, externalSource {head};
+ std::string shCommand {"head -c " + std::to_string(byteCount) + " /dev/zero"};
+ for (std::size_t i = 1; i < stageCount; ++i) {
+  builtinSource += " |> cat";
+  externalSource += " |> \"cat\"";
+  shCommand += " | cat";
+ }
+ shCommand += " > /dev/null";
+
+ IdTable             idTable;
+ SourceManager       srcMgr;
+ DiagnosticsManager  diagMgr;
+ vm::BuiltinRegistry builtins {idTable};
+ // Chunks refer to the tokens of their source, which must outlive them.
+ TokenBuffer builtinTokBuf {
+   lex(srcMgr.addShellInput(std::move(builtinSource)), idTable, diagMgr)};
+ TokenBuffer externalTokBuf {
+   lex(srcMgr.addShellInput(std::move(externalSource)), idTable, diagMgr)};
+ ast::Ast builtinAst {parse(builtinTokBuf, diagMgr)};
+ ast::Ast externalAst {parse(externalTokBuf, diagMgr)};
+ auto     eBuiltinChunk {vm::compile(builtinAst, builtins)};
+ auto     eExternalChunk {vm::compile(externalAst, builtins)};
+ if (diagMgr.dump() || !eBuiltinChunk || !eExternalChunk) return 1;
+
+ vm::Vm vm;
+ int    devNull {::open("/dev/null", O_WRONLY | O_CLOEXEC)};
+ double builtinSeconds {0}, externalSeconds {0}, shSeconds {0};
+
+ for (std::size_t i = 0; i < iterations; ++i) {
+  auto begin {std::chrono::steady_clock::now()};
+  auto eStatus {vm.run(*eBuiltinChunk, 0, devNull)};
+  auto end {std::chrono::steady_clock::now()};
+  if (!eStatus || *eStatus) return 1;
+  builtinSeconds += std::chrono::duration<double> {end - begin}.count();
+
+  begin   = std::chrono::steady_clock::now();
+  eStatus = vm.run(*eExternalChunk, 0, devNull);
+  end     = std::chrono::steady_clock::now();
+  if (!eStatus || *eStatus) return 1;
+  externalSeconds += std::chrono::duration<double> {end - begin}.count();
+
+  begin = std::chrono::steady_clock::now();
+  if (std::system(shCommand.c_str())) return 1;
+  end = std::chrono::steady_clock::now();
+  shSeconds += std::chrono::duration<double> {end - begin}.count();
+ }
+ ::close(devNull);
+
+ double const bytes {static_cast<double>(byteCount * iterations)};
+ std::cout << "pipeline: " << stageCount << " stages, " << byteCount
+           << " bytes, plush " << bytes / builtinSeconds / 1e6
+           << " MB/s, plush external " << bytes / externalSeconds / 1e6
+           << " MB/s, sh " << bytes / shSeconds / 1e6 << " MB/s\n";
+}
@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Launches a command repeatedly through the Launcher and through fork+exec,
+// with a resident heap standing in for a long-running interpreter's address
+// space. Usage: spawn.o [spawns] [heapMiB] [command]
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "exec/Launcher.h"
+
+using namespace plush;
+
+int main(int argc, char **argv) {
+ std::size_t const spawnCount {(argc > 1) ? std::stoul(argv[1]) : 2000};
+ std::size_t const heapSize {((argc > 2) ? std::stoul(argv[2]) : 256) << 20};
+ std::string const command {(argc > 3) ? argv[3] : "/bin/true"};
+
+ // Touch every page so fork has to copy the page tables mapping them.
+ std::vector<char> heap(heapSize);
+ std::memset(heap.data(), 1, heap.size());
+
+ exec::Launcher         launcher;
+ std::string_view const args[] {command};
+ auto                   begin {std::chrono::steady_clock::now()};
+ for (std::size_t i = 0; i < spawnCount; ++i) {
+  auto ePid {launcher.spawn(std::begin(args), std::end(args))};
+  if (!ePid || !exec::Launcher::wait(*ePid)) return 1;
+ }
+ auto   end {std::chrono::steady_clock::now()};
+ double launcherSeconds {std::chrono::duration<double> {end - begin}.count()};
+
+ char *const forkArgv[] {const_cast<char *>(command.c_str()), nullptr};
+ begin = std::chrono::steady_clock::now();
+ for (std::size_t i = 0; i < spawnCount; ++i) {
+  pid_t pid {::fork()};
+  if (pid < 0) return 1;
+  if (!pid) {
+   ::execv(forkArgv[0], forkArgv);
+   ::_exit(127);
+  }
+  int status;
+  ::waitpid(pid, &status, 0);
+ }
+ end = std::chrono::steady_clock::now();
+ double forkSeconds {std::chrono::duration<double> {end - begin}.count()};
+
+ std::cout << "spawn: " << (heapSize >> 20) << " MiB heap, launcher "
+           << static_cast<double>(spawnCount) / launcherSeconds
+           << " spawns/s, fork+exec "
+           << static_cast<double>(spawnCount) / forkSeconds << " spawns/s\n";
+}
@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Pushes a file through pipes of growing numbers of builtin cat stages on every
+// event loop backend.
+// Usage: stages.o [file] [max stages]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "lexer/lex.h"
+#include "parser/parse.h"
+#include "vm/Vm.h"
+#include "vm/compile.h"
+
+using namespace plush;
+using Backend = exec::EventLoop::Backend;
+
+int main(int argc, char **argv) {
+ std::string const file {(argc > 1) ? argv[1] : "/etc/services"};
+ std::size_t       maxStages {(argc > 2) ? std::stoul(argv[2]) : 4096};
+
+ // Every stage holds a couple of descriptors until the pipe finishes.
+ rlimit limit;
+ ::getrlimit(RLIMIT_NOFILE, &limit);
+ limit.rlim_cur = limit.rlim_max;
+ ::setrlimit(RLIMIT_NOFILE, &limit);
+ maxStages = std::min<std::size_t>(maxStages, (limit.rlim_cur - 64) / 3);
+
+ int devNull {::open("/dev/null", O_WRONLY | O_CLOEXEC)};
+ for (std::size_t stages = 1; stages <= maxStages; stages *= 4) {
+  std::string source {"cat \"" + file + "\""};
+  for (std::size_t i = 0; i < stages; ++i) source += " |> cat";
+
+  IdTable            idTable;
+  SourceManager      srcMgr;
+  DiagnosticsManager diagMgr;
+  TokenBuffer tokBuf {lex(srcMgr.addShellInput(std::move(source)), idTable,
+                          diagMgr)};
+  ast::Ast    ast {parse(tokBuf, diagMgr)};
+  if (diagMgr.dump()) return 1;
+  vm::BuiltinRegistry builtins {idTable};
+  auto                eChunk {vm::compile(ast, builtins)};
+  if (!eChunk) return 1;
+
+  for (Backend backend : {Backend::IO_URING, Backend::EPOLL, Backend::POLL}) {
+   vm::Vm vm {backend};
+   if (vm.loop().backend() != backend) continue;
+   auto begin {std::chrono::steady_clock::now()};
+   auto eStatus {vm.run(*eChunk, 0, devNull)};
+   auto end {std::chrono::steady_clock::now()};
+   if (!eStatus || *eStatus) return 1;
+
+   double ms {std::chrono::duration<double, std::milli> {end - begin}.count()};
+   char const *const names[] {"io_uring", "epoll", "poll"};
+   std::cout << "stages: " << stages << " stages, "
+             << names[static_cast<int>(backend)] << ", " << ms << " ms\n";
+  }
+ }
+ ::close(devNull);
+}
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Launches the plush binary on a script whose only statement is true, from
+// exec to its first statement, without a prelude, compiling a generated
+// prelude every launch, and mapping it from a snapshot. Build the binary with
+// `make release` first. Usage: startup.o [launches] [binary] [statements]
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "exec/Launcher.h"
+
+using namespace plush;
+
+// Launches the binary with the provided arguments repeatedly, returning the
+// average launch time in microseconds.
+static double measure(exec::Launcher &launcher, std::size_t launches,
+                      std::vector<std::string_view> const &args) {
+ auto begin {std::chrono::steady_clock::now()};
+ for (std::size_t i = 0; i < launches; ++i) {
+  auto ePid {launcher.spawn(args.data(), args.data() + args.size())};
+  if (!ePid) return 0;
+  auto eStatus {exec::Launcher::wait(*ePid)};
+  if (!eStatus || *eStatus) return 0;
+ }
+ auto end {std::chrono::steady_clock::now()};
+ return std::chrono::duration<double, std::micro> {end - begin}.count() /
+        static_cast<double>(launches);
+}
+
+int main(int argc, char **argv) {
+ std::size_t const launches {(argc > 1) ? std::stoul(argv[1]) : 200};
+ std::string const binary {(argc > 2) ? argv[2] : "build/plush"};
+ std::size_t const statements {(argc > 3) ? std::stoul(argv[3]) : 2000};
+
+ auto dir {std::filesystem::temp_directory_path() /
+           ("plush_startup_" + std::to_string(::getpid()))};
+ std::filesystem::create_directories(dir);
+ std::string const script {(dir / "script.psh").string()},
+   prelude {(dir / "prelude.psh").string()},
+   image {(dir / "image").string()};
+
+ std::ofstream {script} << "true\n";
+ {
+  // Statements that compile to plenty of bytecode yet run without launching.
+  std::ofstream out {prelude};
+  for (std::size_t i = 0; i < statements; ++i)
+   out << "if false { echo \"prelude statement " << i << "\" |> cat }\n";
+ }
+
+ exec::Launcher launcher;
+ double         bare {measure(launcher, launches, {binary, script})};
+ double         compiled {
+   measure(launcher, launches, {binary, "--prelude", prelude, script})};
+ // The first launch saves the snapshot.
+ measure(launcher, 1,
+         {binary, "--prelude", prelude, "--snapshot", image, script});
+ double mapped {measure(launcher, launches,
+                        {binary, "--prelude", prelude, "--snapshot", image,
+                         script})};
+
+ std::filesystem::remove_all(dir);
+ std::cout << "startup: " << statements << " prelude statements, bare "
+           << bare << " us, compiled prelude " << compiled
+           << " us, snapshot " << mapped << " us\n";
+}
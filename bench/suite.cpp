@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Lexes generated corpora of every mix and size, printing a JSON object per
+// corpus. Usage: suite.o [sizes] [seed] [iterations] [outDir]
+//  sizes      comma separated byte sizes with optional K, M or G suffixes
+//  outDir     if provided, corpora are written and lexed from files there
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/FileManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "corpus.h"
+#include "lexer/lex.h"
+
+using namespace plush;
+
+// Every allocation made through operator new is counted.
+static std::atomic<std::size_t> gAllocCount {0}, gAllocBytes {0};
+
+void *operator new(std::size_t size) {
+ ++gAllocCount;
+ gAllocBytes += size;
+ if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+ std::abort();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+static std::size_t parseSize(std::string_view size) {
+ std::size_t scale {1};
+ switch (size.empty() ? '\0' : size.back()) {
+  case 'K':
+   scale = std::size_t {1} << 10;
+   break;
+  case 'M':
+   scale = std::size_t {1} << 20;
+   break;
+  case 'G':
+   scale = std::size_t {1} << 30;
+   break;
+ }
+ if (scale != 1) size.remove_suffix(1);
+ return std::stoul(std::string {size}) * scale;
+}
+
+static std::vector<std::size_t> parseSizes(std::string_view sizes) {
+ std::vector<std::size_t> out;
+ while (!sizes.empty()) {
+  std::size_t comma {sizes.find(',')};
+  out.push_back(parseSize(sizes.substr(0, comma)));
+  sizes.remove_prefix(comma == sizes.npos ? sizes.size() : comma + 1);
+ }
+ return out;
+}
+
+int main(int argc, char **argv) {
+ std::vector<std::size_t> const sizes {
+   parseSizes((argc > 1) ? argv[1] : "64K,4M")};
+ std::uint64_t const seed {(argc > 2) ? std::stoull(argv[2]) : 1};
+ std::size_t const   iterations {(argc > 3) ? std::stoul(argv[3]) : 3};
+ char const         *outDir {(argc > 4) ? argv[4] : nullptr};
+
+ for (std::size_t size : sizes) {
+  for (bench::Mix mix : bench::MIXES) {
+   std::string corpus {bench::CorpusGenerator {seed}.generate(mix, size)};
+
+   FileManager   fileMgr;
+   SourceManager srcMgr;
+   SourceInfo   *srcInfo {nullptr};
+   if (outDir) {
+    std::filesystem::path path {std::filesystem::path {outDir} /
+                                (std::string {bench::mixToString(mix)} + "-" +
+                                 std::to_string(size) + ".psh")};
+    std::ofstream {path, std::ios::binary} << corpus;
+    auto eFileInfo {fileMgr.readFile(path)};
+    if (!eFileInfo) {
+     std::cerr << eFileInfo.takeError<BasicError>().userFriendlyMessage()
+               << '\n';
+     return 1;
+    }
+    srcInfo = srcMgr.addFile(*eFileInfo);
+   } else
+    srcInfo = srcMgr.addShellInput(corpus);
+
+   std::size_t tokenCount {0}, allocCount {0}, allocBytes {0};
+   double      seconds {0};
+
+   for (std::size_t i = 0; i < iterations; ++i) {
+    DiagnosticsManager diagMgr;
+    IdTable            idTable;
+
+    std::size_t allocCountBegin {gAllocCount}, allocBytesBegin {gAllocBytes};
+    auto        begin {std::chrono::steady_clock::now()};
+    auto        tokBuf {lex(srcInfo, idTable, diagMgr)};
+    auto        end {std::chrono::steady_clock::now()};
+    allocCount += gAllocCount - allocCountBegin;
+    allocBytes += gAllocBytes - allocBytesBegin;
+
+    if (diagMgr.dump()) return 1;
+
+    tokenCount += tokBuf.size();
+    seconds += std::chrono::duration<double> {end - begin}.count();
+   }
+
+   double const bytes {static_cast<double>(corpus.size() * iterations)};
+   double const tokens {static_cast<double>(tokenCount)};
+
+   std::cout << "{\"corpus\": \"" << bench::mixToString(mix)
+             << "\", \"bytes\": " << corpus.size()
+             << ", \"seed\": " << seed
+             << ", \"tokens\": " << tokenCount / iterations
+             << ", \"mb_per_s\": " << bytes / seconds / 1e6
+             << ", \"tokens_per_s\": " << tokens / seconds
+             << ", \"alloc_bytes_per_token\": " << allocBytes / tokens
+             << ", \"allocs\": " << allocCount / iterations << "}\n";
+  }
+ }
+}
@@ -1,7 +1,9 @@
 // SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <algorithm>
 #include <cassert>
+#include <tuple>
 
 #include "basic/DiagnosticsManager.h"
 
@@ -15,71 +17,101 @@ std::string Diagnostic::levelToString(Level level) {
    return "warning";
   case Diagnostic::ERROR:
    return "error";
+  default:
+   assert(!"Unhandled level");
  }
 }
 
 void DiagnosticsManager::display() const {
+ // Rendered diagnostic along with its sort key.
+ struct Entry {
+  // Order in which the diagnostic's source entity was first encountered.
+  std::size_t sourceIndex;
+  // Region of the diagnostic within its source entity, if any.
+  std::uint32_t beginOffset, endOffset;
+  // Should the diagnostic be written to stderr?
+  bool        err;
+  std::string rendered;
+ };
+
+ std::vector<SourceInfo *> srcInfos;
+ std::vector<Entry>        entries;
+ entries.reserve(mDiagnostics.size());
+
+ // The document is reused between diagnostics to keep its storage.
+ Doc d;
  for (auto &diag : mDiagnostics) {
-  Diagnostic::Level level {diag->level()};
-  std::ostream     *out {nullptr};
-
-  switch (level) {
-   case Diagnostic::WARNING:
-   case Diagnostic::ERROR:
-    out = &std::cerr;
-    break;
-   default:
-    out = &std::cout;
-    break;
-  }
-
-  {
-   using namespace doc;
-
-   Docs d;
-
-   d += text(Diagnostic::levelToString(level));
-
-   if (SourceInfo *srcInfo = diag->sourceInfo()) {
-    d += hpad() + lparen;
-
-    if (srcInfo->is<SourceInfo::File>())
-     d += text(srcInfo->get<SourceInfo::File>().fileInfo->filePath().string());
-    else if (srcInfo->is<SourceInfo::Shell>())
-     d += text("shell");
-    else if (srcInfo->is<SourceInfo::StdIn>())
-     d += text("stdin");
-    else
-     assert(!"Unhandled kind");
-
-    if (auto region = diag->sourceRegion())
-     d += colon + integer(region->beginLoc().line + 1) + colon +
-          integer(region->beginLoc().column + 1);
+  using namespace doc;
 
-    d += rparen;
+  Diagnostic::Level level {diag->level()};
+  SourceInfo       *srcInfo {diag->sourceInfo()};
+  Entry             entry {0, 0, 0, level >= Diagnostic::WARNING, {}};
+  std::string       levelString {Diagnostic::levelToString(level)};
+
+  d.clear();
+  d += text(levelString);
+
+  if (srcInfo) {
+   auto srcIt {std::find(srcInfos.begin(), srcInfos.end(), srcInfo)};
+   entry.sourceIndex = (srcIt - srcInfos.begin()) + 1;
+   if (srcIt == srcInfos.end()) srcInfos.push_back(srcInfo);
+
+   d += hpad() + lparen;
+
+   if (srcInfo->is<SourceInfo::File>())
+    d += text(srcInfo->get<SourceInfo::File>().fileInfo->filePath().string());
+   else if (srcInfo->is<SourceInfo::Shell>())
+    d += text("shell");
+   else if (srcInfo->is<SourceInfo::StdIn>())
+    d += text("stdin");
+   else
+    assert(!"Unhandled kind");
+
+   if (auto region = diag->sourceRegion()) {
+    SourceLoc loc {srcInfo->loc(region->beginOffset())};
+    d += colon + integer(loc.line + 1) + colon + integer(loc.column + 1);
+    entry.beginOffset = region->beginOffset();
+    entry.endOffset   = region->endOffset();
    }
 
-   d += colon + hpad() + diag->doc();
-
-   d.display(defaultDocStyle, *out);
+   d += rparen;
   }
+
+  d += colon + hpad() + diag->doc();
+
+  d.render(defaultDocStyle, entry.rendered);
+  entry.rendered += '\n';
+  entries.push_back(std::move(entry));
  }
+
+ // Diagnostics without a source entity come first, followed by those of each
+ // source entity in the order they were encountered.
+ auto key = [](Entry const &e) {
+  return std::tie(e.sourceIndex, e.beginOffset, e.endOffset);
+ };
+ std::stable_sort(
+   entries.begin(), entries.end(),
+   [&](Entry const &a, Entry const &b) { return key(a) < key(b); });
+ entries.erase(std::unique(entries.begin(), entries.end(),
+                           [&](Entry const &a, Entry const &b) {
+                            return key(a) == key(b) && a.err == b.err &&
+                                   a.rendered == b.rendered;
+                           }),
+               entries.end());
+
+ DocWriter out {1}, err {2};
+ for (auto &entry : entries) (entry.err ? err : out).write(entry.rendered);
 }
 
 DiagnosticsManager::DiagnosticsManager(std::size_t errorLimit)
   : mErrorLimit {errorLimit} {}
 
-bool DiagnosticsManager::errorLimitReached() const {
- std::size_t count {0};
- for (auto &diag : mDiagnostics)
-  if (diag->level() >= Diagnostic::ERROR) ++count;
- return count >= mErrorLimit;
-}
-
 bool DiagnosticsManager::dump() {
- bool bad {errorLimitReached()};
+ std::lock_guard guard {mMutex};
+ bool            bad {errorLimitReached()};
  display();
  mDiagnostics.clear();
+ for (auto &count : mLevelCounts) count = 0;
  return bad;
 }
 
@@ -6,8 +6,11 @@
 #ifndef PLUSH_BASIC_DIAGNOSTICSMANAGER_H
 #define PLUSH_BASIC_DIAGNOSTICSMANAGER_H
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <type_traits>
@@ -29,9 +32,14 @@ public:
   // Cautious diagnostic.
   WARNING,
   // Fatal diagnostic.
-  ERROR
+  ERROR,
+  // Total number of every level.
+  _SIZE
  };
 
+ // Total number of every level.
+ constexpr static std::size_t LEVEL_SIZE {_SIZE};
+
  // Converts a Level to its string representation.
  static std::string levelToString(Level level);
 
@@ -45,16 +53,23 @@ public:
  virtual Doc doc() const = 0;
 };
 
-// Manages diagnostics and displaying them to the user.
+// Manages diagnostics and displaying them to the user. Diagnostics may be
+// added from multiple threads at once.
 class DiagnosticsManager {
  // Maximum error limit. Compiler termination is recommended upon reaching this
  // number.
  std::size_t const mErrorLimit;
 
+ // Guards mDiagnostics.
+ std::mutex mMutex;
  // Contains every added Diagnostic derivative.
  std::vector<Diagnostic::UPtr> mDiagnostics;
+ // Number of added diagnostics of each level.
+ std::array<std::atomic<std::size_t>, Diagnostic::LEVEL_SIZE> mLevelCounts {};
 
- // Displays each added diagnostic.
+ // Displays each added diagnostic, sorted by source location and without
+ // duplicates. Output of each stream is rendered into one buffer and written
+ // straight to its file descriptor.
  void display() const;
 
 public:
@@ -68,12 +83,25 @@ public:
  template <class Derived, typename = std::enable_if_t<std::is_base_of_v<
                             Diagnostic, std::decay_t<Derived>>>>
  void add(Derived &&derived) {
-  mDiagnostics.push_back(
-    std::make_unique<std::decay_t<Derived>>(std::forward<Derived>(derived)));
+  auto diag {
+    std::make_unique<std::decay_t<Derived>>(std::forward<Derived>(derived))};
+  Diagnostic::Level level {diag->level()};
+  {
+   std::lock_guard guard {mMutex};
+   mDiagnostics.push_back(std::move(diag));
+  }
+  ++mLevelCounts[level];
+ }
+
+ // Number of added diagnostics of the provided level.
+ std::size_t count(Diagnostic::Level level) const {
+  return mLevelCounts[level];
  }
 
  // Checks if the error limit was reached.
- bool errorLimitReached() const;
+ bool errorLimitReached() const {
+  return mLevelCounts[Diagnostic::ERROR] >= mErrorLimit;
+ }
 
  // Displays and clears every stored diagnostic. Returns true if the error limit
  // was reached.
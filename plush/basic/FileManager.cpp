@@ -1,50 +1,64 @@
 // SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <cerrno>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
 #include "basic/FileManager.h"
+#include "bits/platform.h"
+
+#ifdef PLUSH_POSIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace plush {
 
-FileInfo::FileInfo(std::filesystem::path &&filePath, std::string &&fileContent,
+FileInfo::FileInfo(std::filesystem::path &&filePath, Content &&fileContent,
                    FileManager &fileManagerRef)
   : mFilePath {std::move(filePath)}, mFileContent {std::move(fileContent)},
     mFileManagerRef {fileManagerRef} {}
 
-FileManager::FileManager() {}
-
-FileManager::~FileManager() {
- for (auto fileInfo : mFiles) delete fileInfo;
+std::string_view FileInfo::fileContent() const {
+ if (auto mappedFile = std::get_if<MappedFile>(&mFileContent))
+  return mappedFile->content();
+ else
+  return *std::get_if<std::string>(&mFileContent);
 }
 
+FileManager::FileManager(std::size_t mapThreshold)
+  : mMapThreshold {mapThreshold} {}
+
 void FileManager::addLookupDir(std::filesystem::path const &dirPath) {
  mLookupDirs.push_back(dirPath);
 }
 
-[[nodiscard]] Expect<FileInfo *> FileManager::readFile(
-  std::filesystem::path const &inFilePath) {
- std::filesystem::path filePath {inFilePath};
+std::optional<std::filesystem::path> FileManager::findFile(
+  std::filesystem::path const &filePath) const {
+ std::error_code ec;
+ if (std::filesystem::exists(filePath, ec)) return filePath;
 
  // If the provided file path does not exist, attempt to find a path that does
  // exist within mLookupDirs.
- if (!std::filesystem::exists(filePath))
-  for (auto &lookupDir : mLookupDirs) {
-   auto fullPath = lookupDir / filePath;
-   if (std::filesystem::exists(fullPath)) {
-    filePath = std::move(fullPath);
-    break;
-   }
-  }
+ for (auto &lookupDir : mLookupDirs) {
+  auto fullPath = lookupDir / filePath;
+  if (std::filesystem::exists(fullPath, ec)) return fullPath;
+ }
+ return std::nullopt;
+}
 
- if (!std::filesystem::exists(filePath)) {
+[[nodiscard]] Expect<FileInfo *> FileManager::readFile(
+  std::filesystem::path const &inFilePath) {
+ auto optFilePath {findFile(inFilePath)};
+ if (!optFilePath) {
   // No file could be found, return an error with the attempted paths.
-  std::vector<std::filesystem::path> triedPaths {filePath};
+  std::vector<std::filesystem::path> triedPaths {inFilePath};
   for (auto &lookupDir : mLookupDirs)
-   triedPaths.push_back(lookupDir / filePath);
+   triedPaths.push_back(lookupDir / inFilePath);
 
   std::ostringstream oss;
   oss << "Couldn't open file, attempted paths: ";
@@ -53,18 +67,61 @@ void FileManager::addLookupDir(std::filesystem::path const &dirPath) {
   return BasicError {oss.str()};
  }
 
+ std::filesystem::path filePath {std::move(*optFilePath)};
+ FileInfo::Content     content;
+
+#ifdef PLUSH_POSIX
+ int fd {::open(filePath.c_str(), O_RDONLY | O_CLOEXEC)};
+ if (fd < 0)
+  // The file exists but is unable to be read.
+  return BasicError {std::strerror(errno)};
+
+ struct stat st;
+ bool const  isRegular {0 == ::fstat(fd, &st) && S_ISREG(st.st_mode)};
+ std::size_t size {isRegular ? static_cast<std::size_t>(st.st_size) : 0};
+
+ // Map large regular files, falling back to copying if mapping fails.
+ if (isRegular && size >= mMapThreshold)
+  if (auto eMappedFile = MappedFile::map(fd, size))
+   content = std::move(*eMappedFile);
+
+ if (auto string = std::get_if<std::string>(&content)) {
+  // Read until the end of file, as the size of pipes and special files isn't
+  // known upfront.
+  string->resize(isRegular ? size + 1 : 64 * 1024);
+  std::size_t length {0};
+  for (;;) {
+   if (length == string->size()) string->resize(string->size() * 2);
+   ::ssize_t count {
+     ::read(fd, string->data() + length, string->size() - length)};
+   if (count < 0 && EINTR == errno) continue;
+   if (count < 0) {
+    int error {errno};
+    ::close(fd);
+    return BasicError {std::strerror(error)};
+   }
+   if (!count) break;
+   length += count;
+  }
+  string->resize(length);
+ }
+
+ ::close(fd);
+#else
  std::ifstream ifs {filePath, std::ios::binary};
  if (!ifs)
   // The file exists but is unable to be read.
   return BasicError {std::strerror(errno)};
 
- // Read the file at the path and construct a new FileInfo.
  std::ostringstream oss;
  oss << ifs.rdbuf();
- FileInfo *newFile {new FileInfo {std::move(filePath), oss.str(), *this}};
+ content = oss.str();
+#endif
 
- mFiles.push_back(newFile);
- return newFile;
+ // Construct a new FileInfo with the read content.
+ std::lock_guard guard {mMutex};
+ return mArena.make<FileInfo>(
+   FileInfo {std::move(filePath), std::move(content), *this});
 }
 
 } // namespace plush
@@ -7,10 +7,16 @@
 #define PLUSH_BASIC_FILEMANAGER_H
 
 #include <filesystem>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <variant>
 #include <vector>
 
+#include "bits/Arena.h"
 #include "bits/Expect.h"
+#include "bits/MappedFile.h"
 
 namespace plush {
 
@@ -20,41 +26,66 @@ class FileManager;
 class FileInfo final {
  friend class FileManager;
 
+public:
+ // Content of a file, either copied into memory or mapped read-only.
+ using Content = std::variant<std::string, MappedFile>;
+
+private:
  std::filesystem::path mFilePath;
- std::string           mFileContent;
+ Content               mFileContent;
  // Reference to the parent FileManager.
  [[maybe_unused]] FileManager &mFileManagerRef;
 
- FileInfo(std::filesystem::path &&filePath, std::string &&fileContent,
+ FileInfo(std::filesystem::path &&filePath, Content &&fileContent,
           FileManager &fileManagerRef);
 
 public:
  constexpr std::filesystem::path const &filePath() const { return mFilePath; }
- constexpr std::string const &fileContent() const { return mFileContent; }
+ std::string_view                       fileContent() const;
+ // Is the file's content mapped rather than copied?
+ constexpr bool isMapped() const {
+  return std::holds_alternative<MappedFile>(mFileContent);
+ }
 };
 
 // Manages reading files from the filesystem relative to the execution path or
 // from added lookup directories.
 class FileManager final {
+public:
+ // Default minimum size of a regular file to be mapped rather than copied.
+ constexpr static std::size_t DEFAULT_MAP_THRESHOLD {64 * 1024};
+
+private:
+ // Minimum size of a regular file to be mapped rather than copied. Smaller
+ // files are cheaper to copy than to map.
+ std::size_t const mMapThreshold;
  // Directories to look through when reading files.
  std::vector<std::filesystem::path> mLookupDirs;
- // Every opened file.
- std::vector<FileInfo *> mFiles;
+ // Guards mArena, files may be read from multiple threads at once.
+ std::mutex mMutex;
+ // Storage of every opened file.
+ Arena mArena;
 
 public:
- FileManager();
+ FileManager(std::size_t mapThreshold = DEFAULT_MAP_THRESHOLD);
  // Forbid copying and/or moving to avoid invalidating FileInfo pointers or
  // FileManager references when destructing/moving.
  FileManager(FileManager &&)                 = delete;
  FileManager(FileManager const &)            = delete;
  FileManager &operator=(FileManager &&)      = delete;
  FileManager &operator=(FileManager const &) = delete;
- ~FileManager();
 
- // Add a directory to look through when reading a file.
+ // Add a directory to look through when reading a file. Lookup directories
+ // must be added before reading files from multiple threads.
  void addLookupDir(std::filesystem::path const &dirPath);
+ // Finds the path a file would be read from, either the provided path or one
+ // of the added lookup directories joined with it.
+ std::optional<std::filesystem::path> findFile(
+   std::filesystem::path const &filePath) const;
  // Attempts to read a file at the provided path or with one of the added lookup
- // directories.
+ // directories. Regular files of at least the map threshold are mapped
+ // read-only, other files (pipes, special files) are copied into memory. Safe
+ // to call from multiple threads at once.
  [[nodiscard]] Expect<FileInfo *> readFile(
    std::filesystem::path const &inFilePath);
 };
@@ -2,60 +2,111 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <cassert>
+#include <type_traits>
 
 #include "basic/IdTable.h"
 #include "bits/hash.h"
 
 namespace plush {
 
-IdInfo::IdInfo(std::string                            &&stringRep,
+IdInfo::IdInfo(std::string_view                         stringRep,
                std::optional<enum token::Keyword::Kind> optKeywordKind,
                IdTable                                 &idTableRef)
-  : mStringRep {std::move(stringRep)}, mOptKeywordKind {optKeywordKind},
-    mIdTableRef {idTableRef} {}
+  : mStringRep {stringRep}, mOptKeywordKind {optKeywordKind},
+    mIndex {0}, mIdTableRef {idTableRef} {}
 
-IdInfo *IdTable::add(IdInfo &&idInfo, std::size_t idHash) {
- IdInfo *newIdInfo {new IdInfo {std::move(idInfo)}};
- mHashes.push_back(idHash);
- mEntries.push_back(newIdInfo);
- return newIdInfo;
+void IdTable::insertSlot(Shard &shard, std::uint32_t index) {
+ std::size_t mask {shard.slotTags.size() - 1};
+ std::size_t slot {shard.hashes[index] & mask};
+ while (shard.slotTags[slot]) slot = (slot + 1) & mask;
+ shard.slotTags[slot]    = slotTag(shard.hashes[index]);
+ shard.slotEntries[slot] = index;
+}
+
+void IdTable::growSlots(Shard &shard) {
+ std::size_t size {shard.slotTags.empty() ? MIN_SLOT_SIZE
+                                          : shard.slotTags.size() * 2};
+ shard.slotTags.assign(size, 0);
+ shard.slotEntries.assign(size, 0);
+ for (std::uint32_t i = 0; i < shard.size; ++i) insertSlot(shard, i);
 }
 
-IdInfo *IdTable::add(IdInfo &&idInfo) {
- std::size_t idHash = hash::fnv1a(idInfo.stringRep());
- return add(std::move(idInfo), idHash);
+IdInfo *IdTable::add(Shard &shard, IdInfo &&idInfo, std::size_t idHash) {
+ // Keep the load factor at or below 7/8.
+ if ((shard.size + 1) * 8 > shard.slotTags.size() * 7) growSlots(shard);
+
+ std::uint32_t localIndex = shard.size;
+ assert(localIndex < (UINT32_MAX >> SHARD_BITS) && "Too many identifiers");
+
+ IdInfo *newIdInfo {shard.arena.make<IdInfo>(std::move(idInfo))};
+ newIdInfo->mIndex = (localIndex << SHARD_BITS) | (&shard - mShards.data());
+ shard.hashes.push_back(idHash);
+
+ auto [chunk, offset] = locate(localIndex);
+ IdInfo **entries {shard.chunks[chunk].load(std::memory_order_relaxed)};
+ if (!entries) {
+  std::size_t const size {std::size_t {1} << (chunk + MIN_CHUNK_BITS)};
+  entries = static_cast<IdInfo **>(
+    shard.arena.allocate(size * sizeof(IdInfo *), alignof(IdInfo *)));
+ }
+ entries[offset] = newIdInfo;
+ shard.chunks[chunk].store(entries, std::memory_order_release);
+ ++shard.size;
+ insertSlot(shard, localIndex);
+ return newIdInfo;
 }
 
 void IdTable::addKeywords() {
- for (auto &kw : token::KEYWORDS)
-  add({std::string {kw.stringRep()}, {kw.kind()}, *this});
+ for (auto &kw : token::KEYWORDS) {
+  std::size_t kwHash = hash::fnv1a(kw.stringRep());
+  Shard      &shard {mShards[shardOf(kwHash)]};
+  add(shard, {kw.stringRep(), {kw.kind()}, *this}, kwHash);
+ }
 }
 
-IdTable::IdTable() { addKeywords(); }
+IdTable::IdTable(bool concurrent) : IdTable {EmptyTag {}, concurrent} {
+ addKeywords();
+}
+
+IdTable::IdTable(EmptyTag, bool concurrent) : mConcurrent {concurrent} {
+ static_assert(std::is_trivially_destructible_v<IdInfo>,
+               "IdInfo shouldn't require finalizing within an arena");
+}
 
-IdTable::~IdTable() {
- for (auto entryIdInfo : mEntries) delete entryIdInfo;
+IdInfo *IdTable::restore(std::string_view                         stringRep,
+                         std::optional<enum token::Keyword::Kind> optKeywordKind,
+                         std::size_t                              idHash) {
+ Shard &shard {mShards[shardOf(idHash)]};
+ auto   guard {lock(shard)};
+ return add(shard, {stringRep, optKeywordKind, *this}, idHash);
 }
 
 [[nodiscard]] IdInfo *IdTable::get(std::string_view id) {
- assert(mHashes.size() == mEntries.size() &&
-        "mHashes and mEntries should be the same length");
+ std::size_t  idHash = hash::fnv1a(id);
+ std::uint8_t tag {slotTag(idHash)};
+ Shard       &shard {mShards[shardOf(idHash)]};
+ auto         guard {lock(shard)};
 
- std::size_t idHash = hash::fnv1a(id);
+ assert(shard.hashes.size() == shard.size &&
+        "hashes and entries should be the same length");
 
- // Attempt to find a hash that matches the provided string's hash.
- for (std::size_t i = 0; i < mHashes.size(); ++i) {
-  std::size_t entryHash = mHashes[i];
+ // Probe from the hash's slot until an empty slot is reached. Only compare
+ // full hashes and strings of entries whose tag matches.
+ if (!shard.slotTags.empty()) {
+  std::size_t mask {shard.slotTags.size() - 1};
+  for (std::size_t slot = idHash & mask; shard.slotTags[slot];
+       slot = (slot + 1) & mask) {
+   if (tag != shard.slotTags[slot]) continue;
 
-  // If there's a match, compare the strings to avoid collisions.
-  if (idHash == entryHash) {
-   IdInfo *entryIdInfo = mEntries[i];
-   if (id == entryIdInfo->stringRep()) return entryIdInfo;
+   std::uint32_t index {shard.slotEntries[slot]};
+   if (idHash != shard.hashes[index]) continue;
+   IdInfo *idInfo {entry(shard, index)};
+   if (id == idInfo->stringRep()) return idInfo;
   }
  }
 
  // No identifier was found, create a new one.
- return add({std::string {id}, std::nullopt, *this}, idHash);
+ return add(shard, {shard.arena.copy(id), std::nullopt, *this}, idHash);
 }
 
 } // namespace plush
@@ -6,13 +6,21 @@
 #ifndef PLUSH_BASIC_IDTABLE_H
 #define PLUSH_BASIC_IDTABLE_H
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "basic/IdTable.fwd.h"
 #include "basic/TokenKinds.h"
+#include "bits/Arena.h"
 
 namespace plush {
 
@@ -20,19 +28,23 @@ namespace plush {
 class IdInfo final {
  friend class IdTable;
 
- // String representation of the identifier.
- std::string mStringRep;
+ // String representation of the identifier, stored within the parent
+ // IdTable's arena.
+ std::string_view mStringRep;
  // Is the identifier a keyword?
  std::optional<enum token::Keyword::Kind> mOptKeywordKind;
+ // Index of the identifier within the parent IdTable.
+ std::uint32_t mIndex;
  // Reference to the parent IdTable.
  [[maybe_unused]] IdTable &mIdTableRef;
 
- IdInfo(std::string                            &&stringRep,
+ IdInfo(std::string_view                         stringRep,
         std::optional<enum token::Keyword::Kind> optKeywordKind,
         IdTable                                 &idTableRef);
 
 public:
  constexpr std::string_view stringRep() const { return mStringRep; }
+ constexpr std::uint32_t    index() const { return mIndex; }
  // Retrieves the identifier's keyword kind. Fails if the identifier is not a
  // keyword.
  constexpr enum token::Keyword::Kind keywordKind() const {
@@ -46,42 +58,138 @@ public:
 };
 
 // A string interner with additional information associated with identifiers to
-// easily allow comparisons between other identifiers and keywords.
+// easily allow comparisons between other identifiers and keywords. Identifiers
+// are partitioned into shards by hash; a concurrent IdTable guards each shard
+// with its own mutex so it can be shared between threads. Identifiers are
+// never moved once added, so retrieving one by index never locks.
 class IdTable final {
  // NOTE(m4xine): CXX17 doesn't allow heterogenous lookup for unordered
- // containers (std::unordered_map), hence the rudimentary string map
- // implementation.
-
- // Every hash of each IdInfo entry, with the indices matching the associated
- // entry within mEntries.
- std::vector<std::size_t> mHashes;
- // Every identifier, individually allocated to avoid pointer invalidation.
- std::vector<IdInfo *> mEntries;
-
- // Allocate and add a new IdInfo entry and its associated hash. Returns a
- // pointer to the newly allocated IdInfo.
- IdInfo *add(IdInfo &&idInfo, std::size_t hash);
- // Allocate and add a new IdInfo entry and its associated hash. Returns a
- // pointer to the newly allocated IdInfo.
- IdInfo *add(IdInfo &&idInfo);
+ // containers (std::unordered_map), hence the custom open addressing string
+ // map implementation.
+
+ // Number of bits of an IdInfo index selecting its shard.
+ constexpr static std::size_t SHARD_BITS {4};
+ // Number of shards.
+ constexpr static std::size_t SHARD_SIZE {1 << SHARD_BITS};
+ // Initial number of slots within a shard's open addressing index.
+ constexpr static std::size_t MIN_SLOT_SIZE {64};
+ // Number of bits of the entry index within a shard's first chunk.
+ constexpr static std::size_t MIN_CHUNK_BITS {6};
+ // Number of chunks of a shard, enough for every index within the shard.
+ constexpr static std::size_t CHUNK_SIZE {32 - SHARD_BITS - MIN_CHUNK_BITS + 1};
+
+ // Partition of the identifiers.
+ struct Shard {
+  // Guards the shard if the IdTable is concurrent.
+  mutable std::mutex mutex;
+  // Every hash of each IdInfo entry, with the indices matching the associated
+  // entry within chunks.
+  std::vector<std::size_t> hashes;
+  // Number of identifiers within the shard.
+  std::uint32_t size {0};
+  // Every identifier, allocated within arena to avoid pointer invalidation.
+  // Pointers to them are stored within chunks doubling in size, allocated once
+  // and never reallocated, so reading an entry while another thread adds one
+  // needs no lock.
+  std::array<std::atomic<IdInfo **>, CHUNK_SIZE> chunks {};
+  // Storage of every IdInfo and identifier string.
+  Arena arena;
+
+  // Open addressing index over entries with linear probing and a power of two
+  // number of slots. slotTags holds a tag per slot, 0 if the slot is empty and
+  // otherwise the high bits of the entry's hash, checked before touching the
+  // entry itself. slotEntries holds the index of each slot's entry.
+  std::vector<std::uint8_t>  slotTags;
+  std::vector<std::uint32_t> slotEntries;
+ };
+
+ // Should shards be locked upon access?
+ bool const mConcurrent;
+ std::array<Shard, SHARD_SIZE> mShards;
+
+ // Computes the non-zero slot tag of a hash.
+ constexpr static std::uint8_t slotTag(std::size_t hash) {
+  return 0x80 | (hash >> (sizeof(std::size_t) * 8 - 7));
+ }
+ // Selects the shard of a hash, using bits used by neither slots nor tags.
+ constexpr static std::size_t shardOf(std::size_t hash) {
+  return (hash >> (sizeof(std::size_t) * 8 - 7 - SHARD_BITS)) &
+         (SHARD_SIZE - 1);
+ }
 
- // Add every Plush keyword.
- void addKeywords();
+ // Locks the shard if the IdTable is concurrent.
+ std::unique_lock<std::mutex> lock(Shard const &shard) const {
+  return mConcurrent ? std::unique_lock {shard.mutex}
+                     : std::unique_lock<std::mutex> {};
+ }
+
+ // Locates the chunk holding a shard's entry index and the entry within it.
+ constexpr static std::pair<std::size_t, std::size_t>
+ locate(std::uint32_t index) {
+  std::uint32_t const biased {index + (std::uint32_t {1} << MIN_CHUNK_BITS)};
+  std::size_t const   chunk = std::bit_width(biased) - 1 - MIN_CHUNK_BITS;
+  return {chunk, biased - (std::uint32_t {1} << (chunk + MIN_CHUNK_BITS))};
+ }
+ // Retrieves a shard's entry.
+ static IdInfo *entry(Shard const &shard, std::uint32_t index) {
+  auto [chunk, offset] = locate(index);
+  return shard.chunks[chunk].load(std::memory_order_acquire)[offset];
+ }
+
+ // Inserts the shard's entry at the provided index into its open addressing
+ // index.
+ static void insertSlot(Shard &shard, std::uint32_t index);
+ // Doubles the number of slots of a shard and reinserts every entry.
+ static void growSlots(Shard &shard);
+
+ // Allocate and add a new IdInfo entry and its associated hash to its shard,
+ // which must be locked. Returns a pointer to the newly allocated IdInfo.
+ IdInfo *add(Shard &shard, IdInfo &&idInfo, std::size_t hash);
 
 public:
- // Construct an IdTable with every Plush keyword.
- IdTable();
+ // Tag constructing an IdTable without any identifier, not even keywords.
+ struct EmptyTag {};
+
+ // Construct an IdTable with every Plush keyword. A concurrent IdTable may be
+ // accessed from multiple threads at once.
+ explicit IdTable(bool concurrent = false);
+ // Construct an IdTable without any identifier, to be filled by addKeywords
+ // or restore.
+ IdTable(EmptyTag, bool concurrent = false);
  // Forbid copying and/or moving to avoid invalidating IdInfo and IdTable
  // pointers/references when moving/destructing.
  IdTable(IdTable &&)                 = delete;
  IdTable(IdTable const &)            = delete;
  IdTable &operator=(IdTable &&)      = delete;
  IdTable &operator=(IdTable const &) = delete;
- ~IdTable();
+
+ constexpr bool concurrent() const { return mConcurrent; }
+
+ // Add every Plush keyword.
+ void addKeywords();
+ // Add an identifier missing from the IdTable along with its precomputed
+ // hash. Its string isn't copied and must outlive the IdTable.
+ IdInfo *restore(std::string_view                         stringRep,
+                 std::optional<enum token::Keyword::Kind> optKeywordKind,
+                 std::size_t                              hash);
+ // Calls f(idInfo, hash) for every identifier, shard by shard in insertion
+ // order. Restoring them in that order reproduces their indices.
+ template <class F>
+ void forEach(F &&f) const {
+  for (Shard const &shard : mShards) {
+   auto guard {lock(shard)};
+   for (std::uint32_t i = 0; i < shard.size; ++i)
+    f(static_cast<IdInfo const &>(*entry(shard, i)), shard.hashes[i]);
+  }
+ }
 
  // Lookup an identifier with the provided string. If no identifier exists, a
  // new one will be created.
  [[nodiscard]] IdInfo *get(std::string_view id);
+ // Retrieves the identifier with the provided index.
+ IdInfo *at(std::uint32_t index) const {
+  return entry(mShards[index & (SHARD_SIZE - 1)], index >> SHARD_BITS);
+ }
 };
 
 } // namespace plush
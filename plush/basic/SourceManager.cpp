@@ -1,20 +1,19 @@
 // SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <algorithm>
 #include <cassert>
+#include <type_traits>
 
 #include "basic/SourceManager.h"
+#include "bits/simd.h"
+#include "bits/utf8.h"
 
 namespace plush {
 
-SourceRegion::SourceRegion(SourceLoc &&beginLoc, SourceLoc &&endLoc)
-  : mBeginLoc {std::move(beginLoc)}, mEndLoc {std::move(endLoc)} {
- assert(mBeginLoc <= mEndLoc && "mBeginLoc > mEndLoc");
-}
-
-SourceRegion::SourceRegion(SourceLoc const &beginLoc, SourceLoc const &endLoc)
-  : mBeginLoc {beginLoc}, mEndLoc {endLoc} {
- assert(mBeginLoc <= mEndLoc && "mBeginLoc > mEndLoc");
+SourceRegion::SourceRegion(std::uint32_t beginOffset, std::uint32_t endOffset)
+  : mBeginOffset {beginOffset}, mEndOffset {endOffset} {
+ assert(mBeginOffset <= mEndOffset && "mBeginOffset > mEndOffset");
 }
 
 SourceRegionInfo::SourceRegionInfo(SourceRegion &&srcRegion,
@@ -36,6 +35,110 @@ std::string_view SourceInfo::sourceContent() const {
  assert(!"Unhandled variant");
 }
 
+std::uint32_t SourceInfo::validEnd(std::uint32_t offset) const {
+ auto it {std::partition_point(
+   mInvalidRegions.begin(), mInvalidRegions.end(),
+   [&](SourceRegion const &region) { return region.beginOffset() < offset; })};
+ return it == mInvalidRegions.end() ? sourceContent().size()
+                                    : it->beginOffset();
+}
+
+void SourceInfo::findInvalidRegions(std::uint32_t beginOffset,
+                                    std::uint32_t endOffset) {
+ std::string_view src {sourceContent()};
+ char const      *it {src.data() + beginOffset};
+ char const      *end {src.data() + endOffset};
+ while ((it = utf8::findInvalid(it, end)) != end) {
+  std::uint32_t offset = it - src.data();
+  it += utf8::invalidSize(it, end);
+  mInvalidRegions.emplace_back(offset, it - src.data());
+ }
+}
+
+void SourceInfo::applyEdit(SourceEdit const &edit) {
+ std::string *input {nullptr};
+ if (auto shell = std::get_if<Shell>(&mKind))
+  input = &shell->input;
+ else if (auto stdIn = std::get_if<StdIn>(&mKind))
+  input = &stdIn->input;
+ assert(input && "Only shell and stdin input can be edited");
+ assert(edit.offset + edit.length <= input->size() && "Edit out of bounds");
+
+ // Sequences never span a byte that isn't a continuation byte, so only the
+ // sequences between the nearest such unedited bytes around the edit need
+ // revalidating.
+ auto isContinuation = [&](std::uint32_t offset) {
+  return ((*input)[offset] & 0b11000000) == 0b10000000;
+ };
+ std::uint32_t beginOffset {edit.offset};
+ if (beginOffset)
+  do --beginOffset;
+  while (beginOffset && isContinuation(beginOffset));
+ std::uint32_t oldEndOffset {edit.offset + edit.length};
+ while (oldEndOffset < input->size() && isContinuation(oldEndOffset))
+  ++oldEndOffset;
+
+ input->replace(edit.offset, edit.length, edit.text.data(), edit.text.size());
+ // The line index is rebuilt upon the next call to loc.
+ mLineOffsets.clear();
+
+ std::uint32_t const delta = edit.text.size() - edit.length;
+ std::uint32_t const endOffset {oldEndOffset + delta};
+
+ // Keep the regions before the revalidated range and shift those after it.
+ std::vector<SourceRegion> tail;
+ auto                      keptEnd {std::partition_point(
+   mInvalidRegions.begin(), mInvalidRegions.end(),
+   [&](SourceRegion const &region) {
+    return region.beginOffset() < beginOffset;
+   })};
+ for (auto it = keptEnd; it != mInvalidRegions.end(); ++it)
+  if (it->beginOffset() >= oldEndOffset)
+   tail.emplace_back(it->beginOffset() + delta, it->endOffset() + delta);
+ mInvalidRegions.erase(keptEnd, mInvalidRegions.end());
+
+ findInvalidRegions(beginOffset, endOffset);
+ mInvalidRegions.insert(mInvalidRegions.end(), tail.begin(), tail.end());
+}
+
+void SourceInfo::buildLineIndex() const {
+ std::string_view src {sourceContent()};
+ char const      *begin {src.data()};
+ char const      *it {begin};
+ char const      *end {begin + src.size()};
+
+ mLineOffsets.push_back(0);
+
+#ifdef PLUSH_SIMD
+ // Collect line feeds a vector at a time, one mask bit per line feed.
+ for (; static_cast<std::size_t>(end - it) >= simd::VEC_SIZE;
+      it += simd::VEC_SIZE)
+  for (std::uint32_t m {simd::mask(simd::eq(simd::load(it), simd::splat('\n')))};
+       m; m &= m - 1)
+   mLineOffsets.push_back(it - begin + __builtin_ctz(m) + 1);
+#endif
+
+ for (; it != end; ++it)
+  if ('\n' == *it) mLineOffsets.push_back(it - begin + 1);
+}
+
+SourceLoc SourceInfo::loc(std::uint32_t offset) const {
+ std::string_view src {sourceContent()};
+ assert(offset <= src.size());
+
+ if (mLineOffsets.empty()) buildLineIndex();
+
+ auto lineIt {
+   std::upper_bound(mLineOffsets.begin(), mLineOffsets.end(), offset) - 1};
+
+ // Columns are counted in codepoints, skip over UTF-8 continuation bytes.
+ std::size_t column {0};
+ for (char c : src.substr(*lineIt, offset - *lineIt))
+  if ((static_cast<unsigned char>(c) & 0b11000000) != 0b10000000) ++column;
+
+ return {static_cast<std::size_t>(lineIt - mLineOffsets.begin()), column};
+}
+
 [[nodiscard]] SourceRegionInfo *SourceInfo::makeSourceRegionInfo(
   SourceRegion &&srcRegion) {
  return mSourceManagerRef.makeSourceRegionInfo(std::move(srcRegion), this);
@@ -60,17 +163,21 @@ SourceInfo::ConstIterator SourceInfo::cend() const {
 }
 
 [[nodiscard]] SourceInfo *SourceManager::addSourceInfo(SourceInfo &&srcInfo) {
- SourceInfo *newSrcInfo {new SourceInfo {std::move(srcInfo)}};
- mSources.push_back(newSrcInfo);
+ SourceInfo *newSrcInfo;
+ {
+  std::lock_guard guard {mMutex};
+  newSrcInfo = mArena.make<SourceInfo>(std::move(srcInfo));
+ }
+ newSrcInfo->findInvalidRegions(0, newSrcInfo->sourceContent().size());
  return newSrcInfo;
 }
 
 [[nodiscard]] SourceRegionInfo *SourceManager::addSourceRegionInfo(
   SourceRegionInfo &&srcRegionInfo) {
- SourceRegionInfo *newSrcRegionInfo {
-   new SourceRegionInfo {std::move(srcRegionInfo)}};
- mSourceRegions.push_back(newSrcRegionInfo);
- return newSrcRegionInfo;
+ static_assert(std::is_trivially_destructible_v<SourceRegionInfo>,
+               "SourceRegionInfo shouldn't require finalizing within mArena");
+ std::lock_guard guard {mMutex};
+ return mArena.make<SourceRegionInfo>(std::move(srcRegionInfo));
 }
 
 [[nodiscard]] SourceRegionInfo *SourceManager::makeSourceRegionInfo(
@@ -84,11 +191,6 @@ SourceInfo::ConstIterator SourceInfo::cend() const {
 
 SourceManager::SourceManager() {}
 
-SourceManager::~SourceManager() {
- for (auto srcInfo : mSources) delete srcInfo;
- for (auto srcRegionInfo : mSourceRegions) delete srcRegionInfo;
-}
-
 [[nodiscard]] SourceInfo *SourceManager::addFile(FileInfo *fileInfo) {
  return addSourceInfo({SourceInfo::File {fileInfo}, *this});
 }
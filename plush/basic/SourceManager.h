@@ -7,11 +7,14 @@
 #define PLUSH_BASIC_SOURCEMANAGER_H
 
 #include <cassert>
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <variant>
 #include <vector>
 
 #include "basic/FileManager.h"
+#include "bits/Arena.h"
 
 namespace plush {
 
@@ -47,17 +50,24 @@ struct SourceLoc {
  }
 };
 
-// Representation of a spanned region consisting of a beginning and ending
-// location within a source entity (file, shell input, stdin.)
+// Representation of a spanned region consisting of a beginning and ending byte
+// offset within a source entity (file, shell input, stdin.) Lines and columns
+// are computed on demand via SourceInfo::loc.
 class SourceRegion {
- SourceLoc mBeginLoc, mEndLoc;
+ std::uint32_t mBeginOffset, mEndOffset;
 
 public:
- SourceRegion(SourceLoc &&beginLoc, SourceLoc &&endLoc);
- SourceRegion(SourceLoc const &beginLoc, SourceLoc const &endLoc);
+ SourceRegion(std::uint32_t beginOffset, std::uint32_t endOffset);
 
- constexpr SourceLoc const &beginLoc() const { return mBeginLoc; }
- constexpr SourceLoc const &endLoc() const { return mEndLoc; }
+ constexpr std::uint32_t beginOffset() const { return mBeginOffset; }
+ constexpr std::uint32_t endOffset() const { return mEndOffset; }
+};
+
+// Replacement of the bytes within [offset, offset + length) of a source entity
+// with new text.
+struct SourceEdit {
+ std::uint32_t    offset, length;
+ std::string_view text;
 };
 
 // Extends SourceRegion with a pointer to the origin SourceInfo.
@@ -99,6 +109,16 @@ private:
  std::variant<File, Shell, StdIn> mKind;
  // Reference to the parent SourceManager.
  SourceManager &mSourceManagerRef;
+ // Byte offset of the beginning of each line, built on first use by loc.
+ mutable std::vector<std::uint32_t> mLineOffsets;
+ // Every ill-formed UTF-8 sequence within the source content, in order.
+ std::vector<SourceRegion> mInvalidRegions;
+
+ // Builds mLineOffsets from the source content.
+ void buildLineIndex() const;
+ // Appends every ill-formed UTF-8 sequence within [beginOffset, endOffset) of
+ // the source content to mInvalidRegions.
+ void findInvalidRegions(std::uint32_t beginOffset, std::uint32_t endOffset);
 
  constexpr SourceInfo(File &&file, SourceManager &srcMgrRef)
    : mKind {std::move(file)}, mSourceManagerRef {srcMgrRef} {}
@@ -123,6 +143,23 @@ public:
 
  std::string_view sourceContent() const;
 
+ // Every ill-formed UTF-8 sequence within the source content, validated once
+ // when the source entity is added.
+ constexpr std::vector<SourceRegion> const &invalidRegions() const {
+  return mInvalidRegions;
+ }
+ // Byte offset of the first ill-formed UTF-8 sequence at or after the provided
+ // offset, or the size of the source content if there is none.
+ std::uint32_t validEnd(std::uint32_t offset) const;
+
+ // Applies an edit to the source content, revalidating only the codepoints
+ // around it. Only shell and stdin input can be edited.
+ void applyEdit(SourceEdit const &edit);
+
+ // Computes the line and column of a byte offset within the source content.
+ // The line index is built upon the first call.
+ SourceLoc loc(std::uint32_t offset) const;
+
  // Create a SourceRegionInfo (managed by the parent SourceManager) with this
  // SourceInfo and the provided SourceRegion.
  [[nodiscard]] SourceRegionInfo *makeSourceRegionInfo(SourceRegion &&srcRegion);
@@ -141,12 +178,11 @@ public:
 class SourceManager final {
  friend class SourceInfo;
 
- // Contains each source entity, individually allocated to avoid pointer
- // invalidation.
- std::vector<SourceInfo *> mSources;
- // Contains each source region associated with a stored source entity,
- // individually allocated to avoid pointer invalidation.
- std::vector<SourceRegionInfo *> mSourceRegions;
+ // Guards mArena, source entities may be added from multiple threads at once.
+ std::mutex mMutex;
+ // Storage of each source entity and each source region associated with a
+ // stored source entity, avoiding pointer invalidation.
+ Arena mArena;
 
  // Add and allocate a new SourceInfo and store it. Returns a pointer
  // to the new allocation. Not to be used externally.
@@ -176,7 +212,6 @@ public:
  SourceManager(SourceManager const &)            = delete;
  SourceManager &operator=(SourceManager &&)      = delete;
  SourceManager &operator=(SourceManager const &) = delete;
- ~SourceManager();
 
  // Add a file as a source entity.
  [[nodiscard]] SourceInfo *addFile(FileInfo *fileInfo);
@@ -3,22 +3,41 @@
 
 namespace plush {
 
-Doc Token::doc() const {
+void TokenTables::compactStrings(std::vector<Token> &tokens) {
+ if (2 * mDroppedStrings <= mStrings.size()) return;
+
+ std::string                                          data;
+ std::vector<std::pair<std::uint32_t, std::uint32_t>> strings;
+ strings.reserve(mStrings.size() - mDroppedStrings);
+ for (Token &token : tokens) {
+  if (Token::STRING != token.kind() || Token::VERBATIM == token.payload())
+   continue;
+  std::string_view string {this->string(token.payload())};
+  strings.emplace_back(data.size(), string.size());
+  data += string;
+  token = {token.kind(), token.offset(), token.length(),
+           static_cast<std::uint32_t>(strings.size() - 1)};
+ }
+ mStringData     = std::move(data);
+ mStrings        = std::move(strings);
+ mDroppedStrings = 0;
+}
+
+Doc TokenView::doc() const {
  using namespace token;
  using namespace doc;
 
  if (is<Id>())
-  return text("Id") + colon + hpad() +
-         text(std::string {get<Id>().id()->stringRep()});
+  return text("Id") + colon + hpad() + text(get<Id>().id()->stringRep());
+ else if (is<Keyword>())
+  return text("Keyword") + colon + hpad() + text(get<Keyword>().stringRep());
  else if (is<Punctuator>())
   return text("Punctuator") + colon + hpad() +
-         text(std::string {get<Punctuator>().stringRep()});
+         text(get<Punctuator>().stringRep());
  else if (is<BinOp>())
-  return text("BinOp") + colon + hpad() +
-         text(std::string {get<BinOp>().stringRep()});
+  return text("BinOp") + colon + hpad() + text(get<BinOp>().stringRep());
  else if (is<String>())
-  return text("String") + colon + hpad() +
-         stringLit(std::string {get<String>().string()});
+  return text("String") + colon + hpad() + stringLit(get<String>().string());
 
  assert(!"Unhandled kind");
 }
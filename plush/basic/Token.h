@@ -7,44 +7,182 @@
 #define PLUSH_BASIC_TOKEN_H
 
 #include <cassert>
-#include <variant>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "basic/IdTable.h"
 #include "basic/SourceManager.h"
 #include "basic/TokenKinds.h"
 #include "bits/Doc.h"
 
 namespace plush {
 
-// Representation of a parsed token.
-class Token {
- // Source origin of this parsed token.
- SourceRegionInfo *mSourceRegionInfo;
- // Storage associated with the kind of this parsed token.
- std::variant<token::Id, token::Punctuator, token::BinOp, token::String> mKind;
-
+// Packed, trivially copyable representation of a parsed token. Payloads that
+// don't fit inline are stored within TokenTables and referred to by index.
+class Token final {
 public:
+ // Kind of a parsed token.
+ enum Kind : std::uint8_t {
+  // Identifier, payload is the IdTable index of its IdInfo.
+  ID,
+  // Keyword, payload is its token::Keyword::Kind.
+  KEYWORD,
+  // Punctuator, payload is its token::Punctuator::Kind.
+  PUNCTUATOR,
+  // Binary operator, payload is its token::BinOp::Kind.
+  BINOP,
+  // String literal, payload is its TokenTables string index or VERBATIM if
+  // the literal has no escape sequences.
+  STRING
+ };
+
+ // Payload of a string literal whose contents are its source text without the
+ // quotation marks.
+ constexpr static std::uint32_t VERBATIM {UINT32_MAX};
+
+private:
+ // Byte offset of the token within its source entity.
+ std::uint32_t mOffset;
+ // Size in bytes of the token within its source entity.
+ std::uint32_t mLength;
+ // Kind specific payload.
+ std::uint32_t mPayload;
+ // Kind of the token.
+ Kind mKind;
+
  template <class K>
- constexpr Token(SourceRegionInfo *srcRegionInfo, K &&kind)
-   : mSourceRegionInfo {srcRegionInfo}, mKind {std::forward<K>(kind)} {}
+ constexpr static Kind kindOf() {
+  if constexpr (std::is_same_v<K, token::Id>)
+   return ID;
+  else if constexpr (std::is_same_v<K, token::Keyword>)
+   return KEYWORD;
+  else if constexpr (std::is_same_v<K, token::Punctuator>)
+   return PUNCTUATOR;
+  else if constexpr (std::is_same_v<K, token::BinOp>)
+   return BINOP;
+  else {
+   static_assert(std::is_same_v<K, token::String>, "Unhandled kind");
+   return STRING;
+  }
+ }
 
- template <class Kind>
+public:
+ Token() = default;
+ constexpr Token(Kind kind, std::uint32_t offset, std::uint32_t length,
+                 std::uint32_t payload)
+   : mOffset {offset}, mLength {length}, mPayload {payload}, mKind {kind} {}
+
+ template <class K>
  constexpr bool is() const {
-  return std::holds_alternative<Kind>(mKind);
+  return mKind == kindOf<K>();
+ }
+
+ constexpr Kind          kind() const { return mKind; }
+ constexpr std::uint32_t offset() const { return mOffset; }
+ constexpr std::uint32_t length() const { return mLength; }
+ constexpr std::uint32_t payload() const { return mPayload; }
+};
+
+static_assert(sizeof(Token) <= 16 && std::is_trivially_copyable_v<Token>,
+              "Token should stay packed and trivially copyable");
+
+// Side tables holding the payloads of packed tokens that don't fit inline.
+class TokenTables final {
+ // Origin source entity.
+ SourceInfo *mSourceInfo;
+ // Table the payloads of identifier tokens index into.
+ IdTable *mIdTable;
+ // Decoded contents of every string literal with escape sequences, stored
+ // contiguously. Verbatim string literals refer to the source instead.
+ std::string mStringData;
+ // Offset and size of each decoded string literal within mStringData.
+ std::vector<std::pair<std::uint32_t, std::uint32_t>> mStrings;
+ // Number of decoded string literals no token refers to anymore, such as those
+ // of tokens replaced when re-lexing.
+ std::uint32_t mDroppedStrings {0};
+
+ constexpr std::uint32_t stringDataEnd() const {
+  return mStrings.empty() ? 0 : mStrings.back().first + mStrings.back().second;
+ }
+
+public:
+ TokenTables(SourceInfo *sourceInfo, IdTable &idTable)
+   : mSourceInfo {sourceInfo}, mIdTable {&idTable} {}
+
+ constexpr SourceInfo *sourceInfo() const { return mSourceInfo; }
+ constexpr IdTable    &idTable() const { return *mIdTable; }
+
+ // Appends to the string literal currently being built.
+ void appendString(std::string_view string) { mStringData += string; }
+ // Finishes the string literal currently being built. Returns its index.
+ std::uint32_t finishString() {
+  std::uint32_t offset {stringDataEnd()};
+  mStrings.emplace_back(offset, mStringData.size() - offset);
+  return mStrings.size() - 1;
  }
+ // Discards the string literal currently being built.
+ void discardString() { mStringData.resize(stringDataEnd()); }
 
- constexpr SourceRegionInfo *sourceRegionInfo() const {
-  return mSourceRegionInfo;
+ std::string_view string(std::uint32_t index) const {
+  auto [offset, size] = mStrings[index];
+  return {mStringData.data() + offset, size};
  }
 
+ // Notes that no token refers to the string literal of the token anymore.
+ void drop(Token token) {
+  if (Token::STRING == token.kind() && Token::VERBATIM != token.payload())
+   ++mDroppedStrings;
+ }
+ // Discards the dropped string literals once they outnumber the others,
+ // renumbering the string literals of the tokens, which must be every token
+ // referring to the tables.
+ void compactStrings(std::vector<Token> &tokens);
+};
+
+// View over a packed Token and its side tables, providing access to the
+// token's kind storage.
+class TokenView final {
+ Token              mToken;
+ TokenTables const *mTables;
+
+public:
+ constexpr TokenView(Token token, TokenTables const &tables)
+   : mToken {token}, mTables {&tables} {}
+
  template <class Kind>
- [[nodiscard]] constexpr decltype(auto) get() {
-  assert(is<Kind>());
-  return *std::get_if<Kind>(&mKind);
+ constexpr bool is() const {
+  return mToken.is<Kind>();
  }
+
+ constexpr Token         token() const { return mToken; }
+ constexpr SourceInfo   *sourceInfo() const { return mTables->sourceInfo(); }
+ constexpr std::uint32_t offset() const { return mToken.offset(); }
+ constexpr std::uint32_t length() const { return mToken.length(); }
+
+ // Source text the token was parsed from.
+ std::string_view sourceText() const {
+  return sourceInfo()->sourceContent().substr(offset(), length());
+ }
+
  template <class Kind>
- [[nodiscard]] constexpr decltype(auto) get() const {
+ [[nodiscard]] Kind get() const {
   assert(is<Kind>());
-  return *std::get_if<Kind>(&mKind);
+  if constexpr (std::is_same_v<Kind, token::Id>)
+   return {mTables->idTable().at(mToken.payload())};
+  else if constexpr (std::is_same_v<Kind, token::Keyword>)
+   return {static_cast<enum token::Keyword::Kind>(mToken.payload())};
+  else if constexpr (std::is_same_v<Kind, token::Punctuator>)
+   return {static_cast<enum token::Punctuator::Kind>(mToken.payload())};
+  else if constexpr (std::is_same_v<Kind, token::BinOp>)
+   return {static_cast<enum token::BinOp::Kind>(mToken.payload())};
+  else if (Token::VERBATIM == mToken.payload())
+   return {sourceText().substr(1, length() - 2)};
+  else
+   return {mTables->string(mToken.payload())};
  }
 
  Doc doc() const;
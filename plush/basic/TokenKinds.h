@@ -152,7 +152,6 @@ constexpr static std::array<Punctuator, Punctuator::KIND_SIZE> PUNCTUATORS {
   Punctuator::makeAll()};
 
 // Representation of a keyword in Plush.
-// Only to be used to find out additional information of a keyword via its kind.
 class Keyword final {
 public:
  enum Kind : std::uint8_t {
@@ -207,7 +206,6 @@ constexpr static std::array<Keyword, Keyword::KIND_SIZE> KEYWORDS {
   Keyword::makeAll()};
 
 // Representation of an identifier token in Plush.
-// Used in place of Keyword within tokens as additional context is required.
 class Id final {
  IdInfo *mId;
 
@@ -220,18 +218,18 @@ public:
  constexpr IdInfo *operator*() const { return mId; }
 };
 
-// Representation of a string literal token in Plush.
+// Representation of a string literal token in Plush. Refers to storage owned
+// by the token's side tables.
 class String final {
- std::string mString;
+ std::string_view mString;
 
 public:
- String(std::string &&string) : mString {string} {}
- String(std::string const &string) : mString {string} {}
+ constexpr String(std::string_view string) : mString {string} {}
 
  constexpr std::string_view string() const { return mString; }
 
- constexpr std::string const &operator*() const { return mString; }
- constexpr std::string const &operator->() const { return mString; }
+ constexpr std::string_view operator*() const { return mString; }
+ constexpr std::string_view const *operator->() const { return &mString; }
 };
 
 } // namespace plush::token
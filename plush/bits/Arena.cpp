@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+
+#include "bits/Arena.h"
+
+namespace plush {
+
+void *Arena::allocateSlow(std::size_t size, std::size_t align) {
+ // Oversized allocations get a chunk of their own, leaving room for the
+ // header and alignment padding.
+ std::size_t chunkSize {
+   std::max(mNextChunkSize, sizeof(Chunk) + align + size)};
+ mNextChunkSize = std::min(mNextChunkSize * 2, MAX_CHUNK_SIZE);
+
+ Chunk *chunk {static_cast<Chunk *>(::operator new(chunkSize))};
+ chunk->prev = mChunk;
+ mChunk      = chunk;
+ mCur        = reinterpret_cast<char *>(chunk + 1);
+ mEnd        = reinterpret_cast<char *>(chunk) + chunkSize;
+
+ return allocate(size, align);
+}
+
+void Arena::reset() {
+ for (Finalizer *f = mFinalizers; f; f = f->prev) f->destroy(f->object);
+ mFinalizers = nullptr;
+
+ if (!mChunk) return;
+ for (Chunk *chunk = mChunk->prev; chunk;) {
+  Chunk *prev {chunk->prev};
+  ::operator delete(chunk);
+  chunk = prev;
+ }
+ mChunk->prev = nullptr;
+ mCur         = reinterpret_cast<char *>(mChunk + 1);
+}
+
+Arena::~Arena() {
+ for (Finalizer *f = mFinalizers; f; f = f->prev) f->destroy(f->object);
+
+ while (mChunk) {
+  Chunk *prev {mChunk->prev};
+  ::operator delete(mChunk);
+  mChunk = prev;
+ }
+}
+
+} // namespace plush
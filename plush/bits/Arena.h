@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Provides a bump allocator for objects that need stable addresses and share
+// the lifetime of their owner.
+
+#pragma once
+
+#ifndef PLUSH_BITS_ARENA_H
+#define PLUSH_BITS_ARENA_H
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace plush {
+
+// Bump allocator handing out memory from a list of chunks. Allocations are
+// never moved or individually freed; everything is released at once when the
+// arena is destructed, running the destructors of non-trivially destructible
+// objects created with make.
+class Arena final {
+ // Header preceding the memory of every chunk.
+ struct Chunk {
+  Chunk *prev;
+ };
+
+ // Destructor to run upon destructing the arena.
+ struct Finalizer {
+  void (*destroy)(void *);
+  void      *object;
+  Finalizer *prev;
+ };
+
+ // Size of the first chunk, doubling for each following chunk.
+ constexpr static std::size_t MIN_CHUNK_SIZE {4096};
+ // Limit of the size chunks double up to.
+ constexpr static std::size_t MAX_CHUNK_SIZE {1 << 20};
+
+ // Most recently allocated chunk.
+ Chunk *mChunk {nullptr};
+ // Bump pointer and end of the most recently allocated chunk.
+ char *mCur {nullptr}, *mEnd {nullptr};
+ // Size of the next chunk to be allocated.
+ std::size_t mNextChunkSize {MIN_CHUNK_SIZE};
+ // Most recently registered finalizer.
+ Finalizer *mFinalizers {nullptr};
+
+ // Allocates a new chunk capable of holding size bytes at the alignment.
+ void *allocateSlow(std::size_t size, std::size_t align);
+
+public:
+ Arena() = default;
+ // Forbid copying and/or moving to keep allocations owned by a single arena.
+ Arena(Arena &&)                 = delete;
+ Arena(Arena const &)            = delete;
+ Arena &operator=(Arena &&)      = delete;
+ Arena &operator=(Arena const &) = delete;
+ ~Arena();
+
+ // Releases every allocation at once, running registered destructors. The
+ // most recently allocated, and largest, chunk is kept for reuse so an arena
+ // repeatedly filled to a similar size stops allocating.
+ void reset();
+
+ // Allocates uninitialized memory of the provided size and alignment.
+ void *allocate(std::size_t size, std::size_t align) {
+  std::uintptr_t cur {reinterpret_cast<std::uintptr_t>(mCur)};
+  std::uintptr_t aligned {(cur + align - 1) & ~(align - 1)};
+  if (mCur && aligned + size <= reinterpret_cast<std::uintptr_t>(mEnd)) {
+   mCur = reinterpret_cast<char *>(aligned + size);
+   return reinterpret_cast<void *>(aligned);
+  }
+  return allocateSlow(size, align);
+ }
+
+ // Constructs a T within the arena, registering its destructor if it isn't
+ // trivially destructible.
+ template <class T, class... Args>
+ T *make(Args &&...args) {
+  T *object {new (allocate(sizeof(T), alignof(T)))
+               T {std::forward<Args>(args)...}};
+  if constexpr (!std::is_trivially_destructible_v<T>)
+   mFinalizers = new (allocate(sizeof(Finalizer), alignof(Finalizer)))
+     Finalizer {[](void *o) { static_cast<T *>(o)->~T(); }, object,
+                mFinalizers};
+  return object;
+ }
+
+ // Copies a string into the arena.
+ std::string_view copy(std::string_view string) {
+  if (string.empty()) return {};
+  char *data {static_cast<char *>(allocate(string.size(), 1))};
+  std::memcpy(data, string.data(), string.size());
+  return {data, string.size()};
+ }
+};
+
+} // namespace plush
+
+#endif // PLUSH_BITS_ARENA_H
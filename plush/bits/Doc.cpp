@@ -1,105 +1,132 @@
 // SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <cstdio>
+#include <iterator>
+
 #include "bits/Doc.h"
+#include "bits/platform.h"
 #include "bits/utf8.h"
 
-namespace plush {
+#ifdef PLUSH_POSIX
+#include <cerrno>
+#include <unistd.h>
+#endif
 
-namespace doc {
+namespace plush {
 
-void DocBase::display(DocStyle const &style, std::ostream &out) const {
- std::cout << toString(style) << '\n';
+Doc &Doc::append(doc::Text text) {
+ mText += text.text;
+ return *this;
 }
 
-std::string DocBase::toString(DocStyle const &style) const {
- std::ostringstream oss;
- render(style, oss);
- return oss.str();
+Doc &Doc::append(doc::Char char_) {
+ char encoded[4];
+ mText.append(encoded, utf8::encode(encoded, char_.char_));
+ return *this;
 }
 
-Char::Char(char32_t char_) : mChar {char_} {}
-
-Char char_(char32_t char_) { return {char_}; }
-
-void Char::render(DocStyle const &style, std::ostringstream &oss) const {
- utf8::operator<<(oss, mChar);
+Doc &Doc::append(doc::Integer integer) {
+ char  digits[24];
+ char *it {std::end(digits)};
+ std::uintmax_t i {integer.magnitude};
+ do *--it = '0' + i % 10;
+ while (i /= 10);
+ if (integer.negative) *--it = '-';
+ mText.append(it, std::end(digits));
+ return *this;
 }
 
-Text::Text(std::string &&text) : mText {std::move(text)} {}
-Text::Text(std::string const &text) : mText {text} {}
-
-void Text::render(DocStyle const &style, std::ostringstream &oss) const {
- oss << mText;
+Doc &Doc::append(doc::StringLiteral string) {
+ mText += '"';
+ mText += string.string;
+ mText += '"';
+ return *this;
 }
 
-Text text(std::string &&text) { return {std::move(text)}; }
-Text text(std::string const &text) { return {text}; }
-
-Integer::Integer(std::intmax_t i) : mStringRep {std::to_string(i)} {}
-Integer::Integer(std::uintmax_t i) : mStringRep {std::to_string(i)} {}
-
-void Integer::render(DocStyle const &style, std::ostringstream &oss) const {
- oss << mStringRep;
+Doc &Doc::append(doc::HPadding padding) {
+ mText.append(padding.count, ' ');
+ return *this;
 }
 
-Integer integer(std::intmax_t i) { return {i}; }
-Integer integer(std::uintmax_t i) { return {i}; }
-
-StringLiteral::StringLiteral(std::string &&string)
-  : mString {std::move(string)} {}
-StringLiteral::StringLiteral(std::string const &string)
-  : mString {std::move(string)} {}
-
-void StringLiteral::render(DocStyle const     &style,
-                           std::ostringstream &oss) const {
- oss << '"' << mString << '"';
+Doc &Doc::append(Doc const &doc) {
+ std::uint32_t offset = mText.size();
+ mText += doc.mText;
+ for (std::uint32_t separator : doc.mSeparators)
+  mSeparators.push_back(offset + separator);
+ return *this;
 }
 
-StringLiteral stringLit(std::string &&string) { return {std::move(string)}; }
-StringLiteral stringLit(std::string const &text) { return {text}; }
-
-Colon::Colon() {}
-
-void Colon::render(DocStyle const &style, std::ostringstream &oss) const {
- oss << ':';
+Doc &Doc::appendSeparator() {
+ mSeparators.push_back(mText.size());
+ return *this;
 }
 
-LParen::LParen() {}
-
-void LParen::render(DocStyle const &style, std::ostringstream &oss) const {
- oss << '(';
+void Doc::clear() {
+ mText.clear();
+ mSeparators.clear();
 }
 
-RParen::RParen() {}
-
-void RParen::render(DocStyle const &style, std::ostringstream &oss) const {
- oss << ')';
+void Doc::render(DocStyle const &style, std::string &out) const {
+ std::uint32_t offset {0};
+ for (std::uint32_t separator : mSeparators) {
+  out.append(mText, offset, separator - offset);
+  out += style.listSeperator;
+  offset = separator;
+ }
+ out.append(mText, offset);
 }
 
-HPadding::HPadding(std::size_t count) : mCount {count} {}
+std::string Doc::toString(DocStyle const &style) const {
+ std::string out;
+ render(style, out);
+ return out;
+}
 
-void HPadding::render(DocStyle const &style, std::ostringstream &oss) const {
- for (std::size_t i = 0; i < mCount; ++i) oss << ' ';
+void Doc::display(DocStyle const &style, int fd) const {
+ DocWriter {fd, style}.line(*this);
 }
 
-HPadding hpad(std::size_t count) { return {count}; }
+DocWriter::DocWriter(int fd, DocStyle style)
+  : mFd {fd}, mStyle {std::move(style)} {}
+
+DocWriter::~DocWriter() { flush(); }
 
-void Docs::render(DocStyle const &style, std::ostringstream &oss) const {
- for (auto &doc : docs()) doc->render(style, oss);
+DocWriter &DocWriter::line(Doc const &doc) {
+ doc.render(mStyle, mBuffer);
+ mBuffer += '\n';
+ if (mBuffer.size() >= FLUSH_SIZE) flush();
+ return *this;
 }
 
-void List::render(DocStyle const &style, std::ostringstream &oss) const {
- for (auto it = docs().begin(); it < docs().end(); ++it) {
-  if (it != docs().begin()) oss << style.listSeperator;
-  (*it)->render(style, oss);
- }
+DocWriter &DocWriter::write(std::string_view string) {
+ mBuffer += string;
+ if (mBuffer.size() >= FLUSH_SIZE) flush();
+ return *this;
 }
 
-} // namespace doc
+void DocWriter::flush() {
+ if (mBuffer.empty()) return;
+ std::fflush(nullptr);
+
+#ifdef PLUSH_POSIX
+ char const *it {mBuffer.data()};
+ char const *end {it + mBuffer.size()};
+ while (it != end) {
+  ssize_t written {::write(mFd, it, end - it)};
+  if (written < 0) {
+   if (EINTR == errno) continue;
+   // Output can't be reported anywhere, drop it.
+   break;
+  }
+  it += written;
+ }
+#else
+ std::fwrite(mBuffer.data(), 1, mBuffer.size(), 2 == mFd ? stderr : stdout);
+ std::fflush(nullptr);
+#endif
 
-void Doc::render(DocStyle const &style, std::ostringstream &oss) const {
- mDoc->render(style, oss);
+ mBuffer.clear();
 }
 
 } // namespace plush
@@ -10,191 +10,168 @@
 #define PLUSH_BITS_DOC_H
 
 #include <cstdint>
-#include <iostream>
-#include <memory>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace plush {
 
 class Doc;
-struct DocStyle;
 
-namespace doc {
-
-// Base class for all document types.
-class DocBase {
- friend class ::plush::Doc;
-
-public:
- virtual ~DocBase() {}
-
- // Renders the document to an output string stream.
- virtual void render(DocStyle const &style, std::ostringstream &oss) const = 0;
- // Displays a document to the provided output stream.
- void display(DocStyle const &style, std::ostream &out = std::cout) const;
-
- // Renders the document to a string.
- std::string toString(DocStyle const &style) const;
+// Configurable styling for documents when displayed/rendered.
+struct DocStyle {
+ // Characters that seperate each rendered element within a list.
+ std::string listSeperator {", "};
 };
 
-// Character document.
-class Char : public DocBase {
- char32_t mChar;
+static inline DocStyle defaultDocStyle {};
 
-public:
- Char(char32_t char_);
+namespace doc {
 
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
+// Text document. Refers to the provided string, which must outlive the
+// expression building the document.
+struct Text {
+ std::string_view text;
 };
 
-Char char_(char32_t char_);
-
-// Text document.
-class Text : public DocBase {
- std::string mText;
+constexpr Text text(std::string_view text) { return {text}; }
 
-public:
- Text(std::string &&text);
- Text(std::string const &text);
-
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
+// Character document.
+struct Char {
+ char32_t char_;
 };
 
-Text text(std::string &&text);
-Text text(std::string const &text);
+constexpr Char char_(char32_t char_) { return {char_}; }
 
 // Integer document.
-class Integer : public DocBase {
- std::string mStringRep;
-
-public:
- Integer(std::intmax_t i);
- Integer(std::uintmax_t i);
-
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
+struct Integer {
+ std::uintmax_t magnitude;
+ bool           negative;
 };
 
-Integer integer(std::intmax_t i);
-Integer integer(std::uintmax_t i);
-
-// String literal document.
-class StringLiteral : public DocBase {
- std::string mString;
-
-public:
- StringLiteral(std::string &&string);
- StringLiteral(std::string const &string);
+constexpr Integer integer(std::intmax_t i) {
+ auto magnitude {static_cast<std::uintmax_t>(i)};
+ return {i < 0 ? -magnitude : magnitude, i < 0};
+}
+constexpr Integer integer(std::uintmax_t i) { return {i, false}; }
 
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
+// String literal document. Refers to the provided string, which must outlive
+// the expression building the document.
+struct StringLiteral {
+ std::string_view string;
 };
 
-StringLiteral stringLit(std::string &&string);
-StringLiteral stringLit(std::string const &string);
+constexpr StringLiteral stringLit(std::string_view string) { return {string}; }
 
 // Colon document.
-class Colon : public DocBase {
-public:
- Colon();
+inline constexpr Text colon {":"};
+// Left parenthesis document.
+inline constexpr Text lparen {"("};
+// Right parenthesis document.
+inline constexpr Text rparen {")"};
 
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
+// Horizontal padding document.
+struct HPadding {
+ std::size_t count;
 };
 
-inline Colon const colon {};
+constexpr HPadding hpad(std::size_t count = 1) { return {count}; }
 
-// Left parenthesis document.
-class LParen : public DocBase {
-public:
- LParen();
+// Checks if T is a document or one of the document building blocks.
+template <class T>
+constexpr bool isDoc = std::is_same_v<T, Doc> || std::is_same_v<T, Text> ||
+                       std::is_same_v<T, Char> || std::is_same_v<T, Integer> ||
+                       std::is_same_v<T, StringLiteral> ||
+                       std::is_same_v<T, HPadding>;
 
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
-};
+} // namespace doc
 
-inline LParen const lparen {};
+// A user-friendly renderable document. Stored flat as its style-independent
+// text, along with the positions style-dependent list separators are inserted
+// at, so building a document only ever appends to two vectors.
+class Doc final {
+ // Rendered text, excluding list separators.
+ std::string mText;
+ // Offset within mText of each list separator, in order.
+ std::vector<std::uint32_t> mSeparators;
 
-// Right parenthesis document.
-class RParen : public DocBase {
 public:
- RParen();
-
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
-};
+ Doc() = default;
+ template <class D, typename = std::enable_if_t<doc::isDoc<std::decay_t<D>>>>
+ Doc(D &&d) {
+  append(std::forward<D>(d));
+ }
 
-inline RParen const rparen {};
+ Doc &append(doc::Text text);
+ Doc &append(doc::Char char_);
+ Doc &append(doc::Integer integer);
+ Doc &append(doc::StringLiteral string);
+ Doc &append(doc::HPadding padding);
+ Doc &append(Doc const &doc);
+ // Appends a list separator.
+ Doc &appendSeparator();
 
-// Horizontal padding document.
-class HPadding : public DocBase {
- std::size_t mCount;
+ template <class D>
+ Doc &operator+=(D &&d) {
+  return append(std::forward<D>(d));
+ }
 
-public:
- HPadding(std::size_t count = 1);
+ bool empty() const { return mText.empty() && mSeparators.empty(); }
+ // Clears the document, keeping its storage for reuse.
+ void clear();
 
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
+ // Renders the document, appending it to out.
+ void render(DocStyle const &style, std::string &out) const;
+ // Renders the document to a string.
+ std::string toString(DocStyle const &style = defaultDocStyle) const;
+ // Displays the document followed by a newline to the provided file
+ // descriptor.
+ void display(DocStyle const &style = defaultDocStyle, int fd = 1) const;
 };
 
-HPadding hpad(std::size_t count = 1);
+template <class D1, class D2,
+          typename = std::enable_if_t<doc::isDoc<std::decay_t<D1>> &&
+                                      doc::isDoc<std::decay_t<D2>>>>
+Doc operator+(D1 &&d1, D2 &&d2) {
+ Doc d {std::forward<D1>(d1)};
+ d += std::forward<D2>(d2);
+ return d;
+}
 
-// Collection of documents.
-class Docs : public DocBase {
- std::vector<std::shared_ptr<DocBase>> mDocs;
+namespace doc {
 
-protected:
- constexpr std::vector<std::shared_ptr<DocBase>> &docs() { return mDocs; }
+// List document, seperating each element with the style's list separator.
+class List final {
+ Doc         mDoc;
+ std::size_t mSize {0};
 
 public:
+ List() = default;
  template <class... Ds,
-           typename = std::enable_if_t<
-             true && (std::is_base_of_v<DocBase, std::decay_t<Ds>> && ...)>>
- Docs(Ds &&...docs)
-   : mDocs {std::make_shared<std::decay_t<Ds>>(std::forward<Ds>(docs))...} {}
-
- template <class D, typename = std::enable_if_t<
-                      std::is_base_of_v<DocBase, std::decay_t<D>>>>
- Docs &append(D &&doc) {
-  mDocs.push_back(std::make_shared<std::decay_t<D>>(std::forward<D>(doc)));
-  return *this;
+           typename = std::enable_if_t<(sizeof...(Ds) > 0) &&
+                                       (isDoc<std::decay_t<Ds>> && ...)>>
+ List(Ds &&...ds) {
+  (append(std::forward<Ds>(ds)), ...);
  }
 
  template <class D>
- Docs &operator+=(D &&doc) {
-  return append(std::forward<D>(doc));
+ List &append(D &&d) {
+  if (mSize++) mDoc.appendSeparator();
+  mDoc += std::forward<D>(d);
+  return *this;
  }
 
- constexpr std::vector<std::shared_ptr<DocBase>> const &docs() const {
-  return mDocs;
+ template <class D>
+ List &operator+=(D &&d) {
+  return append(std::forward<D>(d));
  }
 
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
-};
-
-template <class... Ds>
-Docs docs(Ds &&...ds) {
- return {std::forward<Ds>(ds)...};
-}
-
-template <class D1, class D2>
-Docs operator+(D1 &&d1, D2 &&d2) {
- return {std::forward<D1>(d1), std::forward<D2>(d2)};
-}
+ constexpr std::size_t size() const { return mSize; }
 
-// List document.
-class List : public Docs {
-public:
- using Docs::Docs;
-
- virtual void render(DocStyle const     &style,
-                     std::ostringstream &oss) const override;
+ operator Doc const &() const { return mDoc; }
+ Doc const &doc() const { return mDoc; }
 };
 
 template <class... Ds>
@@ -202,38 +179,33 @@ List list(Ds &&...ds) {
  return {std::forward<Ds>(ds)...};
 }
 
-template <class D1, class D2>
-List operator,(D1 &&d1, D2 &&d2) {
- if constexpr (std::is_same_v<std::decay_t<D1>, List>) {
-  d1.append(d2);
-  return d1;
- } else
-  return {std::forward<D1>(d1), std::forward<D2>(d2)};
-}
-
 } // namespace doc
 
-// Configurable styling for documents when displayed/rendered.
-struct DocStyle {
- // Characters that seperate each rendered element within a list.
- std::string listSeperator {", "};
-};
-
-static inline DocStyle defaultDocStyle {};
+// Renders documents into a reusable buffer, written to a file descriptor once
+// it fills up and upon flushing.
+class DocWriter final {
+ // Size of the buffer at which it is written out.
+ constexpr static std::size_t FLUSH_SIZE {1 << 16};
 
-// A user-friendly renderable document. Acts as a wrapper type for any
-// derivative of doc::DocBase.
-class Doc final : public doc::DocBase {
- std::shared_ptr<doc::DocBase> mDoc;
+ int         mFd;
+ DocStyle    mStyle;
+ std::string mBuffer;
 
 public:
- template <class Derived, typename = std::enable_if_t<std::is_base_of_v<
-                            doc::DocBase, std::decay_t<Derived>>>>
- Doc(Derived &&derived)
-   : mDoc {std::make_shared<std::decay_t<Derived>>(
-       std::forward<Derived>(derived))} {}
-
- void render(DocStyle const &style, std::ostringstream &oss) const override;
+ explicit DocWriter(int fd, DocStyle style = defaultDocStyle);
+ DocWriter(DocWriter &&)                 = delete;
+ DocWriter(DocWriter const &)            = delete;
+ DocWriter &operator=(DocWriter &&)      = delete;
+ DocWriter &operator=(DocWriter const &) = delete;
+ ~DocWriter();
+
+ // Renders a document followed by a newline.
+ DocWriter &line(Doc const &doc);
+ // Writes a string as is.
+ DocWriter &write(std::string_view string);
+ // Writes out the buffer. Standard streams are flushed first so output stays
+ // ordered with them.
+ void flush();
 };
 
 } // namespace plush
@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "bits/Fd.h"
+#include "bits/platform.h"
+
+#ifdef PLUSH_POSIX
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+namespace plush {
+
+void Fd::close() {
+#ifdef PLUSH_POSIX
+ if (valid()) ::close(mFd);
+#endif
+ mFd = -1;
+}
+
+Fd openTmpFile() {
+#ifdef PLUSH_POSIX
+ int fd;
+#ifdef O_TMPFILE
+ fd = ::open("/tmp", O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+ if (fd >= 0) return Fd {fd};
+#endif
+ char path[] {"/tmp/plushXXXXXX"};
+ fd = ::mkstemp(path);
+ if (fd < 0) return {};
+ ::unlink(path);
+ ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+ return Fd {fd};
+#else
+ return {};
+#endif
+}
+
+} // namespace plush
@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_BITS_FD_H
+#define PLUSH_BITS_FD_H
+
+#include <utility>
+
+namespace plush {
+
+// Owned file descriptor, closed upon destruction. Only meaningful on POSIX
+// platforms.
+class Fd final {
+ int mFd {-1};
+
+public:
+ Fd() = default;
+ explicit Fd(int fd) : mFd {fd} {}
+ Fd(Fd &&fd) : mFd {std::exchange(fd.mFd, -1)} {}
+ Fd &operator=(Fd &&fd) {
+  std::swap(mFd, fd.mFd);
+  return *this;
+ }
+ Fd(Fd const &)            = delete;
+ Fd &operator=(Fd const &) = delete;
+ ~Fd() { close(); }
+
+ constexpr int  get() const { return mFd; }
+ constexpr bool valid() const { return mFd >= 0; }
+
+ // Gives up ownership of the descriptor without closing it.
+ int release() { return std::exchange(mFd, -1); }
+ // Closes the descriptor early.
+ void close();
+};
+
+// Opens an anonymous read-write temporary file, closed on exec. The returned
+// descriptor is invalid on failure, with errno set.
+Fd openTmpFile();
+
+} // namespace plush
+
+#endif // PLUSH_BITS_FD_H
@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "bits/MappedFile.h"
+
+#ifdef PLUSH_POSIX
+#include <sys/mman.h>
+#endif
+
+namespace plush {
+
+MappedFile::MappedFile(char const *data, std::size_t size)
+  : mData {data}, mSize {size} {}
+
+[[nodiscard]] Expect<MappedFile> MappedFile::map(int fd, std::size_t size) {
+#ifdef PLUSH_POSIX
+ if (!size) return BasicError {"Can't map an empty file"};
+
+ void *data {::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+ if (MAP_FAILED == data) return BasicError {std::strerror(errno)};
+
+ // Sources are lexed front to back, hint the kernel to read ahead.
+ ::madvise(data, size, MADV_SEQUENTIAL);
+ return MappedFile {static_cast<char const *>(data), size};
+#else
+ return BasicError {"Memory mapping is unsupported on this platform"};
+#endif
+}
+
+MappedFile::MappedFile(MappedFile &&mappedFile)
+  : mData {std::exchange(mappedFile.mData, nullptr)},
+    mSize {std::exchange(mappedFile.mSize, 0)} {}
+
+MappedFile &MappedFile::operator=(MappedFile &&mappedFile) {
+ std::swap(mData, mappedFile.mData);
+ std::swap(mSize, mappedFile.mSize);
+ return *this;
+}
+
+MappedFile::~MappedFile() {
+#ifdef PLUSH_POSIX
+ if (mData) ::munmap(const_cast<char *>(mData), mSize);
+#endif
+}
+
+} // namespace plush
@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_BITS_MAPPEDFILE_H
+#define PLUSH_BITS_MAPPEDFILE_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "bits/Expect.h"
+#include "bits/platform.h"
+
+namespace plush {
+
+// Read-only memory mapping of a file's content, unmapped upon destruction.
+// Only supported on POSIX platforms.
+class MappedFile final {
+ char const *mData;
+ std::size_t mSize;
+
+ MappedFile(char const *data, std::size_t size);
+
+public:
+ // Attempts to map the first size bytes of the file open at the provided
+ // descriptor. The descriptor may be closed afterwards.
+ [[nodiscard]] static Expect<MappedFile> map(int fd, std::size_t size);
+
+ MappedFile(MappedFile &&mappedFile);
+ MappedFile &operator=(MappedFile &&mappedFile);
+ MappedFile(MappedFile const &)            = delete;
+ MappedFile &operator=(MappedFile const &) = delete;
+ ~MappedFile();
+
+ constexpr std::string_view content() const { return {mData, mSize}; }
+};
+
+} // namespace plush
+
+#endif // PLUSH_BITS_MAPPEDFILE_H
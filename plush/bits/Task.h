@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_BITS_TASK_H
+#define PLUSH_BITS_TASK_H
+
+#include <coroutine>
+#include <cstdlib>
+#include <utility>
+
+namespace plush {
+
+// Coroutine producing an int, such as an exit status. Starts suspended and
+// runs once awaited by another coroutine or started on an EventLoop. Awaiting
+// a task transfers control to it directly, and its completion resumes the
+// awaiting coroutine the same way, so chains of tasks never grow the stack.
+// The task owns its coroutine frame.
+class Task final {
+public:
+ struct promise_type {
+  int result {0};
+  // Coroutine awaiting this one, if any.
+  std::coroutine_handle<> continuation;
+
+  // Resumes the awaiting coroutine once the task returned, if any, leaving
+  // the task suspended until its owner destroys it.
+  struct FinalAwaiter {
+   bool                    await_ready() noexcept { return false; }
+   std::coroutine_handle<> await_suspend(
+     std::coroutine_handle<promise_type> handle) noexcept {
+    if (auto continuation = handle.promise().continuation)
+     return continuation;
+    return std::noop_coroutine();
+   }
+   void await_resume() noexcept {}
+  };
+
+  Task get_return_object() {
+   return Task {std::coroutine_handle<promise_type>::from_promise(*this)};
+  }
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter        final_suspend() noexcept { return {}; }
+  void                return_value(int value) { result = value; }
+  // Plush is built without exceptions.
+  void unhandled_exception() { std::abort(); }
+ };
+
+private:
+ std::coroutine_handle<promise_type> mHandle;
+
+ explicit Task(std::coroutine_handle<promise_type> handle) : mHandle {handle} {}
+
+public:
+ Task(Task &&task) : mHandle {std::exchange(task.mHandle, nullptr)} {}
+ Task &operator=(Task &&task) {
+  std::swap(mHandle, task.mHandle);
+  return *this;
+ }
+ Task(Task const &)            = delete;
+ Task &operator=(Task const &) = delete;
+ ~Task() {
+  if (mHandle) mHandle.destroy();
+ }
+
+ std::coroutine_handle<> handle() const { return mHandle; }
+ bool                    done() const { return mHandle.done(); }
+ // Value returned by the task, once done.
+ int result() const { return mHandle.promise().result; }
+
+ // Awaiting a task runs it until it returns, evaluating to its result.
+ bool                    await_ready() const { return false; }
+ std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+  mHandle.promise().continuation = awaiting;
+  return mHandle;
+ }
+ int await_resume() const { return result(); }
+};
+
+} // namespace plush
+
+#endif // PLUSH_BITS_TASK_H
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <utility>
+
+#include "bits/ThreadPool.h"
+
+namespace plush {
+
+std::size_t ThreadPool::defaultThreadCount() {
+ return std::max(1u, std::thread::hardware_concurrency());
+}
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+  : mThreadCount {std::max<std::size_t>(threadCount, 1)} {
+ mWorkers.reserve(mThreadCount);
+}
+
+ThreadPool::~ThreadPool() {
+ {
+  std::lock_guard guard {mMutex};
+  mStopping = true;
+ }
+ mTaskCond.notify_all();
+ for (auto &worker : mWorkers) worker.join();
+}
+
+void ThreadPool::work() {
+ for (;;) {
+  std::function<void()> task;
+  {
+   std::unique_lock guard {mMutex};
+   mTaskCond.wait(guard, [this] { return mStopping || !mTasks.empty(); });
+   // Remaining tasks are still run when stopping.
+   if (mTasks.empty()) return;
+   task = std::move(mTasks.front());
+   mTasks.pop_front();
+  }
+
+  task();
+
+  std::lock_guard guard {mMutex};
+  if (!--mPending) mIdleCond.notify_all();
+ }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+ {
+  std::lock_guard guard {mMutex};
+  mTasks.push_back(std::move(task));
+  ++mPending;
+  if (mPending > mWorkers.size() && mWorkers.size() < mThreadCount)
+   mWorkers.emplace_back([this] { work(); });
+ }
+ mTaskCond.notify_one();
+}
+
+void ThreadPool::wait() {
+ std::unique_lock guard {mMutex};
+ mIdleCond.wait(guard, [this] { return !mPending; });
+}
+
+} // namespace plush
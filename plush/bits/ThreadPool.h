@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_BITS_THREADPOOL_H
+#define PLUSH_BITS_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace plush {
+
+// Up to a fixed number of worker threads running submitted tasks in submission
+// order. Workers are started once submitted tasks outnumber them, so a pool
+// that's barely used costs barely any threads.
+class ThreadPool final {
+ // Maximum number of workers.
+ std::size_t const                 mThreadCount;
+ std::vector<std::thread>          mWorkers;
+ std::deque<std::function<void()>> mTasks;
+ std::mutex                        mMutex;
+ // Signalled when a task is submitted or the pool is stopping.
+ std::condition_variable mTaskCond;
+ // Signalled when every submitted task has finished.
+ std::condition_variable mIdleCond;
+ // Number of submitted tasks that haven't finished.
+ std::size_t mPending {0};
+ bool        mStopping {false};
+
+ void work();
+
+public:
+ // Number of worker threads used when none is requested.
+ static std::size_t defaultThreadCount();
+
+ explicit ThreadPool(std::size_t threadCount = defaultThreadCount());
+ // Forbid copying and/or moving, workers refer to the pool.
+ ThreadPool(ThreadPool &&)                 = delete;
+ ThreadPool(ThreadPool const &)            = delete;
+ ThreadPool &operator=(ThreadPool &&)      = delete;
+ ThreadPool &operator=(ThreadPool const &) = delete;
+ // Finishes every submitted task before joining the workers.
+ ~ThreadPool();
+
+ std::size_t threadCount() const { return mThreadCount; }
+
+ // Queues a task to be run by a worker.
+ void submit(std::function<void()> task);
+ // Blocks until every submitted task has finished.
+ void wait();
+};
+
+} // namespace plush
+
+#endif // PLUSH_BITS_THREADPOOL_H
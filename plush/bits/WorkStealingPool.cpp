@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <utility>
+
+#include "bits/WorkStealingPool.h"
+
+namespace plush {
+
+// Pool and index of the worker running on the calling thread, if any.
+static thread_local WorkStealingPool const *tPool {nullptr};
+static thread_local std::size_t            tWorker {0};
+
+WorkStealingPool::WorkStealingPool(std::size_t threadCount) {
+ threadCount = std::max<std::size_t>(threadCount, 1);
+ mQueues.reserve(threadCount);
+ for (std::size_t i = 0; i < threadCount; ++i)
+  mQueues.push_back(std::make_unique<Queue>());
+ mWorkers.reserve(threadCount);
+ for (std::size_t i = 0; i < threadCount; ++i)
+  mWorkers.emplace_back([this, i] { work(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+ {
+  std::lock_guard guard {mMutex};
+  mStopping = true;
+ }
+ mTaskCond.notify_all();
+ for (auto &worker : mWorkers) worker.join();
+}
+
+std::size_t WorkStealingPool::workerIndex() const {
+ return tPool == this ? tWorker : 0;
+}
+
+std::function<void()> WorkStealingPool::take(std::size_t worker) {
+ std::function<void()> task;
+ {
+  Queue          &own {*mQueues[worker]};
+  std::lock_guard guard {own.mutex};
+  if (!own.tasks.empty()) {
+   task = std::move(own.tasks.back());
+   own.tasks.pop_back();
+   --mQueued;
+   return task;
+  }
+ }
+
+ for (std::size_t i = 1; i < mQueues.size(); ++i) {
+  Queue          &victim {*mQueues[(worker + i) % mQueues.size()]};
+  std::lock_guard guard {victim.mutex};
+  if (!victim.tasks.empty()) {
+   task = std::move(victim.tasks.front());
+   victim.tasks.pop_front();
+   --mQueued;
+   return task;
+  }
+ }
+ return task;
+}
+
+void WorkStealingPool::work(std::size_t worker) {
+ tPool   = this;
+ tWorker = worker;
+ for (;;) {
+  std::function<void()> task {take(worker)};
+  if (!task) {
+   std::unique_lock guard {mMutex};
+   mTaskCond.wait(guard, [this] { return mStopping || mQueued; });
+   // Remaining tasks are still run when stopping.
+   if (!mQueued) return;
+   continue;
+  }
+
+  task();
+
+  std::lock_guard guard {mMutex};
+  if (!--mPending) mIdleCond.notify_all();
+ }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+ // Counting the task before queueing it keeps wait from seeing no pending task
+ // while it's being queued, a worker woken early only retries until it's there.
+ {
+  std::lock_guard guard {mMutex};
+  ++mQueued;
+  ++mPending;
+ }
+ std::size_t const queue {tPool == this
+                            ? tWorker
+                            : mNextQueue++ % mQueues.size()};
+ {
+  std::lock_guard guard {mQueues[queue]->mutex};
+  mQueues[queue]->tasks.push_back(std::move(task));
+ }
+ mTaskCond.notify_one();
+}
+
+void WorkStealingPool::wait() {
+ std::unique_lock guard {mMutex};
+ mIdleCond.wait(guard, [this] { return !mPending; });
+}
+
+} // namespace plush
@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_BITS_WORKSTEALINGPOOL_H
+#define PLUSH_BITS_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace plush {
+
+// Fixed number of worker threads, each with its own queue of tasks. A worker
+// runs the newest task of its own queue first and steals the oldest task of
+// another worker's queue when its own is empty. Tasks submitted by a running
+// task go to its worker's queue, so tasks unblocking each other stay on one
+// thread while idle workers take whole branches off busy ones.
+class WorkStealingPool final {
+ // Tasks of one worker, the owner pops at the back and thieves at the front.
+ struct Queue {
+  std::mutex                        mutex;
+  std::deque<std::function<void()>> tasks;
+ };
+
+ std::vector<std::unique_ptr<Queue>> mQueues;
+ std::vector<std::thread>            mWorkers;
+ // Number of tasks within every queue, counted up under mMutex so sleeping
+ // workers can't miss a submission.
+ std::atomic<std::size_t> mQueued {0};
+ // Queue receiving the next task submitted from outside the pool.
+ std::atomic<std::size_t> mNextQueue {0};
+ std::mutex               mMutex;
+ // Signalled when a task is submitted or the pool is stopping.
+ std::condition_variable mTaskCond;
+ // Signalled when every submitted task has finished.
+ std::condition_variable mIdleCond;
+ // Number of submitted tasks that haven't finished, guarded by mMutex.
+ std::size_t mPending {0};
+ bool        mStopping {false};
+
+ // Pops the newest task of a worker's own queue, or steals the oldest task of
+ // another queue. Returns an empty function if every queue is empty.
+ std::function<void()> take(std::size_t worker);
+ void                  work(std::size_t worker);
+
+public:
+ explicit WorkStealingPool(std::size_t threadCount);
+ // Forbid copying and/or moving, workers refer to the pool.
+ WorkStealingPool(WorkStealingPool &&)                 = delete;
+ WorkStealingPool(WorkStealingPool const &)            = delete;
+ WorkStealingPool &operator=(WorkStealingPool &&)      = delete;
+ WorkStealingPool &operator=(WorkStealingPool const &) = delete;
+ // Finishes every submitted task before joining the workers.
+ ~WorkStealingPool();
+
+ std::size_t threadCount() const { return mWorkers.size(); }
+ // Index of the worker running the calling task, within [0, threadCount()).
+ // Only meaningful within a task of this pool.
+ std::size_t workerIndex() const;
+
+ // Queues a task, on the calling worker's queue if called from a task of this
+ // pool.
+ void submit(std::function<void()> task);
+ // Blocks until every submitted task has finished.
+ void wait();
+};
+
+} // namespace plush
+
+#endif // PLUSH_BITS_WORKSTEALINGPOOL_H
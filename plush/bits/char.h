@@ -38,6 +38,16 @@ constexpr bool isWhitespace(char32_t c) {
          /* IDEOGRAPHIC SPACE */ 0x3000 == c);
 }
 
+// Check if the provided character can begin an identifier.
+constexpr bool isIdHead(char32_t c) {
+ return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+// Check if the provided character can continue an identifier.
+constexpr bool isIdTail(char32_t c) {
+ return isIdHead(c) || (c >= '0' && c <= '9');
+}
+
 } // namespace plush
 
 #endif // PLUSH_BITS_CHAR_H
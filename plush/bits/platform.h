@@ -22,4 +22,8 @@
 #error "Unsupported platform, Define PLUSH_64BIT or PLUSH_32BIT"
 #endif
 
+#if __unix__ || __APPLE__
+#define PLUSH_POSIX
+#endif
+
 #endif // PLUSH_BITS_PLATFORM_H
@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Provides a minimal byte vector abstraction over AVX2 (32 bytes) or SSE2 (16
+// bytes), whichever is enabled at compile time. PLUSH_SIMD is defined when
+// either is available, otherwise callers are expected to use scalar code.
+
+#pragma once
+
+#ifndef PLUSH_BITS_SIMD_H
+#define PLUSH_BITS_SIMD_H
+
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#define PLUSH_SIMD
+#include <immintrin.h>
+#endif
+
+namespace plush::simd {
+
+#if defined(__AVX2__)
+
+using Vec = __m256i;
+
+constexpr std::size_t VEC_SIZE {32};
+
+inline Vec load(char const *it) {
+ return _mm256_loadu_si256(reinterpret_cast<Vec const *>(it));
+}
+inline Vec splat(char c) { return _mm256_set1_epi8(c); }
+inline Vec eq(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+inline Vec or_(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm256_sub_epi8(a, b); }
+inline Vec min(Vec a, Vec b) { return _mm256_min_epu8(a, b); }
+// Gathers the most significant bit of each byte, one bit per byte.
+inline std::uint32_t mask(Vec v) { return _mm256_movemask_epi8(v); }
+
+#elif defined(__SSE2__)
+
+using Vec = __m128i;
+
+constexpr std::size_t VEC_SIZE {16};
+
+inline Vec load(char const *it) {
+ return _mm_loadu_si128(reinterpret_cast<Vec const *>(it));
+}
+inline Vec splat(char c) { return _mm_set1_epi8(c); }
+inline Vec eq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+inline Vec or_(Vec a, Vec b) { return _mm_or_si128(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm_sub_epi8(a, b); }
+inline Vec min(Vec a, Vec b) { return _mm_min_epu8(a, b); }
+// Gathers the most significant bit of each byte, one bit per byte.
+inline std::uint32_t mask(Vec v) { return _mm_movemask_epi8(v); }
+
+#endif
+
+#ifdef PLUSH_SIMD
+
+// Mask with a bit set for every byte lane of a vector.
+constexpr std::uint32_t FULL_MASK {
+  static_cast<std::uint32_t>((std::uint64_t {1} << VEC_SIZE) - 1)};
+
+// Sets every byte of v within [lo, lo + size] (unsigned) to 0xFF.
+inline Vec inRange(Vec v, char lo, char size) {
+ Vec t {sub(v, splat(lo))};
+ return eq(min(t, splat(size)), t);
+}
+
+#endif
+
+} // namespace plush::simd
+
+#endif // PLUSH_BITS_SIMD_H
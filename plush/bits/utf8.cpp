@@ -1,12 +1,46 @@
 // SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "bits/simd.h"
 #include "bits/utf8.h"
 
 namespace plush {
 
 namespace utf8 {
 
+namespace {
+
+// Checks the sequence at it, which must begin with a non-ASCII byte. Returns
+// the number of bytes belonging to it, negated if the sequence is ill-formed.
+std::ptrdiff_t checkSequence(char const *it, char const *end) {
+ auto byte = [&](std::size_t i) { return static_cast<std::uint8_t>(it[i]); };
+
+ std::uint8_t const lead {byte(0)};
+ std::uint8_t const size {CODEPOINT_SIZE_TABLE[lead]};
+ if (size == 1) return -1;
+
+ // Well-formed byte sequences as per table 3-7 of the Unicode standard, only
+ // the second byte's range depends on the lead byte.
+ std::uint8_t lo {0x80}, hi {0xBF};
+ if (0xE0 == lead)
+  lo = 0xA0;
+ else if (0xED == lead)
+  hi = 0x9F;
+ else if (0xF0 == lead)
+  lo = 0x90;
+ else if (0xF4 == lead)
+  hi = 0x8F;
+
+ for (std::ptrdiff_t i = 1; i < size; ++i) {
+  if (it + i == end) return -i;
+  if (byte(i) < lo || byte(i) > hi) return -i;
+  lo = 0x80, hi = 0xBF;
+ }
+ return size;
+}
+
+} // namespace
+
 std::ostream &operator<<(std::ostream &stream, char32_t c) {
  char s[5] {};
  encode(s, c);
@@ -14,6 +48,34 @@ std::ostream &operator<<(std::ostream &stream, char32_t c) {
  return stream;
 }
 
+char const *findInvalid(char const *it, char const *end) {
+ while (it != end) {
+#ifdef PLUSH_SIMD
+  // Skip over whole vectors of ASCII.
+  for (; static_cast<std::size_t>(end - it) >= simd::VEC_SIZE;
+       it += simd::VEC_SIZE)
+   if (std::uint32_t m = simd::mask(simd::load(it))) {
+    it += __builtin_ctz(m);
+    break;
+   }
+#endif
+  while (it != end && static_cast<std::uint8_t>(*it) < 0x80) ++it;
+  if (it == end) break;
+
+  std::ptrdiff_t size {checkSequence(it, end)};
+  if (size < 0) return it;
+  it += size;
+ }
+ return end;
+}
+
+std::size_t invalidSize(char const *it, char const *end) {
+ assert(it != end);
+ std::ptrdiff_t size {checkSequence(it, end)};
+ assert(size < 0 && "Sequence is well-formed");
+ return -size;
+}
+
 } // namespace utf8
 
 } // namespace plush
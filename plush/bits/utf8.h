@@ -6,6 +6,7 @@
 #ifndef PLUSH_BITS_UTF8_H
 #define PLUSH_BITS_UTF8_H
 
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
@@ -78,7 +79,76 @@ constexpr std::size_t encode(char out[4], char32_t c) {
 
 std::ostream &operator<<(std::ostream &stream, char32_t c);
 
-// UTF-8 iterator wrapper for forward char iterator types.
+// Finds the first ill-formed sequence within [it, end), or end if every
+// sequence is well-formed. Runs of ASCII are skipped a vector at a time.
+char const *findInvalid(char const *it, char const *end);
+
+// Gets the size of the ill-formed sequence at it, its maximal subpart as per
+// the Unicode standard. Always at least 1.
+std::size_t invalidSize(char const *it, char const *end);
+
+// Size of the codepoint beginning with each lead byte, 1 for bytes that can't
+// begin a well-formed sequence.
+constexpr std::array<std::uint8_t, 256> CODEPOINT_SIZE_TABLE {[] {
+ std::array<std::uint8_t, 256> table {};
+ for (std::size_t c = 0; c < table.size(); ++c)
+  table[c] = (c >= 0xC2 && c <= 0xDF)   ? 2
+             : (c >= 0xE0 && c <= 0xEF) ? 3
+             : (c >= 0xF0 && c <= 0xF4) ? 4
+                                        : 1;
+ return table;
+}()};
+
+// Decodes a UTF-8 encoded glyph to UTF-32 via its codepoint, which must be
+// well-formed. Only branches on the codepoint size.
+constexpr char32_t decodeUnchecked(char const *codepoint) {
+ constexpr std::uint8_t LEAD_MASK[5] {0, 0x7F, 0x1F, 0x0F, 0x07};
+
+ std::uint8_t const lead {static_cast<std::uint8_t>(*codepoint)};
+ std::uint8_t const size {CODEPOINT_SIZE_TABLE[lead]};
+ char32_t           c {static_cast<char32_t>(lead & LEAD_MASK[size])};
+ for (std::uint8_t i = 1; i < size; ++i)
+  c = (c << 6) | (static_cast<std::uint8_t>(codepoint[i]) & 63);
+ return c;
+}
+
+// UTF-8 iterator over a buffer of well-formed UTF-8, as validated by
+// findInvalid. Never checks its input.
+class UncheckedIterator final {
+ // Current position.
+ char const *mPtr;
+
+public:
+ using value_type        = char32_t;
+ using pointer           = char32_t const *;
+ using reference         = char32_t const &;
+ using difference_type   = std::ptrdiff_t;
+ using iterator_category = std::forward_iterator_tag;
+
+ constexpr explicit UncheckedIterator(char const *ptr) : mPtr {ptr} {}
+
+ constexpr char32_t operator*() const { return decodeUnchecked(mPtr); }
+ constexpr bool     operator==(UncheckedIterator const &it) const {
+  return mPtr == it.mPtr;
+ }
+ constexpr bool operator!=(UncheckedIterator const &it) const {
+  return !operator==(it);
+ }
+ constexpr UncheckedIterator &operator++() {
+  mPtr += CODEPOINT_SIZE_TABLE[static_cast<std::uint8_t>(*mPtr)];
+  return *this;
+ }
+ constexpr UncheckedIterator operator++(int) {
+  UncheckedIterator temp {*this};
+  operator++();
+  return temp;
+ }
+
+ constexpr char const *base() const { return mPtr; }
+};
+
+// UTF-8 iterator wrapper for forward char iterator types. The input must be
+// well-formed, truncated sequences are read past.
 template <class FwdCharIt>
 class ConstUtf8IteratorFor {
  // Internal iterator.
@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <functional>
+#include <system_error>
+
+#include "bits/Unit.h"
+#include "driver/ModuleLoader.h"
+#include "lexer/lex.h"
+#include "parser/parse.h"
+
+namespace plush::driver {
+
+ModuleLoader::ModuleLoader(FileManager &fileMgr, SourceManager &srcMgr,
+                           IdTable &idTable, ThreadPool &pool)
+  : mFileMgr {fileMgr}, mSrcMgr {srcMgr}, mIdTable {idTable}, mPool {pool} {}
+
+void ModuleLoader::fail(BasicError &&error) {
+ std::lock_guard guard {mMutex};
+ if (!mError) mError.emplace(std::move(error));
+}
+
+Module *ModuleLoader::request(std::filesystem::path const &path) {
+ auto optPath {mFileMgr.findFile(path)};
+ if (!optPath) return nullptr;
+ std::error_code       ec;
+ std::filesystem::path canonical {std::filesystem::canonical(*optPath, ec)};
+ if (ec) return nullptr;
+
+ Module *module;
+ {
+  std::lock_guard guard {mMutex};
+  auto [it, added] = mPaths.try_emplace(canonical.string(), nullptr);
+  if (!added) return it->second;
+  module       = mModules.emplace_back(std::make_unique<Module>()).get();
+  module->path = std::move(canonical);
+  it->second   = module;
+ }
+
+ mPool.submit([this, module] { load(*module); });
+ return module;
+}
+
+void ModuleLoader::load(Module &module) {
+ auto eFileInfo {mFileMgr.readFile(module.path)};
+ if (!eFileInfo) {
+  fail(module.path.string() + ": " +
+       eFileInfo.takeError<BasicError>().userFriendlyMessage());
+  return;
+ }
+
+ module.srcInfo = mSrcMgr.addFile(*eFileInfo);
+ module.tokBuf.emplace(lex(module.srcInfo, mIdTable, module.diagMgr));
+ module.ast.emplace(parse(*module.tokBuf, module.diagMgr));
+
+ // Every import is resolved statically wherever it appears, so the whole graph
+ // is known before anything runs.
+ ast::Ast const             &ast {*module.ast};
+ std::filesystem::path const dir {module.path.parent_path()};
+ for (std::size_t i = 0; i < ast.count<ast::Import>(); ++i) {
+  std::filesystem::path const path {
+    ast.tokBuf()[ast.get<ast::Import>(i).pathTok]
+      .get<token::String>()
+      .string()};
+
+  Module *imported {request(dir / path)};
+  if (!imported) imported = request(path);
+  if (imported)
+   module.imports.push_back(imported);
+  else
+   fail(module.path.string() + ": Couldn't find module \"" + path.string() +
+        "\"");
+ }
+}
+
+[[nodiscard]] Expect<std::vector<Module *>> ModuleLoader::load(
+  std::vector<std::filesystem::path> const &paths) {
+ std::vector<Module *> roots;
+ for (auto &path : paths)
+  if (Module *module = request(path))
+   roots.push_back(module);
+  else
+   fail(BasicError {"Couldn't find file \"" + path.string() + "\""});
+ mPool.wait();
+ if (mError) return std::move(*mError);
+
+ // Depth first search from every root in order, appending modules once their
+ // imports were. Reaching a module still on the search path closes a cycle.
+ enum class Mark { VISITING, DONE };
+ std::unordered_map<Module const *, Mark> marks;
+ std::vector<Module *>                    order, stack;
+ std::function<Expect<Unit>(Module *)> visit {[&](Module *module)
+                                                  -> Expect<Unit> {
+  auto [it, added] = marks.try_emplace(module, Mark::VISITING);
+  if (!added) {
+   if (Mark::DONE == it->second) return unit;
+
+   std::string cycle {"Import cycle: "};
+   for (auto i = std::find(stack.begin(), stack.end(), module);
+        i != stack.end(); ++i)
+    cycle += (*i)->path.string() + " -> ";
+   return BasicError {cycle + module->path.string()};
+  }
+
+  stack.push_back(module);
+  for (Module *imported : module->imports)
+   if (auto eVisited = visit(imported); !eVisited)
+    return eVisited.takeError<BasicError>();
+  stack.pop_back();
+
+  marks[module] = Mark::DONE;
+  order.push_back(module);
+  return unit;
+ }};
+ for (Module *root : roots)
+  if (auto eVisited = visit(root); !eVisited)
+   return eVisited.takeError<BasicError>();
+
+ return order;
+}
+
+} // namespace plush::driver
@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_DRIVER_MODULELOADER_H
+#define PLUSH_DRIVER_MODULELOADER_H
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/FileManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "bits/Expect.h"
+#include "bits/ThreadPool.h"
+#include "lexer/TokenBuffer.h"
+#include "parser/Ast.h"
+
+namespace plush::driver {
+
+// Source file loaded along with its tokens and tree.
+struct Module {
+ // Canonical path, identifying the module.
+ std::filesystem::path path;
+ SourceInfo           *srcInfo {nullptr};
+ // Diagnostics of lexing and parsing the module.
+ DiagnosticsManager         diagMgr;
+ std::optional<TokenBuffer> tokBuf;
+ std::optional<ast::Ast>    ast;
+ // Modules imported by each import statement, in statement order.
+ std::vector<Module *> imports;
+};
+
+// Loads modules along with every module they import, transitively. Imports
+// are resolved relative to the importing module's directory first, then like
+// FileManager::readFile. Modules are read, lexed and parsed on a thread pool
+// as soon as they're discovered, so independent modules load in parallel.
+// Each module is loaded once, identified by its canonical path.
+class ModuleLoader final {
+ FileManager   &mFileMgr;
+ SourceManager &mSrcMgr;
+ // Shared by every module, must be concurrent if the pool has more than one
+ // thread.
+ IdTable    &mIdTable;
+ ThreadPool &mPool;
+
+ // Guards every member below.
+ std::mutex mMutex;
+ // Every module, in discovery order.
+ std::vector<std::unique_ptr<Module>> mModules;
+ // Module of each canonical path.
+ std::unordered_map<std::string, Module *> mPaths;
+ // First error encountered, loading continues but its result is dropped.
+ std::optional<BasicError> mError;
+
+ void fail(BasicError &&error);
+
+ // Finds the module at the provided path, adding and queueing it to be loaded
+ // if it's new. Returns nullptr if no file exists there.
+ Module *request(std::filesystem::path const &path);
+ // Reads, lexes and parses a module, then requests its imports.
+ void load(Module &module);
+
+public:
+ ModuleLoader(FileManager &fileMgr, SourceManager &srcMgr, IdTable &idTable,
+              ThreadPool &pool);
+ ModuleLoader(ModuleLoader &&)                 = delete;
+ ModuleLoader(ModuleLoader const &)            = delete;
+ ModuleLoader &operator=(ModuleLoader &&)      = delete;
+ ModuleLoader &operator=(ModuleLoader const &) = delete;
+
+ // Loads the modules at the provided paths and every module they import.
+ // Returns every loaded module with imported modules ordered before the
+ // modules importing them, and otherwise in the order of the provided paths
+ // and import statements. Fails if a module is missing or imports itself
+ // through a cycle. Lexing and parsing diagnostics are left within each
+ // module's diagnostics manager.
+ [[nodiscard]] Expect<std::vector<Module *>> load(
+   std::vector<std::filesystem::path> const &paths);
+};
+
+} // namespace plush::driver
+
+#endif // PLUSH_DRIVER_MODULELOADER_H
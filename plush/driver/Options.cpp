@@ -1,10 +1,19 @@
 // SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <charconv>
+#include <string>
+
 #include "driver/Options.h"
 
 namespace plush::driver {
 
+// Parses a whole argument as a count.
+static bool parseCount(std::string_view arg, std::size_t &count) {
+ auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), count);
+ return ec == std::errc {} && ptr == arg.data() + arg.size();
+}
+
 Expect<Options> Options::parseArgs(int argc, char **argv) {
  Options opt;
 
@@ -12,7 +21,26 @@ Expect<Options> Options::parseArgs(int argc, char **argv) {
   std::string_view arg {argv[i]};
   if (arg == "--debug")
    opt.debugEnabled = true;
-  else
+  else if (arg == "--threads") {
+   if (++i == argc) return BasicError {"Expected thread count"};
+
+   if (!parseCount(argv[i], opt.threadCount))
+    return BasicError {"Invalid thread count: " + std::string {argv[i]}};
+  } else if (arg == "--jobs") {
+   if (++i == argc) return BasicError {"Expected job count"};
+
+   if (!parseCount(argv[i], opt.jobs))
+    return BasicError {"Invalid job count: " + std::string {argv[i]}};
+  } else if (arg == "--prelude") {
+   if (++i == argc) return BasicError {"Expected prelude path"};
+   opt.preludePath = argv[i];
+  } else if (arg == "--snapshot") {
+   if (++i == argc) return BasicError {"Expected snapshot path"};
+   opt.snapshotPath = argv[i];
+  } else if (arg == "-I") {
+   if (++i == argc) return BasicError {"Expected lookup directory"};
+   opt.lookupDirs.push_back(argv[i]);
+  } else
    opt.filePaths.push_back(arg);
  }
 
@@ -6,7 +6,9 @@
 #ifndef PLUSH_DRIVER_OPTIONS_H
 #define PLUSH_DRIVER_OPTIONS_H
 
+#include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <vector>
 
 #include "bits/Expect.h"
@@ -16,6 +18,19 @@ namespace plush::driver {
 struct Options {
  bool                               debugEnabled {false};
  std::vector<std::filesystem::path> filePaths;
+ // Number of threads to load input files and their imported modules with, 0
+ // uses every hardware thread.
+ std::size_t threadCount {0};
+ // Plush source run before the input files, if any.
+ std::optional<std::filesystem::path> preludePath;
+ // Startup image of the identifiers and compiled prelude, mapped instead of
+ // compiling the prelude when up to date and saved otherwise.
+ std::optional<std::filesystem::path> snapshotPath;
+ // Directories to look through for files and imported modules.
+ std::vector<std::filesystem::path> lookupDirs;
+ // Number of workers running independent top level statements concurrently,
+ // each statement's output being buffered. 0 runs statements one at a time.
+ std::size_t jobs {0};
 
  static Expect<Options> parseArgs(int argc, char **argv);
 };
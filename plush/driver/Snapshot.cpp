@@ -0,0 +1,373 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bits/hash.h"
+#include "bits/platform.h"
+#include "driver/Snapshot.h"
+#include "vm/Builtins.h"
+
+#ifdef PLUSH_POSIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace plush::driver {
+
+namespace {
+
+// Bumped whenever the layout below changes.
+constexpr std::uint32_t VERSION {2};
+
+constexpr char MAGIC[8] {'P', 'L', 'U', 'S', 'H', 'I', 'M', 'G'};
+
+// An image is the header followed by each section in the order below, ending
+// with the blob holding every string.
+struct Header {
+ char          magic[8];
+ std::uint64_t fingerprint;
+ // Hash of everything following the header, so a corrupted image is rejected
+ // before its code is checked and run.
+ std::uint64_t checksum;
+ std::uint32_t idSize, codeSize, stringSize, commandSize, blobSize, reserved;
+};
+
+struct ImageId {
+ std::uint64_t hash;
+ std::uint32_t offset, size;
+ // Keyword kind, or -1 if the identifier isn't a keyword.
+ std::int32_t  keywordKind;
+ std::uint32_t reserved;
+};
+
+struct ImageString {
+ std::uint32_t offset, size;
+};
+
+struct ImageCommand {
+ std::uint32_t begin, end;
+};
+
+// Views over the sections of an image.
+struct Sections {
+ Header const       *header;
+ ImageId const      *ids;
+ std::uint32_t const *code;
+ ImageString const  *strings;
+ ImageCommand const *commands;
+ char const         *blob;
+};
+
+// Size of an image with the provided header.
+constexpr std::size_t imageSize(Header const &header) {
+ return sizeof(Header) + header.idSize * sizeof(ImageId) +
+        header.codeSize * sizeof(std::uint32_t) +
+        header.stringSize * sizeof(ImageString) +
+        header.commandSize * sizeof(ImageCommand) + header.blobSize;
+}
+
+// Locates the sections of an image whose size was checked.
+Sections sections(char const *data) {
+ Sections s;
+ s.header = reinterpret_cast<Header const *>(data);
+ data += sizeof(Header);
+ s.ids = reinterpret_cast<ImageId const *>(data);
+ data += s.header->idSize * sizeof(ImageId);
+ s.code = reinterpret_cast<std::uint32_t const *>(data);
+ data += s.header->codeSize * sizeof(std::uint32_t);
+ s.strings = reinterpret_cast<ImageString const *>(data);
+ data += s.header->stringSize * sizeof(ImageString);
+ s.commands = reinterpret_cast<ImageCommand const *>(data);
+ data += s.header->commandSize * sizeof(ImageCommand);
+ s.blob = data;
+ return s;
+}
+
+// Checks that the code of an image whose other sections were checked only
+// refers to what exists: opcodes within the opcode tables, operand words within
+// the code, registers within a frame, builtins, strings and commands within
+// their sections, and jumps to the start of an instruction. The code must end
+// with a halt or a jump, so it never runs past its end.
+bool validCode(Sections const &s) {
+ using namespace vm;
+ std::uint32_t const size {s.header->codeSize};
+ if (!size) return true;
+
+ std::vector<bool>          starts(size);
+ std::vector<std::uint32_t> targets;
+ Op                         last {HALT};
+ for (std::uint32_t offset = 0; offset < size;) {
+  Op const op {opOf(s.code[offset])};
+  if (op >= OP_SIZE || OP_OPERAND_TABLE[op] >= size - offset) return false;
+
+  std::uint32_t const *operands {s.code + offset + 1};
+  switch (op) {
+  case PIPE:
+   // The write end goes to the register after A.
+   if (aOf(s.code[offset]) >= REG_SIZE - 1) return false;
+   break;
+  case SPAWN:
+  case LAUNCH:
+   if (operands[0] >= s.header->commandSize) return false;
+   break;
+  case BUILTIN:
+  case START:
+   if (operands[0] >= BUILTINS.size() ||
+       operands[1] >= s.header->commandSize)
+    return false;
+   break;
+  case CAPTURE:
+   if (operands[0] >= s.header->stringSize) return false;
+   break;
+  case JUMP:
+  case JUMPFAIL: targets.push_back(operands[0]); break;
+  default: break;
+  }
+
+  starts[offset] = true;
+  last           = op;
+  offset += 1 + OP_OPERAND_TABLE[op];
+ }
+
+ for (std::uint32_t target : targets)
+  if (target >= size || !starts[target]) return false;
+ return HALT == last || JUMP == last;
+}
+
+#ifdef PLUSH_POSIX
+// Reads a whole file.
+Expect<std::string> readFile(std::filesystem::path const &path) {
+ int fd {::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+ if (fd < 0) return BasicError {path.string() + ": " + std::strerror(errno)};
+ std::string content;
+ char        buffer[1 << 14];
+ for (;;) {
+  ssize_t n {::read(fd, buffer, sizeof buffer)};
+  if (n < 0) {
+   if (EINTR == errno) continue;
+   BasicError error {path.string() + ": " + std::strerror(errno)};
+   ::close(fd);
+   return error;
+  }
+  if (!n) break;
+  content.append(buffer, n);
+ }
+ ::close(fd);
+ return content;
+}
+#endif
+
+// Appends the bytes of an object to an image.
+template <typename T>
+void append(std::string &image, T const &value) {
+ image.append(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+
+} // namespace
+
+[[nodiscard]] Expect<std::uint64_t>
+Snapshot::fingerprint(std::optional<std::filesystem::path> const &preludePath) {
+ // The fingerprint covers every table bytecode and identifiers refer to by
+ // index or kind, a rebuild changing any of them invalidates images instead of
+ // misinterpreting them.
+ std::string key {std::to_string(VERSION)};
+ key += ':';
+ key += std::to_string(sizeof(std::size_t));
+ for (auto &kw : token::KEYWORDS) {
+  key += ':';
+  key += kw.stringRep();
+  key += std::to_string(kw.kind());
+ }
+ for (std::size_t i = 0; i < vm::OP_SIZE; ++i) {
+  key += ':';
+  key += vm::OP_NAME_TABLE[i];
+  key += std::to_string(vm::OP_REG_TABLE[i]);
+  key += std::to_string(vm::OP_OPERAND_TABLE[i]);
+ }
+ for (auto &builtin : vm::BUILTINS) {
+  key += ':';
+  key += builtin.name;
+ }
+
+ // The prelude is identified by its content rather than by its modification
+ // time, which may not change along with it. Preludes are small, hashing one
+ // costs little next to lexing and compiling it.
+ if (preludePath) {
+#ifdef PLUSH_POSIX
+  auto eContent {readFile(*preludePath)};
+  if (!eContent) return eContent.takeError<BasicError>();
+  key += ':';
+  key += std::to_string((*eContent).size());
+  key += ':';
+  key += std::to_string(hash::fnv1a(*eContent));
+#else
+  return BasicError {"Snapshots are unsupported on this platform"};
+#endif
+ }
+
+ return hash::fnv1a(key);
+}
+
+[[nodiscard]] Expect<Snapshot> Snapshot::map(std::filesystem::path const &path,
+                                             std::uint64_t fingerprint) {
+#ifdef PLUSH_POSIX
+ int fd {::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+ if (fd < 0) return BasicError {path.string() + ": " + std::strerror(errno)};
+ struct stat st;
+ if (::fstat(fd, &st)) {
+  ::close(fd);
+  return BasicError {path.string() + ": " + std::strerror(errno)};
+ }
+ auto eFile {MappedFile::map(fd, st.st_size)};
+ ::close(fd);
+ if (!eFile) return eFile.takeError<BasicError>();
+
+ std::string_view content {(*eFile).content()};
+ BasicError       malformed {path.string() + ": Malformed snapshot"};
+ if (content.size() < sizeof(Header)) return malformed;
+
+ Header const &header {*reinterpret_cast<Header const *>(content.data())};
+ if (std::memcmp(header.magic, MAGIC, sizeof MAGIC)) return malformed;
+ if (header.fingerprint != fingerprint)
+  return BasicError {path.string() + ": Stale snapshot"};
+ if (imageSize(header) != content.size() ||
+     header.checksum != hash::fnv1a(content.substr(sizeof(Header))))
+  return malformed;
+
+ // Every string must lie within the blob, every command within the strings
+ // and the code may only refer to them, since the Vm runs it unchecked.
+ Sections s {sections(content.data())};
+ for (std::uint32_t i = 0; i < header.idSize; ++i)
+  if (s.ids[i].offset > header.blobSize ||
+      s.ids[i].size > header.blobSize - s.ids[i].offset)
+   return malformed;
+ for (std::uint32_t i = 0; i < header.stringSize; ++i)
+  if (s.strings[i].offset > header.blobSize ||
+      s.strings[i].size > header.blobSize - s.strings[i].offset)
+   return malformed;
+ for (std::uint32_t i = 0; i < header.commandSize; ++i)
+  if (s.commands[i].begin > s.commands[i].end ||
+      s.commands[i].end > header.stringSize)
+   return malformed;
+ if (!validCode(s)) return malformed;
+
+ return Snapshot {std::move(*eFile)};
+#else
+ return BasicError {"Snapshots are unsupported on this platform"};
+#endif
+}
+
+[[nodiscard]] Expect<Unit> Snapshot::save(std::filesystem::path const &path,
+                                          std::uint64_t          fingerprint,
+                                          IdTable const         &idTable,
+                                          vm::Chunk const       *prelude) {
+#ifdef PLUSH_POSIX
+ std::string ids, blob;
+ Header      header {};
+ std::memcpy(header.magic, MAGIC, sizeof MAGIC);
+ header.fingerprint = fingerprint;
+
+ idTable.forEach([&](IdInfo const &idInfo, std::size_t idHash) {
+  append(ids, ImageId {idHash, static_cast<std::uint32_t>(blob.size()),
+                       static_cast<std::uint32_t>(idInfo.stringRep().size()),
+                       idInfo.isKeyword() ? idInfo.keywordKind() : -1, 0});
+  blob += idInfo.stringRep();
+  ++header.idSize;
+ });
+
+ std::string strings, commands;
+ if (prelude) {
+  header.codeSize = prelude->code().size();
+  for (std::string_view string : prelude->strings()) {
+   append(strings, ImageString {static_cast<std::uint32_t>(blob.size()),
+                                static_cast<std::uint32_t>(string.size())});
+   blob += string;
+  }
+  header.stringSize = prelude->strings().size();
+  for (auto [begin, end] : prelude->commands())
+   append(commands, ImageCommand {begin, end});
+  header.commandSize = prelude->commands().size();
+ }
+ header.blobSize = blob.size();
+
+ std::string image;
+ image.reserve(imageSize(header));
+ append(image, header);
+ image += ids;
+ if (prelude)
+  image.append(reinterpret_cast<char const *>(prelude->code().data()),
+               header.codeSize * sizeof(std::uint32_t));
+ image += strings;
+ image += commands;
+ image += blob;
+ std::uint64_t const checksum {
+   hash::fnv1a(std::string_view {image}.substr(sizeof(Header)))};
+ std::memcpy(image.data() + offsetof(Header, checksum), &checksum,
+             sizeof checksum);
+
+ std::string tmpPath {path.string() + ".tmp" + std::to_string(::getpid())};
+ int fd {::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0644)};
+ if (fd < 0) return BasicError {tmpPath + ": " + std::strerror(errno)};
+ for (std::string_view rest {image}; !rest.empty();) {
+  ssize_t n {::write(fd, rest.data(), rest.size())};
+  if (n < 0) {
+   if (EINTR == errno) continue;
+   BasicError error {tmpPath + ": " + std::strerror(errno)};
+   ::close(fd);
+   ::unlink(tmpPath.c_str());
+   return error;
+  }
+  rest.remove_prefix(n);
+ }
+ ::close(fd);
+
+ if (::rename(tmpPath.c_str(), path.c_str())) {
+  BasicError error {path.string() + ": " + std::strerror(errno)};
+  ::unlink(tmpPath.c_str());
+  return error;
+ }
+ return unit;
+#else
+ return BasicError {"Snapshots are unsupported on this platform"};
+#endif
+}
+
+void Snapshot::restore(IdTable &idTable) const {
+ Sections s {sections(mFile.content().data())};
+ for (std::uint32_t i = 0; i < s.header->idSize; ++i) {
+  ImageId const &id {s.ids[i]};
+  std::optional<enum token::Keyword::Kind> optKeywordKind;
+  if (id.keywordKind >= 0)
+   optKeywordKind = static_cast<enum token::Keyword::Kind>(id.keywordKind);
+  idTable.restore({s.blob + id.offset, id.size}, optKeywordKind, id.hash);
+ }
+}
+
+std::optional<vm::Chunk> Snapshot::prelude() const {
+ Sections s {sections(mFile.content().data())};
+ if (!s.header->codeSize) return std::nullopt;
+
+ std::vector<std::string_view> strings;
+ strings.reserve(s.header->stringSize);
+ for (std::uint32_t i = 0; i < s.header->stringSize; ++i)
+  strings.emplace_back(s.blob + s.strings[i].offset, s.strings[i].size);
+
+ std::vector<std::pair<std::uint32_t, std::uint32_t>> commands;
+ commands.reserve(s.header->commandSize);
+ for (std::uint32_t i = 0; i < s.header->commandSize; ++i)
+  commands.emplace_back(s.commands[i].begin, s.commands[i].end);
+
+ return vm::Chunk {{s.code, s.code + s.header->codeSize},
+                   std::move(strings),
+                   std::move(commands)};
+}
+
+} // namespace plush::driver
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_DRIVER_SNAPSHOT_H
+#define PLUSH_DRIVER_SNAPSHOT_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include "basic/IdTable.h"
+#include "bits/Expect.h"
+#include "bits/MappedFile.h"
+#include "bits/Unit.h"
+#include "vm/Bytecode.h"
+
+namespace plush::driver {
+
+// Startup image holding every interned identifier and the compiled prelude.
+// An image is saved once, later launches map it read-only and restore the
+// identifiers with their precomputed hashes and the prelude's bytecode
+// without lexing, parsing or compiling anything. Restored strings refer to the
+// mapping, which must outlive the IdTable and prelude restored from it.
+//
+// Images are laid out in native byte order and only valid for the fingerprint
+// they were saved with, see fingerprint.
+class Snapshot final {
+ MappedFile mFile;
+
+ explicit Snapshot(MappedFile &&file) : mFile {std::move(file)} {}
+
+public:
+ // Fingerprint of the running build's keyword, opcode and builtin tables and
+ // of the prelude file's content, if any. Images saved with any other
+ // fingerprint are stale.
+ [[nodiscard]] static Expect<std::uint64_t>
+ fingerprint(std::optional<std::filesystem::path> const &preludePath);
+
+ // Maps the image at the provided path, failing if it is missing, stale,
+ // corrupted or malformed.
+ [[nodiscard]] static Expect<Snapshot> map(std::filesystem::path const &path,
+                                           std::uint64_t fingerprint);
+
+ // Saves the identifiers of an IdTable and the prelude, if any. The image is
+ // written next to the path and renamed over it, so concurrent launches never
+ // map a partially written image.
+ [[nodiscard]] static Expect<Unit> save(std::filesystem::path const &path,
+                                        std::uint64_t           fingerprint,
+                                        IdTable const          &idTable,
+                                        vm::Chunk const        *prelude);
+
+ // Adds every saved identifier to an IdTable constructed empty, reproducing
+ // their indices.
+ void restore(IdTable &idTable) const;
+ // Retrieves the saved prelude, if any.
+ std::optional<vm::Chunk> prelude() const;
+};
+
+} // namespace plush::driver
+
+#endif // PLUSH_DRIVER_SNAPSHOT_H
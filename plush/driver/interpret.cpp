@@ -1,59 +1,180 @@
 // SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <optional>
+#include <vector>
+
 #include "basic/IdTable.h"
 #include "basic/SourceManager.h"
+#include "driver/ModuleLoader.h"
+#include "driver/Snapshot.h"
 #include "driver/interpret.h"
+#include "bits/ThreadPool.h"
+#include "bits/WorkStealingPool.h"
 #include "lexer/lex.h"
+#include "parser/parse.h"
+#include "vm/Schedule.h"
+#include "vm/Vm.h"
+#include "vm/compile.h"
 
 namespace plush::driver {
 
-Expect<> interpret(Options const &options) {
- DiagnosticsManager diagMgr;
- FileManager        fileMgr;
- FileInfo          *fileInfo {nullptr};
-
- for (auto &filePath : options.filePaths) {
-  auto eFileInfo = fileMgr.readFile(filePath);
-  if (!eFileInfo)
-   // Filepath couldn't be opened.
-   return eFileInfo.takeError<BasicError>();
-  else if (fileInfo)
-   // Driver was provided too many files.
-   return BasicError {"Invalid file inputs: " + eFileInfo->filePath().string()};
-  else
-   fileInfo = *eFileInfo;
- }
-
- if (!fileInfo) {
+Expect<int> interpret(Options const &options) {
+ if (options.filePaths.empty()) {
   // TODO(m4xine): Accept stdin instead of just files.
   return BasicError {"Expected file input"};
  }
 
- IdTable       idTable;
+ FileManager   fileMgr;
  SourceManager srcMgr;
- SourceInfo   *srcInfo {srcMgr.addFile(fileInfo)};
+ for (auto &lookupDir : options.lookupDirs) fileMgr.addLookupDir(lookupDir);
+
+ std::size_t threadCount {options.threadCount
+                            ? options.threadCount
+                            : ThreadPool::defaultThreadCount()};
+
+ // An up to date snapshot restores the identifiers and prelude of a previous
+ // launch. Otherwise the prelude is compiled and a snapshot is saved before
+ // input files are lexed, so it never holds their identifiers.
+ std::optional<std::uint64_t> optFingerprint;
+ std::optional<Snapshot>      optSnapshot;
+ if (options.snapshotPath) {
+  auto eFingerprint {Snapshot::fingerprint(options.preludePath)};
+  if (!eFingerprint) return eFingerprint.takeError<BasicError>();
+  optFingerprint = *eFingerprint;
+  if (auto eSnapshot = Snapshot::map(*options.snapshotPath, *optFingerprint))
+   optSnapshot.emplace(std::move(*eSnapshot));
+ }
 
- auto tokBuf {lex(srcInfo, idTable, diagMgr)};
- if (diagMgr.dump()) return BasicError {"Too many errors"};
+ IdTable idTable {IdTable::EmptyTag {}, threadCount > 1};
+ if (optSnapshot)
+  optSnapshot->restore(idTable);
+ else
+  idTable.addKeywords();
+ vm::BuiltinRegistry builtins {idTable};
+
+ std::optional<vm::Chunk>   optPrelude;
+ std::optional<TokenBuffer> optPreludeTokBuf;
+ if (optSnapshot)
+  optPrelude = optSnapshot->prelude();
+ else {
+  if (options.preludePath) {
+   auto eFileInfo = fileMgr.readFile(*options.preludePath);
+   if (!eFileInfo) return eFileInfo.takeError<BasicError>();
+
+   DiagnosticsManager diagMgr;
+   optPreludeTokBuf.emplace(
+     lex(srcMgr.addFile(*eFileInfo), idTable, diagMgr));
+   ast::Ast ast {parse(*optPreludeTokBuf, diagMgr)};
+   if (diagMgr.dump()) return BasicError {"Too many errors"};
+
+   auto eChunk {vm::compile(ast, builtins)};
+   if (!eChunk) return eChunk.takeError<BasicError>();
+   optPrelude.emplace(std::move(*eChunk));
+  }
+
+  // Failing to save only costs the next launch a compilation.
+  if (options.snapshotPath)
+   (void)Snapshot::save(*options.snapshotPath, *optFingerprint, idTable,
+                        optPrelude ? &*optPrelude : nullptr);
+ }
+
+ // Input files and the modules they import are loaded in parallel, each with
+ // its own diagnostic manager. Diagnostics are dumped in run order afterwards.
+ ThreadPool   pool {threadCount};
+ ModuleLoader loader {fileMgr, srcMgr, idTable, pool};
+ auto         eModules {loader.load(options.filePaths)};
+ if (!eModules) return eModules.takeError<BasicError>();
+ std::vector<Module *> const &modules {*eModules};
+
+ bool errorLimitReached {false};
+ for (Module *module : modules)
+  if (module->diagMgr.dump()) errorLimitReached = true;
+ if (errorLimitReached) return BasicError {"Too many errors"};
+
+ // With jobs, each module's statements are compiled separately and scheduled by
+ // their dependencies instead.
+ std::vector<vm::Chunk>    chunks;
+ std::vector<vm::Schedule> schedules;
+ for (Module *module : modules)
+  if (options.jobs) {
+   auto eSchedule {vm::Schedule::analyze(*module->ast, builtins)};
+   if (!eSchedule) return eSchedule.takeError<BasicError>();
+   schedules.push_back(std::move(*eSchedule));
+  } else {
+   auto eChunk {vm::compile(*module->ast, builtins)};
+   if (!eChunk) return eChunk.takeError<BasicError>();
+   chunks.push_back(std::move(*eChunk));
+  }
 
  if (options.debugEnabled) {
-  std::cout << "Displaying " << tokBuf.tokens().size() << " tokens:\n";
+  using namespace doc;
 
-  doc::List list;
-  for (auto &tok : tokBuf) {
-   using namespace doc;
-   list += hpad(4) + tok.doc();
+  // Tokens are streamed straight to stdout, reusing a single document for each
+  // of them.
+  DocWriter writer {1};
+  Doc       d;
+  if (optPrelude) {
+   writer.line(text("Disassembling ") + integer(optPrelude->code().size()) +
+               text(" prelude words:"));
+   optPrelude->disassemble(writer);
   }
+  for (std::size_t i = 0; i < modules.size(); ++i) {
+   auto &tokBuf {*modules[i]->tokBuf};
+   writer.line(text("Displaying ") + integer(tokBuf.size()) + text(" tokens:"));
+
+   for (auto tok : tokBuf) {
+    d.clear();
+    d += hpad(4);
+    d += tok.doc();
+    writer.line(d);
+   }
 
-  DocStyle docStyle {};
-  docStyle.listSeperator = "\n";
-  list.display(docStyle);
+   writer.line(text("Displayed ") + integer(tokBuf.size()) + text(" tokens."));
 
-  std::cout << "Displayed " << tokBuf.tokens().size() << " tokens.\n";
+   if (options.jobs)
+    for (std::size_t j = 0; j < schedules[i].size(); ++j) {
+     vm::Chunk const &chunk {schedules[i].chunk(j)};
+     writer.line(text("Disassembling ") + integer(chunk.code().size()) +
+                 text(" words of statement ") + integer(j) + text(":"));
+     chunk.disassemble(writer);
+    }
+   else {
+    writer.line(text("Disassembling ") + integer(chunks[i].code().size()) +
+                text(" words:"));
+    chunks[i].disassemble(writer);
+   }
+  }
+ }
+
+ // Modules run once each after the prelude, imported modules before the modules
+ // importing them, sharing the environment built by their let statements.
+ // Running exit anywhere stops every later module.
+ vm::Vm vm;
+ int    status {0};
+ if (optPrelude) {
+  auto eStatus {vm.run(*optPrelude)};
+  if (!eStatus) return eStatus.takeError<BasicError>();
+  status = *eStatus;
+  if (vm.exited()) return status;
+ }
+ for (auto &chunk : chunks) {
+  auto eStatus {vm.run(chunk)};
+  if (!eStatus) return eStatus.takeError<BasicError>();
+  status = *eStatus;
+  if (vm.exited()) return status;
+ }
+ if (options.jobs) {
+  WorkStealingPool jobPool {options.jobs};
+  for (auto &schedule : schedules) {
+   auto eStatus {schedule.run(vm, jobPool)};
+   if (!eStatus) return eStatus.takeError<BasicError>();
+   status = *eStatus;
+   if (vm.exited()) return status;
+  }
  }
 
- return unit;
+ return status;
 }
 
 } // namespace plush::driver
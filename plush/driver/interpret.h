@@ -11,8 +11,12 @@
 
 namespace plush::driver {
 
-// Runs Plush as an interpreter with the provided options.
-Expect<> interpret(Options const &options);
+// Runs Plush as an interpreter with the provided options, running every input
+// file in order along with the modules they import. Every module runs once,
+// after the modules it imports. With jobs, the independent statements of each
+// module run concurrently, see vm::Schedule. Returns the exit status of the
+// last statement run.
+Expect<int> interpret(Options const &options);
 
 } // namespace plush::driver
 
@@ -0,0 +1,506 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "bits/Fd.h"
+#include "bits/platform.h"
+#include "exec/EventLoop.h"
+
+#ifdef PLUSH_POSIX
+#include <climits>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace plush::exec {
+
+using Op = EventLoop::Op;
+
+// Interval between polls of processes awaited without a pidfd.
+constexpr int CHILD_POLL_MS {5};
+
+namespace {
+
+#ifdef PLUSH_POSIX
+// Descriptor an operation waits on and whether it waits for it to become
+// writable rather than readable.
+std::pair<int, bool> pollTarget(Op const &op) {
+ if (Op::SPLICE == op.kind && op.blocked) return {op.out, true};
+ return {op.fd, Op::WRITE == op.kind};
+}
+
+// Reads, writes or splices once, returning false if the descriptor is
+// non-blocking and not ready. Writes to a descriptor polled as writable are
+// capped to PIPE_BUF bytes, which a pipe polled as writable always has room
+// for, so they never block. Splices never block, a splice finding the side it
+// didn't wait on not ready waits on that side next.
+bool perform(Op &op, bool polled) {
+ for (;;) {
+  ssize_t n;
+  if (Op::READ == op.kind)
+   n = ::read(op.fd, op.data, op.size);
+  else if (Op::WRITE == op.kind)
+   n = ::write(op.fd, op.data,
+               polled ? std::min<std::size_t>(op.size, PIPE_BUF) : op.size);
+  else {
+#ifdef __linux__
+   n = ::splice(op.fd, nullptr, op.out, nullptr, op.size,
+                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+#else
+   n     = -1;
+   errno = EINVAL;
+#endif
+  }
+  if (n >= 0) {
+   op.result = static_cast<int>(std::min<ssize_t>(n, INT_MAX));
+   return true;
+  }
+  if (EINTR == errno) continue;
+  if (EAGAIN == errno || EWOULDBLOCK == errno) {
+   if (Op::SPLICE == op.kind) op.blocked = !op.blocked;
+   return false;
+  }
+  op.result = -errno;
+  return true;
+ }
+}
+#endif
+
+#ifdef __linux__
+// Submits operations through the rings shared with the kernel, reading,
+// writing and splicing without waiting for readiness first and polling pidfds.
+class IoUringPoller final : public EventLoop::Poller {
+ Fd            mRing;
+ void         *mSqRing {MAP_FAILED}, *mCqRing {MAP_FAILED};
+ std::size_t   mSqRingSize {0}, mCqRingSize {0};
+ io_uring_sqe *mSqes {static_cast<io_uring_sqe *>(MAP_FAILED)};
+ std::size_t   mSqesSize {0};
+ unsigned     *mSqHead, *mSqTail, *mSqArray, mSqMask, mSqEntries;
+ unsigned     *mCqHead, *mCqTail, mCqMask;
+ io_uring_cqe *mCqes;
+ // Number of queued entries the kernel wasn't told about yet.
+ unsigned mUnsubmitted {0};
+ // Timeout of the pending wait, copied by the kernel upon submission.
+ __kernel_timespec mTimeout {};
+
+ int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+  return static_cast<int>(::syscall(SYS_io_uring_enter, mRing.get(), toSubmit,
+                                    minComplete, flags, nullptr, 0));
+ }
+
+ // Submits every queued entry, optionally waiting for a completion.
+ Expect<Unit> flush(bool wait) {
+  for (;;) {
+   int n {enter(mUnsubmitted, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0)};
+   if (n >= 0) {
+    mUnsubmitted -= std::min<unsigned>(n, mUnsubmitted);
+    return unit;
+   }
+   if (EINTR == errno) {
+    if (wait) return unit;
+    continue;
+   }
+   // Completions are piling up, they're reaped first.
+   if (EBUSY == errno || EAGAIN == errno) return unit;
+   return BasicError {std::strerror(errno)};
+  }
+ }
+
+ // Queues an entry, submitting queued entries first if the ring is full.
+ io_uring_sqe *queue() {
+  unsigned tail {*mSqTail};
+  while (tail - __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE) == mSqEntries)
+   if (!flush(false)) return nullptr;
+  unsigned const index {tail & mSqMask};
+  io_uring_sqe  *sqe {&mSqes[index]};
+  std::memset(sqe, 0, sizeof *sqe);
+  mSqArray[index] = index;
+  __atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+  ++mUnsubmitted;
+  return sqe;
+ }
+
+ void reap(std::vector<Op *> &completed) {
+  unsigned       head {*mCqHead};
+  unsigned const tail {__atomic_load_n(mCqTail, __ATOMIC_ACQUIRE)};
+  for (; head != tail; ++head) {
+   io_uring_cqe const &cqe {mCqes[head & mCqMask]};
+   // Timeouts carry no operation.
+   if (!cqe.user_data) continue;
+   Op *op {reinterpret_cast<Op *>(cqe.user_data)};
+   op->result = cqe.res;
+   completed.push_back(op);
+  }
+  __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+ }
+
+public:
+ // Sets up a ring, returning nullptr if the kernel lacks io_uring or any
+ // operation the loop uses.
+ static std::unique_ptr<EventLoop::Poller> open() {
+  io_uring_params params {};
+  // Every pipeline stage may have a read or write in flight, a larger
+  // completion ring keeps them from overflowing it.
+  params.flags      = IORING_SETUP_CQSIZE;
+  params.cq_entries = 4096;
+  int fd {static_cast<int>(::syscall(SYS_io_uring_setup, 256, &params))};
+  if (fd < 0) return nullptr;
+  auto poller {std::make_unique<IoUringPoller>()};
+  poller->mRing = Fd {fd};
+
+  // Reads and writes at the current offset need Linux 5.6, as does probing,
+  // splices need Linux 5.7.
+  constexpr unsigned OPS {IORING_OP_LAST};
+  alignas(io_uring_probe) char
+    buffer[sizeof(io_uring_probe) + OPS * sizeof(io_uring_probe_op)] {};
+  auto *probe {reinterpret_cast<io_uring_probe *>(buffer)};
+  if (::syscall(SYS_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+                OPS) < 0)
+   return nullptr;
+  for (unsigned op : {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_POLL_ADD,
+                      IORING_OP_TIMEOUT, IORING_OP_SPLICE})
+   if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+    return nullptr;
+  if (!(params.features & IORING_FEAT_NODROP)) return nullptr;
+
+  poller->mSqRingSize =
+    params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  poller->mCqRingSize =
+    params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool const single {0 != (params.features & IORING_FEAT_SINGLE_MMAP)};
+  if (single)
+   poller->mSqRingSize = poller->mCqRingSize =
+     std::max(poller->mSqRingSize, poller->mCqRingSize);
+  poller->mSqRing = ::mmap(nullptr, poller->mSqRingSize,
+                           PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           fd, IORING_OFF_SQ_RING);
+  if (MAP_FAILED == poller->mSqRing) return nullptr;
+  if (single)
+   poller->mCqRing = poller->mSqRing;
+  else {
+   poller->mCqRing = ::mmap(nullptr, poller->mCqRingSize,
+                            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            fd, IORING_OFF_CQ_RING);
+   if (MAP_FAILED == poller->mCqRing) return nullptr;
+  }
+  poller->mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  poller->mSqes     = static_cast<io_uring_sqe *>(
+    ::mmap(nullptr, poller->mSqesSize, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+  if (MAP_FAILED == poller->mSqes) return nullptr;
+
+  auto *sq {static_cast<char *>(poller->mSqRing)};
+  auto *cq {static_cast<char *>(poller->mCqRing)};
+  auto field {[](char *ring, std::uint32_t offset) {
+   return reinterpret_cast<unsigned *>(ring + offset);
+  }};
+  poller->mSqHead    = field(sq, params.sq_off.head);
+  poller->mSqTail    = field(sq, params.sq_off.tail);
+  poller->mSqArray   = field(sq, params.sq_off.array);
+  poller->mSqMask    = *field(sq, params.sq_off.ring_mask);
+  poller->mSqEntries = params.sq_entries;
+  poller->mCqHead    = field(cq, params.cq_off.head);
+  poller->mCqTail    = field(cq, params.cq_off.tail);
+  poller->mCqMask    = *field(cq, params.cq_off.ring_mask);
+  poller->mCqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  return poller;
+ }
+
+ ~IoUringPoller() {
+  if (MAP_FAILED != mSqes) ::munmap(mSqes, mSqesSize);
+  if (MAP_FAILED != mCqRing && mCqRing != mSqRing)
+   ::munmap(mCqRing, mCqRingSize);
+  if (MAP_FAILED != mSqRing) ::munmap(mSqRing, mSqRingSize);
+ }
+
+ EventLoop::Backend backend() const override {
+  return EventLoop::Backend::IO_URING;
+ }
+
+ bool submit(Op &op) override {
+  io_uring_sqe *sqe {queue()};
+  if (!sqe) {
+   op.result = -errno;
+   return false;
+  }
+  unsigned const size {
+    static_cast<unsigned>(std::min<std::size_t>(op.size, INT_MAX))};
+  sqe->fd        = op.fd;
+  sqe->user_data = reinterpret_cast<std::uint64_t>(&op);
+  if (Op::WAIT == op.kind) {
+   sqe->opcode        = IORING_OP_POLL_ADD;
+   sqe->poll32_events = POLLIN;
+  } else if (Op::SPLICE == op.kind) {
+   sqe->opcode        = IORING_OP_SPLICE;
+   sqe->splice_fd_in  = op.fd;
+   sqe->fd            = op.out;
+   sqe->len           = size;
+   sqe->splice_flags  = SPLICE_F_MOVE;
+   // Neither side has an offset, pipes have none and files use theirs.
+   sqe->splice_off_in = static_cast<std::uint64_t>(-1);
+   sqe->off           = static_cast<std::uint64_t>(-1);
+  } else {
+   sqe->opcode = Op::READ == op.kind ? IORING_OP_READ : IORING_OP_WRITE;
+   sqe->addr   = reinterpret_cast<std::uint64_t>(op.data);
+   sqe->len    = size;
+   // Use and advance the current offset, like read and write.
+   sqe->off = static_cast<std::uint64_t>(-1);
+  }
+  return true;
+ }
+
+ [[nodiscard]] Expect<Unit> wait(int               timeout,
+                                 std::vector<Op *> &completed) override {
+  if (timeout >= 0) {
+   mTimeout.tv_sec  = timeout / 1000;
+   mTimeout.tv_nsec = (timeout % 1000) * 1000000LL;
+   if (io_uring_sqe *sqe = queue()) {
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr   = reinterpret_cast<std::uint64_t>(&mTimeout);
+    sqe->len    = 1;
+   }
+  }
+
+  std::size_t const before {completed.size()};
+  reap(completed);
+  if (auto eFlushed = flush(completed.size() == before); !eFlushed)
+   return eFlushed;
+  reap(completed);
+  return unit;
+ }
+};
+
+// Waits for descriptors to become ready before reading or writing them.
+// Regular files can't be polled and are read and written right away.
+class EpollPoller final : public EventLoop::Poller {
+ Fd                       mEpoll;
+ std::vector<epoll_event> mEvents;
+
+public:
+ static std::unique_ptr<EventLoop::Poller> open() {
+  int fd {::epoll_create1(EPOLL_CLOEXEC)};
+  if (fd < 0) return nullptr;
+  auto poller {std::make_unique<EpollPoller>()};
+  poller->mEpoll = Fd {fd};
+  poller->mEvents.resize(256);
+  return poller;
+ }
+
+ EventLoop::Backend backend() const override {
+  return EventLoop::Backend::EPOLL;
+ }
+
+ bool submit(Op &op) override {
+  auto [fd, writable] = pollTarget(op);
+  epoll_event event {};
+  event.events   = (writable ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+  event.data.ptr = &op;
+  if (!::epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD, fd, &event)) return true;
+
+  // Besides regular files (EPERM), a descriptor already awaited by another
+  // operation (EEXIST) is read or written right away too, possibly blocking. A
+  // splice from a regular file into a full pipe waits for the pipe instead.
+  if (Op::WAIT == op.kind || perform(op, false)) return false;
+  if (Op::SPLICE == op.kind && op.blocked) return submit(op);
+  op.result = -EAGAIN;
+  return false;
+ }
+
+ [[nodiscard]] Expect<Unit> wait(int               timeout,
+                                 std::vector<Op *> &completed) override {
+  int n {::epoll_wait(mEpoll.get(), mEvents.data(),
+                      static_cast<int>(mEvents.size()), timeout)};
+  if (n < 0) {
+   if (EINTR == errno) return unit;
+   return BasicError {std::strerror(errno)};
+  }
+
+  for (int i = 0; i < n; ++i) {
+   Op *op {static_cast<Op *>(mEvents[i].data.ptr)};
+   ::epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL, pollTarget(*op).first, nullptr);
+   // A non-blocking descriptor that's no longer ready is awaited again, as
+   // is a splice whose other side isn't ready.
+   if (Op::WAIT != op->kind && !perform(*op, true)) {
+    if (!submit(*op)) completed.push_back(op);
+    continue;
+   }
+   completed.push_back(op);
+  }
+  return unit;
+ }
+};
+#endif
+
+// Waits for descriptors to become ready with poll, available on every POSIX
+// platform.
+class PollPoller final : public EventLoop::Poller {
+#ifdef PLUSH_POSIX
+ std::vector<pollfd> mFds;
+
+ static pollfd pollFd(Op const &op) {
+  auto [fd, writable] = pollTarget(op);
+  short const events  = writable ? POLLOUT : POLLIN;
+  return {fd, events, 0};
+ }
+#endif
+ std::vector<Op *> mOps;
+
+public:
+ EventLoop::Backend backend() const override {
+  return EventLoop::Backend::POLL;
+ }
+
+ bool submit(Op &op) override {
+#ifdef PLUSH_POSIX
+  mFds.push_back(pollFd(op));
+  mOps.push_back(&op);
+  return true;
+#else
+  op.result = -ENOSYS;
+  return false;
+#endif
+ }
+
+ [[nodiscard]] Expect<Unit> wait(int               timeout,
+                                 std::vector<Op *> &completed) override {
+#ifdef PLUSH_POSIX
+  int n {::poll(mFds.data(), mFds.size(), timeout)};
+  if (n < 0) {
+   if (EINTR == errno) return unit;
+   return BasicError {std::strerror(errno)};
+  }
+
+  for (std::size_t i = 0; i < mFds.size();) {
+   Op *op {mOps[i]};
+   if (!mFds[i].revents ||
+       (Op::WAIT != op->kind && !perform(*op, true))) {
+    mFds[i] = pollFd(*op);
+    ++i;
+    continue;
+   }
+   completed.push_back(op);
+   mFds[i] = mFds.back();
+   mFds.pop_back();
+   mOps[i] = mOps.back();
+   mOps.pop_back();
+  }
+#endif
+  return unit;
+ }
+};
+
+// Opens a descriptor becoming readable once the process exits, returning -1
+// if the kernel can't.
+int openPidFd(Pid pid) {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+ return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+ return -1;
+#endif
+}
+
+// Collects the exit status of a process whose pidfd became readable.
+void reap(Op &op) {
+#ifdef PLUSH_POSIX
+ if (op.fd >= 0) ::close(op.fd);
+#endif
+ auto eStatus {Launcher::wait(op.pid)};
+ op.result = eStatus ? *eStatus : -ECHILD;
+}
+
+} // namespace
+
+EventLoop::EventLoop(Backend preferred) {
+#ifdef __linux__
+ if (Backend::IO_URING == preferred) mPoller = IoUringPoller::open();
+ if (!mPoller && Backend::POLL != preferred) mPoller = EpollPoller::open();
+#endif
+ if (!mPoller) mPoller = std::make_unique<PollPoller>();
+}
+
+EventLoop::~EventLoop() {
+ assert(!mPending && "Destroying a loop with operations in flight");
+}
+
+bool EventLoop::submit(Op &op) {
+ if (Op::WAIT == op.kind) {
+  op.fd = openPidFd(op.pid);
+  if (op.fd < 0) {
+   mChildren.push_back(&op);
+   ++mPending;
+   return true;
+  }
+ }
+ if (mPoller->submit(op)) {
+  ++mPending;
+  return true;
+ }
+ if (Op::WAIT == op.kind) reap(op);
+ op.done = true;
+ return false;
+}
+
+void EventLoop::complete(Op &op) {
+ --mPending;
+ op.done = true;
+ if (op.waiter) mReady.push_back(op.waiter);
+}
+
+[[nodiscard]] Expect<Unit> EventLoop::step() {
+ if (!mReady.empty()) {
+  std::coroutine_handle<> handle {mReady.front()};
+  mReady.pop_front();
+  handle.resume();
+  return unit;
+ }
+ if (!mPending) return BasicError {"Every task is waiting on nothing"};
+
+ // Processes without a pidfd are polled between short waits, only while any is
+ // awaited.
+ auto eWaited {mPoller->wait(mChildren.empty() ? -1 : CHILD_POLL_MS,
+                             mCompleted)};
+ if (!eWaited) return eWaited;
+ for (Op *op : mCompleted) {
+  if (Op::WAIT == op->kind) reap(*op);
+  complete(*op);
+ }
+ mCompleted.clear();
+
+ for (std::size_t i = 0; i < mChildren.size();) {
+  Op  &op {*mChildren[i]};
+  auto eStatus {Launcher::tryWait(op.pid)};
+  if (eStatus && !*eStatus) {
+   ++i;
+   continue;
+  }
+  op.result = eStatus ? **eStatus : -ECHILD;
+  complete(op);
+  mChildren[i] = mChildren.back();
+  mChildren.pop_back();
+ }
+ return unit;
+}
+
+[[nodiscard]] Expect<int> EventLoop::join(Pid pid) {
+ Op op {Op::WAIT, -1, nullptr, 0, pid};
+ if (submit(op))
+  if (auto eRan = runUntil([&] { return op.done; }); !eRan)
+   return eRan.takeError<BasicError>();
+ if (op.result < 0) return BasicError {std::strerror(-op.result)};
+ return op.result;
+}
+
+} // namespace plush::exec
@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_EXEC_EVENTLOOP_H
+#define PLUSH_EXEC_EVENTLOOP_H
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "bits/Expect.h"
+#include "bits/Task.h"
+#include "bits/Unit.h"
+#include "exec/Launcher.h"
+
+namespace plush::exec {
+
+// Single threaded loop driving the descriptors and processes of a Vm.
+// Coroutines await reads, writes and process exits on the loop, which resumes
+// them as the kernel completes each operation, so any number of pipeline
+// stages progress on the thread running the loop. Splices move data between
+// descriptors within the kernel, when either is a pipe. Operations go through
+// io_uring where the kernel supports it, epoll on other Linux kernels and
+// poll elsewhere. Processes are awaited through a pidfd where available,
+// otherwise their status is polled every few milliseconds.
+class EventLoop final {
+public:
+ // Interface to the kernel the loop waits on.
+ enum class Backend : std::uint8_t { IO_URING, EPOLL, POLL };
+
+ // Operation awaited by a coroutine, living within its frame.
+ struct Op {
+  enum Kind : std::uint8_t { READ, WRITE, WAIT, SPLICE };
+
+  Kind kind;
+  // Descriptor to read, write or splice from, or the pidfd of the awaited
+  // process.
+  int         fd {-1};
+  void       *data {nullptr};
+  std::size_t size {0};
+  Pid         pid {-1};
+  // Descriptor to splice to.
+  int out {-1};
+  // Is a polled splice waiting for out to become writable rather than for fd
+  // to become readable?
+  bool blocked {false};
+  // Bytes transferred or exit status once done, or a negative errno.
+  int  result {0};
+  bool done {false};
+  // Coroutine to resume once done, if any.
+  std::coroutine_handle<> waiter;
+ };
+
+ // Kernel interface starting operations and waiting for them, reads, writes
+ // and splices as is and process exits as their pidfd becoming readable.
+ class Poller {
+ public:
+  virtual ~Poller() {}
+  virtual Backend backend() const = 0;
+  // Starts an operation, returning false if it completed right away.
+  virtual bool submit(Op &op) = 0;
+  // Waits up to timeout milliseconds, or forever if negative, for operations
+  // to complete, appending them to completed.
+  [[nodiscard]] virtual Expect<Unit> wait(int               timeout,
+                                          std::vector<Op *> &completed) = 0;
+ };
+
+ // Operation suspending the awaiting coroutine until it completes, evaluating
+ // to its result.
+ class Awaitable {
+  EventLoop &mLoop;
+  Op         mOp;
+
+ public:
+  Awaitable(EventLoop &loop, Op op) : mLoop {loop}, mOp {op} {}
+
+  bool await_ready() const { return false; }
+  bool await_suspend(std::coroutine_handle<> waiter) {
+   mOp.waiter = waiter;
+   return mLoop.submit(mOp);
+  }
+  int await_resume() const { return mOp.result; }
+ };
+
+private:
+ std::unique_ptr<Poller>             mPoller;
+ std::deque<std::coroutine_handle<>> mReady;
+ std::vector<Op *>                   mCompleted;
+ // Waits on processes without a pidfd, whose status is polled.
+ std::vector<Op *> mChildren;
+ // Number of operations started but not completed.
+ std::size_t mPending {0};
+
+ // Starts an operation, returning false if it completed right away.
+ bool submit(Op &op);
+ // Marks an operation done, queueing its waiter.
+ void complete(Op &op);
+ // Resumes a ready coroutine, or waits for operations to complete if none
+ // is ready. Fails if nothing could ever become ready.
+ [[nodiscard]] Expect<Unit> step();
+
+ template <class F>
+ [[nodiscard]] Expect<Unit> runUntil(F &&done) {
+  while (!done())
+   if (auto eStepped = step(); !eStepped) return eStepped;
+  return unit;
+ }
+
+public:
+ // Opens the preferred backend, falling back to the next one that's
+ // supported.
+ explicit EventLoop(Backend preferred = Backend::IO_URING);
+ EventLoop(EventLoop &&)                 = delete;
+ EventLoop(EventLoop const &)            = delete;
+ EventLoop &operator=(EventLoop &&)      = delete;
+ EventLoop &operator=(EventLoop const &) = delete;
+ ~EventLoop();
+
+ Backend backend() const { return mPoller->backend(); }
+
+ // Reads up to size bytes, evaluating to the number of bytes read, 0 at end
+ // of file, or a negative errno.
+ Awaitable read(int fd, void *data, std::size_t size) {
+  return {*this, {Op::READ, fd, data, size}};
+ }
+ // Writes up to size bytes, evaluating to the number of bytes written or a
+ // negative errno.
+ Awaitable write(int fd, void const *data, std::size_t size) {
+  return {*this, {Op::WRITE, fd, const_cast<void *>(data), size}};
+ }
+ // Moves up to size bytes from in to out within the kernel, evaluating to the
+ // number of bytes moved, 0 at end of file, or a negative errno. Fails with
+ // EINVAL if neither is a pipe.
+ Awaitable splice(int in, int out, std::size_t size) {
+  return {*this, {Op::SPLICE, in, nullptr, size, -1, out}};
+ }
+ // Awaits a launched process' exit, evaluating to its exit status like
+ // Launcher::wait, or a negative errno.
+ Awaitable wait(Pid pid) { return {*this, {Op::WAIT, -1, nullptr, 0, pid}}; }
+
+ // Queues a task to run along with the loop.
+ void start(Task &task) { mReady.push_back(task.handle()); }
+ // Runs the loop until a started task returns.
+ [[nodiscard]] Expect<Unit> finish(Task const &task) {
+  return runUntil([&] { return task.done(); });
+ }
+ // Starts a task and runs the loop until it returns.
+ [[nodiscard]] Expect<Unit> run(Task &task) {
+  start(task);
+  return finish(task);
+ }
+ // Runs the loop until a launched process exits, returning its exit status.
+ [[nodiscard]] Expect<int> join(Pid pid);
+};
+
+} // namespace plush::exec
+
+#endif // PLUSH_EXEC_EVENTLOOP_H
@@ -0,0 +1,222 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "bits/platform.h"
+#include "exec/Launcher.h"
+
+#ifdef PLUSH_POSIX
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+namespace plush::exec {
+
+char const *Launcher::terminate(std::string_view string) {
+ char *data {static_cast<char *>(mArena.allocate(string.size() + 1, 1))};
+ std::memcpy(data, string.data(), string.size());
+ data[string.size()] = '\0';
+ return data;
+}
+
+std::optional<std::string_view>
+Launcher::envOverride(std::string_view name) const {
+ for (std::string_view override : mEnvOverrides)
+  if (override.size() > name.size() && '=' == override[name.size()] &&
+      override.substr(0, name.size()) == name)
+   return override.substr(name.size() + 1);
+ return std::nullopt;
+}
+
+Expect<char const *> Launcher::resolve(std::string_view name) {
+ if (name.empty()) return BasicError {"Empty command name"};
+ // Paths are launched as is.
+ if (name.find('/') != name.npos) return terminate(name);
+
+ std::string key {name};
+ if (auto it = mPathCache.find(key); it != mPathCache.end())
+  return it->second.c_str();
+
+#ifdef PLUSH_POSIX
+ char const      *pathEnv {std::getenv("PATH")};
+ std::string_view path {
+   envOverride("PATH").value_or(pathEnv ? pathEnv
+                                        : "/usr/local/bin:/usr/bin:/bin")};
+ while (true) {
+  std::size_t      colon {path.find(':')};
+  std::string_view dir {path.substr(0, colon)};
+
+  // An empty PATH entry stands for the working directory.
+  std::string candidate {dir.empty() ? "." : dir};
+  candidate += '/';
+  candidate += name;
+
+  struct stat st;
+  if (0 == ::stat(candidate.c_str(), &st) && S_ISREG(st.st_mode) &&
+      0 == ::access(candidate.c_str(), X_OK))
+   return mPathCache.emplace(std::move(key), std::move(candidate))
+     .first->second.c_str();
+
+  if (colon == path.npos) break;
+  path.remove_prefix(colon + 1);
+ }
+#endif
+
+ return BasicError {std::string {name} + ": command not found"};
+}
+
+char *const *Launcher::envp() {
+#ifdef PLUSH_POSIX
+ if (mEnvOverrides.empty()) return environ;
+ if (!mEnvDirty) return mEnvp.data();
+
+ mEnvp.clear();
+ for (char **it = environ; *it; ++it) {
+  std::string_view var {*it};
+  std::string_view name {var.substr(0, var.find('='))};
+  bool             overridden {false};
+  for (auto &override : mEnvOverrides)
+   if (override.size() > name.size() && '=' == override[name.size()] &&
+       0 == override.compare(0, name.size(), name)) {
+    overridden = true;
+    break;
+   }
+  if (!overridden) mEnvp.push_back(*it);
+ }
+ for (auto &override : mEnvOverrides) mEnvp.push_back(override.data());
+ mEnvp.push_back(nullptr);
+ mEnvDirty = false;
+ return mEnvp.data();
+#else
+ return nullptr;
+#endif
+}
+
+void Launcher::setEnv(std::string_view name, std::string_view value) {
+ if ("PATH" == name) mPathCache.clear();
+ std::string var {name};
+ var += '=';
+ mEnvDirty = true;
+ for (auto &override : mEnvOverrides)
+  if (0 == override.compare(0, var.size(), var)) {
+   override = var.append(value);
+   return;
+  }
+ mEnvOverrides.push_back(var.append(value));
+}
+
+void Launcher::setEnvOverrides(std::vector<std::string> const &overrides) {
+ if (overrides == mEnvOverrides) return;
+ std::optional<std::string> oldPath {envOverride("PATH")};
+ mEnvOverrides = overrides;
+ mEnvDirty     = true;
+ if (oldPath != envOverride("PATH")) mPathCache.clear();
+}
+
+[[nodiscard]] Expect<Pid> Launcher::spawn(std::string_view const *argBegin,
+                                          std::string_view const *argEnd,
+                                          Redirect const *redirectBegin,
+                                          Redirect const *redirectEnd) {
+#ifdef PLUSH_POSIX
+ assert(argBegin != argEnd && "Expected a command name");
+
+ // posix_spawn returns once the child has executed or failed, so the previous
+ // launch's vectors are no longer referenced.
+ mArena.reset();
+
+ auto ePath {resolve(*argBegin)};
+ if (!ePath) return ePath.takeError<BasicError>();
+
+ std::size_t argc = argEnd - argBegin;
+ auto      **argv {static_cast<char **>(
+   mArena.allocate((argc + 1) * sizeof(char *), alignof(char *)))};
+ for (std::size_t i = 0; i < argc; ++i)
+  argv[i] = const_cast<char *>(terminate(argBegin[i]));
+ argv[argc] = nullptr;
+
+ posix_spawn_file_actions_t actions;
+ posix_spawn_file_actions_init(&actions);
+ for (Redirect const *r = redirectBegin; r != redirectEnd; ++r) {
+  switch (r->kind) {
+  case Redirect::DUP:
+   posix_spawn_file_actions_adddup2(&actions, r->target, r->fd);
+   break;
+  case Redirect::OPEN:
+   posix_spawn_file_actions_addopen(&actions, r->fd, terminate(r->path),
+                                    r->flags, 0666);
+   break;
+  case Redirect::CLOSE:
+   posix_spawn_file_actions_addclose(&actions, r->fd);
+   break;
+  }
+ }
+
+ // Plush ignores SIGPIPE so builtins writing to a closed pipe fail instead of
+ // killing it, ignored signals being inherited through exec commands get the
+ // default disposition back.
+ posix_spawnattr_t attr;
+ posix_spawnattr_init(&attr);
+ sigset_t defaultSignals;
+ sigemptyset(&defaultSignals);
+ sigaddset(&defaultSignals, SIGPIPE);
+ posix_spawnattr_setsigdefault(&attr, &defaultSignals);
+ posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+
+ pid_t pid;
+ int   error {::posix_spawn(&pid, *ePath, &actions, &attr, argv, envp())};
+ posix_spawn_file_actions_destroy(&actions);
+ posix_spawnattr_destroy(&attr);
+
+ if (error) {
+  // The executable may have moved since it was resolved.
+  if (ENOENT == error || EACCES == error)
+   mPathCache.erase(std::string {*argBegin});
+  return BasicError {std::string {*argBegin} + ": " + std::strerror(error)};
+ }
+ return pid;
+#else
+ return BasicError {"Launching is unsupported on this platform"};
+#endif
+}
+
+#ifdef PLUSH_POSIX
+// Exit status of a process given its waitpid status.
+static int exitStatus(int status) {
+ return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+}
+#endif
+
+[[nodiscard]] Expect<int> Launcher::wait(Pid pid) {
+#ifdef PLUSH_POSIX
+ int status;
+ while (::waitpid(pid, &status, 0) < 0)
+  if (EINTR != errno) return BasicError {std::strerror(errno)};
+ return exitStatus(status);
+#else
+ return BasicError {"Launching is unsupported on this platform"};
+#endif
+}
+
+[[nodiscard]] Expect<std::optional<int>> Launcher::tryWait(Pid pid) {
+#ifdef PLUSH_POSIX
+ int status;
+ Pid waited;
+ while ((waited = ::waitpid(pid, &status, WNOHANG)) < 0)
+  if (EINTR != errno) return BasicError {std::strerror(errno)};
+ if (!waited) return std::optional<int> {};
+ return std::optional<int> {exitStatus(status)};
+#else
+ return BasicError {"Launching is unsupported on this platform"};
+#endif
+}
+
+} // namespace plush::exec
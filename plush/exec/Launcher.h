@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_EXEC_LAUNCHER_H
+#define PLUSH_EXEC_LAUNCHER_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "bits/Arena.h"
+#include "bits/Expect.h"
+
+namespace plush::exec {
+
+// Identifier of a launched process.
+using Pid = int;
+
+// Redirection of one of a launched process' descriptors, applied in the child
+// before the command is executed.
+struct Redirect {
+ enum Kind : std::uint8_t {
+  // Duplicate target onto fd.
+  DUP,
+  // Open path with flags onto fd.
+  OPEN,
+  // Close fd.
+  CLOSE
+ };
+
+ Kind             kind;
+ int              fd;
+ int              target {-1};
+ int              flags {0};
+ std::string_view path {};
+
+ static Redirect dup(int fd, int target) { return {DUP, fd, target}; }
+ static Redirect open(int fd, std::string_view path, int flags) {
+  return {OPEN, fd, -1, flags, path};
+ }
+ static Redirect close(int fd) { return {CLOSE, fd}; }
+};
+
+// Launches external commands without copying the address space of Plush, via
+// posix_spawn. Argument and environment vectors are built within an arena
+// reused by every launch, and commands are resolved against PATH once.
+class Launcher final {
+ // Holds the NUL-terminated vectors of the launch in progress.
+ Arena mArena;
+ // Resolved executable path of every launched command name.
+ std::unordered_map<std::string, std::string> mPathCache;
+ // Overrides of the inherited environment, as NAME=VALUE.
+ std::vector<std::string> mEnvOverrides;
+ // Environment passed to launched processes, rebuilt when overridden.
+ std::vector<char *> mEnvp;
+ bool                mEnvDirty {false};
+
+ char const *terminate(std::string_view string);
+ // Value of an overridden environment variable, if any.
+ std::optional<std::string_view> envOverride(std::string_view name) const;
+ // Resolves a command name to the executable it launches, searching the
+ // overridden PATH if any.
+ Expect<char const *> resolve(std::string_view name);
+ char *const         *envp();
+
+public:
+ Launcher() = default;
+ Launcher(Launcher &&)                 = delete;
+ Launcher(Launcher const &)            = delete;
+ Launcher &operator=(Launcher &&)      = delete;
+ Launcher &operator=(Launcher const &) = delete;
+
+ // Sets an environment variable of every following launch. Setting PATH
+ // forgets every resolved command path.
+ void setEnv(std::string_view name, std::string_view value);
+ // Overrides of the inherited environment, as NAME=VALUE.
+ std::vector<std::string> const &envOverrides() const {
+  return mEnvOverrides;
+ }
+ // Replaces every override of the inherited environment, such as with the
+ // overrides of another launcher. Changing PATH forgets every resolved
+ // command path.
+ void setEnvOverrides(std::vector<std::string> const &overrides);
+
+ // Launches the command named by the first argument, applying the
+ // redirections in order. Returns its process identifier.
+ [[nodiscard]] Expect<Pid> spawn(std::string_view const *argBegin,
+                                 std::string_view const *argEnd,
+                                 Redirect const         *redirectBegin = nullptr,
+                                 Redirect const         *redirectEnd = nullptr);
+
+ // Waits for a launched process to exit, returning its exit status or 128
+ // plus the signal number that killed it.
+ [[nodiscard]] static Expect<int> wait(Pid pid);
+ // Like wait, without blocking if the process is still running.
+ [[nodiscard]] static Expect<std::optional<int>> tryWait(Pid pid);
+};
+
+} // namespace plush::exec
+
+#endif // PLUSH_EXEC_LAUNCHER_H
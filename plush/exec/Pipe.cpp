@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include "bits/platform.h"
+#include "exec/Pipe.h"
+
+#ifdef PLUSH_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace plush::exec {
+
+// Capacity taken out of Pipe::BUDGET by every grown pipe of the process.
+static std::atomic<std::size_t> grownCapacity {0};
+
+[[nodiscard]] Expect<Pipe> Pipe::open(bool grow) {
+#ifdef PLUSH_POSIX
+ int fds[2];
+#ifdef __linux__
+ if (::pipe2(fds, O_CLOEXEC)) return BasicError {std::strerror(errno)};
+#else
+ if (::pipe(fds)) return BasicError {std::strerror(errno)};
+ ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+ ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+
+ Pipe pipe {Fd {fds[0]}, Fd {fds[1]}};
+#ifdef F_SETPIPE_SZ
+ if (grow) {
+  std::size_t taken {
+    grownCapacity.fetch_add(CAPACITY, std::memory_order_relaxed)};
+  if (taken + CAPACITY <= BUDGET &&
+      ::fcntl(fds[1], F_SETPIPE_SZ, static_cast<int>(CAPACITY)) >= 0)
+   pipe.grown = CAPACITY;
+  else
+   grownCapacity.fetch_sub(CAPACITY, std::memory_order_relaxed);
+ }
+#endif
+ return pipe;
+#else
+ return BasicError {"Pipes are unsupported on this platform"};
+#endif
+}
+
+void Pipe::release(std::size_t grown) {
+ grownCapacity.fetch_sub(grown, std::memory_order_relaxed);
+}
+
+#ifdef PLUSH_POSIX
+// Copies through a buffer, for when neither side is a pipe.
+static Expect<std::size_t> copy(int from, int to) {
+ char        buffer[1 << 16];
+ std::size_t total {0};
+ for (;;) {
+  ssize_t n {::read(from, buffer, sizeof buffer)};
+  if (n < 0) {
+   if (EINTR == errno) continue;
+   return BasicError {std::strerror(errno)};
+  }
+  if (!n) return total;
+
+  for (char const *it {buffer}, *end {buffer + n}; it != end;) {
+   ssize_t written {::write(to, it, end - it)};
+   if (written < 0) {
+    if (EINTR == errno) continue;
+    return BasicError {std::strerror(errno)};
+   }
+   it += written;
+  }
+  total += n;
+ }
+}
+#endif
+
+[[nodiscard]] Expect<std::size_t> transfer(int from, int to) {
+#ifdef PLUSH_POSIX
+ std::size_t total {0};
+
+#ifdef __linux__
+ for (;;) {
+  ssize_t n {::splice(from, nullptr, to, nullptr, Pipe::CAPACITY,
+                      SPLICE_F_MOVE | SPLICE_F_MORE)};
+  if (n < 0) {
+   if (EINTR == errno) continue;
+   // Neither side is a pipe or one doesn't support splicing, continue by
+   // copying.
+   if (EINVAL == errno) break;
+   return BasicError {std::strerror(errno)};
+  }
+  if (!n) return total;
+  total += n;
+ }
+#endif
+
+ auto eCopied {copy(from, to)};
+ if (!eCopied) return eCopied.takeError<BasicError>();
+ return total + *eCopied;
+#else
+ return BasicError {"Transferring is unsupported on this platform"};
+#endif
+}
+
+} // namespace plush::exec
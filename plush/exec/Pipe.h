@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_EXEC_PIPE_H
+#define PLUSH_EXEC_PIPE_H
+
+#include <cstdint>
+
+#include "bits/Expect.h"
+#include "bits/Fd.h"
+
+namespace plush::exec {
+
+// OS pipe connecting two pipeline stages. Both ends are close-on-exec, stages
+// receive them through their standard streams instead.
+struct Pipe {
+ // Capacity requested for grown pipes, large enough for stages to run ahead of
+ // each other without a context switch per default sized (64KiB) buffer.
+ constexpr static std::size_t CAPACITY {1 << 20};
+ // Capacity the grown pipes of the process take up at most at once. Past the
+ // per user limit on pipe buffers (fs.pipe-user-pages-soft, 64MiB by default)
+ // the kernel creates every new pipe at its minimum capacity, so growing stays
+ // well within it.
+ constexpr static std::size_t BUDGET {16 * CAPACITY};
+
+ Fd read, write;
+ // Capacity taken out of BUDGET by the pipe, to release once it is destroyed.
+ std::size_t grown {0};
+
+ // Opens a pipe, attempting to grow its buffer to CAPACITY if requested and
+ // within BUDGET. Failing to grow the buffer keeps its default capacity.
+ [[nodiscard]] static Expect<Pipe> open(bool grow = false);
+ // Gives back the capacity taken by grown pipes once every end of them is
+ // closed.
+ static void release(std::size_t grown);
+};
+
+// Moves everything readable from one descriptor to another until end of file,
+// returning the number of bytes moved. When either side is a pipe the data is
+// spliced within the kernel, otherwise it is copied through a buffer.
+[[nodiscard]] Expect<std::size_t> transfer(int from, int to);
+
+} // namespace plush::exec
+
+#endif // PLUSH_EXEC_PIPE_H
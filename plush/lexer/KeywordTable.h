@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Provides a compile-time perfect hash over every keyword from TokenKinds.def,
+// classifying keywords without touching the IdTable.
+
+#pragma once
+
+#ifndef PLUSH_LEXER_KEYWORDTABLE_H
+#define PLUSH_LEXER_KEYWORDTABLE_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "basic/TokenKinds.h"
+
+namespace plush {
+
+// Perfect hash table of every keyword, keyed on their string representation.
+class KeywordTable final {
+ // Bounds of the size of every keyword.
+ constexpr static std::size_t MIN_SIZE {[] {
+  std::size_t size {SIZE_MAX};
+  for (auto &kw : token::KEYWORDS)
+   if (kw.stringRep().size() < size) size = kw.stringRep().size();
+  return size;
+ }()};
+ constexpr static std::size_t MAX_SIZE {[] {
+  std::size_t size {0};
+  for (auto &kw : token::KEYWORDS)
+   if (kw.stringRep().size() > size) size = kw.stringRep().size();
+  return size;
+ }()};
+
+ // Number of slots, a power of two of at least twice the number of keywords
+ // to keep the seed search short.
+ constexpr static std::size_t SLOT_SIZE {[] {
+  std::size_t size {1};
+  while (size < token::Keyword::KIND_SIZE * 2) size *= 2;
+  return size;
+ }()};
+
+ // Number of seeds attempted before giving up.
+ constexpr static std::uint32_t MAX_SEED {1 << 16};
+
+ static_assert(token::Keyword::KIND_SIZE < UINT8_MAX, "Too many keywords");
+
+ // Seed under which no two keywords share a slot, MAX_SEED if none was found.
+ std::uint32_t mSeed {MAX_SEED};
+ // Keyword kind of each slot plus one, 0 if the slot is empty.
+ std::array<std::uint8_t, SLOT_SIZE> mSlots {};
+
+ // Seeded FNV-1a hash of a string, reduced to a slot.
+ constexpr static std::size_t slotOf(std::uint32_t seed, std::string_view s) {
+  std::uint32_t hash {2166136261U ^ seed};
+  for (char c : s) hash = (static_cast<std::uint8_t>(c) ^ hash) * 16777619U;
+  return (hash ^ (hash >> 16)) & (SLOT_SIZE - 1);
+ }
+
+ // Attempts to place every keyword under the provided seed.
+ constexpr bool tryFill(std::uint32_t seed) {
+  mSlots = {};
+  for (auto &kw : token::KEYWORDS) {
+   std::uint8_t &slot {mSlots[slotOf(seed, kw.stringRep())]};
+   if (slot) return false;
+   slot = static_cast<std::uint8_t>(kw.kind() + 1);
+  }
+  mSeed = seed;
+  return true;
+ }
+
+public:
+ constexpr KeywordTable() {
+  for (std::uint32_t seed = 0; seed < MAX_SEED; ++seed)
+   if (tryFill(seed)) return;
+ }
+
+ // Checks if a perfect hash seed was found.
+ constexpr bool valid() const { return mSeed != MAX_SEED; }
+
+ // Finds the keyword with the provided string representation, if any.
+ constexpr std::optional<enum token::Keyword::Kind>
+ find(std::string_view s) const {
+  if (s.size() < MIN_SIZE || s.size() > MAX_SIZE) return std::nullopt;
+
+  std::uint8_t slot {mSlots[slotOf(mSeed, s)]};
+  if (!slot) return std::nullopt;
+
+  auto kind {static_cast<enum token::Keyword::Kind>(slot - 1)};
+  if (token::KEYWORDS[kind].stringRep() != s) return std::nullopt;
+  return kind;
+ }
+};
+
+// Perfect hash table of every Plush keyword.
+constexpr inline KeywordTable KEYWORD_TABLE {};
+
+static_assert(KEYWORD_TABLE.valid(), "No perfect hash seed for the keywords");
+
+} // namespace plush
+
+#endif // PLUSH_LEXER_KEYWORDTABLE_H
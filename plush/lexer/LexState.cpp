@@ -5,8 +5,23 @@
 
 namespace plush {
 
-LexState::LexState(SourceInfo *sourceInfo, IdTable &idTable)
-  : mSourceInfo {sourceInfo}, mIdTable {idTable}, mIt {sourceInfo->cbegin()},
-    mEndIt {sourceInfo->cend()} {}
+LexState::LexState(TokenTables &tables, std::uint32_t offset)
+  : mTables {tables}, mSource {tables.sourceInfo()->sourceContent()},
+    mIt {mSource.data() + offset},
+    mEndIt {mSource.data() + tables.sourceInfo()->validEnd(offset)} {
+ assert(offset <= mSource.size() && "Offset out of bounds");
+}
+
+SourceRegion LexState::invalidRegion() const {
+ assert(!valid() && !atEnd() && "Expected an ill-formed sequence");
+ std::size_t size {utf8::invalidSize(ptr(), mSource.data() + mSource.size())};
+ return {offset(), static_cast<std::uint32_t>(offset() + size)};
+}
+
+void LexState::skipInvalid() {
+ std::uint32_t const offset {invalidRegion().endOffset()};
+ mIt    = ConstIterator {mSource.data() + offset};
+ mEndIt = ConstIterator {mSource.data() + sourceInfo()->validEnd(offset)};
+}
 
 } // namespace plush
@@ -17,55 +17,80 @@ namespace plush {
 // Lexer state representation.
 class LexState final {
 public:
- using ConstIterator = utf8::ConstUtf8IteratorFor<SourceInfo::ConstIterator>;
+ using ConstIterator = utf8::UncheckedIterator;
 
 private:
- SourceInfo *mSourceInfo;
- IdTable    &mIdTable;
- // Current source location.
- SourceLoc mLoc;
+ // Side tables of the tokens being lexed.
+ TokenTables &mTables;
+ // Content of the source entity being lexed.
+ std::string_view mSource;
  // Current lexing position.
  ConstIterator mIt;
- // Iterator pointing to the end of the source entity being lexed.
- ConstIterator const mEndIt;
+ // Iterator pointing to the end of the well-formed UTF-8 being lexed, either
+ // the end of the source entity or its next ill-formed sequence.
+ ConstIterator mEndIt;
 
 public:
- LexState(SourceInfo *sourceInfo, IdTable &idTable);
+ // Begins lexing at the provided byte offset, which must be on a codepoint
+ // boundary. Lexing stops at every ill-formed UTF-8 sequence until it is
+ // skipped over, so the unchecked iterator never decodes one.
+ LexState(TokenTables &tables, std::uint32_t offset = 0);
 
- constexpr SourceInfo *sourceInfo() const { return mSourceInfo; }
- constexpr IdTable    &idTable() const { return mIdTable; }
+ constexpr TokenTables &tables() const { return mTables; }
+ constexpr SourceInfo  *sourceInfo() const { return mTables.sourceInfo(); }
+ constexpr IdTable     &idTable() const { return mTables.idTable(); }
  constexpr bool        valid() const { return mIt != mEndIt; }
+ // Has lexing reached the end of the source entity, rather than an ill-formed
+ // UTF-8 sequence?
+ constexpr bool atEnd() const {
+  return ptr() == mSource.data() + mSource.size();
+ }
+ // Region of the ill-formed UTF-8 sequence lexing stopped at.
+ SourceRegion invalidRegion() const;
+ // Skips over the ill-formed UTF-8 sequence lexing stopped at, lexing on until
+ // the next one.
+ void skipInvalid();
  constexpr char32_t    cur() const {
   assert(valid());
   return *mIt;
  }
+ // Retrieves the current byte, which may be the start of a multibyte
+ // codepoint.
+ constexpr std::uint8_t curByte() const {
+  assert(valid());
+  return static_cast<std::uint8_t>(*ptr());
+ }
  constexpr void advance() {
-  switch (cur()) {
-   case '\n':
-    ++mLoc.line;
-    mLoc.column = 0;
-    break;
-   default:
-    ++mLoc.column;
-    break;
-  }
+  assert(valid());
   ++mIt;
  }
  constexpr void advance(std::size_t n) {
   for (std::size_t i = 0; i < n; ++i) advance();
  }
- constexpr SourceLoc     loc() const { return mLoc; }
+ // Advances over n bytes, which must end on a codepoint boundary.
+ constexpr void advanceBytes(std::size_t n) {
+  assert(ptr() + n <= endPtr());
+  mIt = ConstIterator {ptr() + n};
+ }
+ // Advances to the provided position, which must be on a codepoint boundary.
+ constexpr void advanceTo(char const *pos) { advanceBytes(pos - ptr()); }
  constexpr ConstIterator it() const { return mIt; }
  constexpr ConstIterator end() const { return mEndIt; }
+ // Pointer to the current lexing position.
+ constexpr char const *ptr() const { return mIt.base(); }
+ // Byte offset of the current lexing position.
+ constexpr std::uint32_t offset() const { return ptr() - mSource.data(); }
+ // Pointer to the end of the well-formed UTF-8 being lexed.
+ constexpr char const *endPtr() const { return mEndIt.base(); }
 
  template <class K>
  LexerDiagnostic makeDiagnostic(SourceRegion srcRegion, K &&kind) const {
-  return {mSourceInfo, srcRegion, std::forward<K>(kind)};
+  return {sourceInfo(), srcRegion, std::forward<K>(kind)};
  }
 
  template <class K>
  LexerDiagnostic makeDiagnosticHere(K &&kind) const {
-  return makeDiagnostic({mLoc, mLoc}, std::forward<K>(kind));
+  return makeDiagnostic({offset(), offset()}, std::forward<K>(kind));
  }
 
  constexpr operator bool() const { return valid(); }
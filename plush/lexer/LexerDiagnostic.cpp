@@ -8,7 +8,8 @@ namespace plush {
 
 Diagnostic::Level LexerDiagnostic::level() const {
  if (std::holds_alternative<UnexpectedChar>(mKind) ||
-     std::holds_alternative<UnexpectedEndOfInput>(mKind))
+     std::holds_alternative<UnexpectedEndOfInput>(mKind) ||
+     std::holds_alternative<InvalidUtf8>(mKind))
   return Level::ERROR;
  else
   assert(!"Unhandled kind");
@@ -27,6 +28,8 @@ Doc LexerDiagnostic::doc() const {
   return text("Unexpected character") + colon + hpad() + char_(e->char_);
  else if (std::get_if<UnexpectedEndOfInput>(&mKind))
   return text("Unexpected end of input");
+ else if (std::get_if<InvalidUtf8>(&mKind))
+  return text("Invalid UTF-8 sequence");
  else
   assert(!"Unhandled kind");
 }
@@ -24,10 +24,13 @@ public:
  // Unexpected end of input encountered.
  struct UnexpectedEndOfInput {};
 
+ // Ill-formed UTF-8 sequence encountered.
+ struct InvalidUtf8 {};
+
 private:
- SourceInfo                                        *mSourceInfo;
- SourceRegion                                       mSourceRegion;
- std::variant<UnexpectedChar, UnexpectedEndOfInput> mKind;
+ SourceInfo                                                     *mSourceInfo;
+ SourceRegion                                                    mSourceRegion;
+ std::variant<UnexpectedChar, UnexpectedEndOfInput, InvalidUtf8> mKind;
 
 public:
  template <class K>
@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Provides a compile-time trie over every punctuator and binary operator from
+// TokenKinds.def, resolving operators by maximal munch.
+
+#pragma once
+
+#ifndef PLUSH_LEXER_OPERATORTRIE_H
+#define PLUSH_LEXER_OPERATORTRIE_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "basic/TokenKinds.h"
+
+namespace plush {
+
+// Trie of every punctuator and binary operator, keyed on bytes.
+class OperatorTrie final {
+public:
+ // Operator matched by the trie.
+ struct Match {
+  enum Kind : std::uint8_t {
+   // No operator was matched.
+   NONE,
+   // A punctuator was matched, value is a token::Punctuator::Kind.
+   PUNCTUATOR,
+   // A binary operator was matched, value is a token::BinOp::Kind.
+   BINOP
+  };
+
+  Kind         kind {NONE};
+  std::uint8_t value {0};
+  // Size in bytes of the matched operator.
+  std::uint8_t size {0};
+
+  constexpr explicit operator bool() const { return kind != NONE; }
+ };
+
+private:
+ // Upper bound of trie nodes, the root plus one node per operator byte.
+ constexpr static std::size_t NODE_SIZE {[] {
+  std::size_t size {1};
+  for (auto &punct : token::PUNCTUATORS) size += punct.stringRep().size();
+  for (auto &binOp : token::BINOPS) size += binOp.stringRep().size();
+  return size;
+ }()};
+
+ static_assert(NODE_SIZE <= UINT8_MAX, "Too many operator bytes");
+
+ // Transition table, indexed by node then byte. 0 denotes no transition as the
+ // root is never a child.
+ std::array<std::array<std::uint8_t, 256>, NODE_SIZE> mNext {};
+ // Operator terminating at each node.
+ std::array<Match, NODE_SIZE> mTerminals {};
+ // Number of nodes in use.
+ std::size_t mNodeCount {1};
+
+ constexpr void insert(std::string_view stringRep, Match match) {
+  std::uint8_t node {0};
+  for (char c : stringRep) {
+   std::uint8_t &next {mNext[node][static_cast<std::uint8_t>(c)]};
+   if (!next) next = static_cast<std::uint8_t>(mNodeCount++);
+   node = next;
+  }
+  match.size = static_cast<std::uint8_t>(stringRep.size());
+  mTerminals[node] = match;
+ }
+
+public:
+ constexpr OperatorTrie() {
+  for (auto &punct : token::PUNCTUATORS)
+   insert(punct.stringRep(), {Match::PUNCTUATOR, punct.kind()});
+  for (auto &binOp : token::BINOPS)
+   insert(binOp.stringRep(), {Match::BINOP, binOp.kind()});
+ }
+
+ // Checks if any operator begins with the provided byte.
+ constexpr bool startsWith(std::uint8_t c) const { return mNext[0][c] != 0; }
+
+ // Finds the longest operator that prefixes the provided string.
+ constexpr Match longestMatch(std::string_view src) const {
+  Match        match {};
+  std::uint8_t node {0};
+  for (char c : src) {
+   node = mNext[node][static_cast<std::uint8_t>(c)];
+   if (!node) break;
+   if (mTerminals[node]) match = mTerminals[node];
+  }
+  return match;
+ }
+};
+
+// Trie of every Plush operator.
+constexpr inline OperatorTrie OPERATOR_TRIE {};
+
+} // namespace plush
+
+#endif // PLUSH_LEXER_OPERATORTRIE_H
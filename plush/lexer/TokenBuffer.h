@@ -6,6 +6,8 @@
 #ifndef PLUSH_LEXER_TOKENBUFFER_H
 #define PLUSH_LEXER_TOKENBUFFER_H
 
+#include <cstdint>
+#include <iterator>
 #include <utility>
 #include <vector>
 
@@ -14,30 +16,61 @@
 
 namespace plush {
 
-// Contains parsed tokens along with their originating source entity.
+// Contains parsed tokens, stored packed within a flat array, along with their
+// side tables and originating source entity.
 class TokenBuffer {
- // Origin source entity.
- SourceInfo *mSourceInfo;
+ // Side tables of the parsed tokens.
+ TokenTables mTables;
  // Contains parsed tokens.
  std::vector<Token> mTokens;
 
 public:
- using Iterator      = typename std::vector<Token>::iterator;
- using ConstIterator = typename std::vector<Token>::const_iterator;
+ // Iterator yielding a TokenView of each parsed token.
+ class ConstIterator final {
+  typename std::vector<Token>::const_iterator mIt;
+  TokenTables const                          *mTables;
 
- TokenBuffer(SourceInfo *sourceInfo, std::vector<Token> &&tokens)
-   : mSourceInfo {sourceInfo}, mTokens {std::move(tokens)} {}
+ public:
+  using value_type        = TokenView;
+  using pointer           = void;
+  using reference         = TokenView;
+  using difference_type   = std::ptrdiff_t;
+  using iterator_category = std::forward_iterator_tag;
 
- constexpr SourceInfo               *sourceInfo() const { return mSourceInfo; }
+  ConstIterator(typename std::vector<Token>::const_iterator it,
+                TokenTables const                          &tables)
+    : mIt {it}, mTables {&tables} {}
+
+  TokenView operator*() const { return {*mIt, *mTables}; }
+  bool      operator==(ConstIterator const &it) const { return mIt == it.mIt; }
+  bool operator!=(ConstIterator const &it) const { return !operator==(it); }
+  ConstIterator &operator++() {
+   ++mIt;
+   return *this;
+  }
+  ConstIterator operator++(int) {
+   ConstIterator temp {*this};
+   ++mIt;
+   return temp;
+  }
+ };
+
+ TokenBuffer(SourceInfo *sourceInfo, IdTable &idTable)
+   : mTables {sourceInfo, idTable} {}
+
+ constexpr SourceInfo  *sourceInfo() const { return mTables.sourceInfo(); }
+ constexpr TokenTables &tables() { return mTables; }
+ constexpr TokenTables const        &tables() const { return mTables; }
  constexpr std::vector<Token>       &tokens() { return mTokens; }
  constexpr std::vector<Token> const &tokens() const { return mTokens; }
 
- Iterator      begin() { return mTokens.begin(); }
- ConstIterator begin() const { return mTokens.cbegin(); }
- ConstIterator cbegin() const { return mTokens.cbegin(); }
- Iterator      end() { return mTokens.end(); }
- ConstIterator end() const { return mTokens.cend(); }
- ConstIterator cend() const { return mTokens.cend(); }
+ std::size_t size() const { return mTokens.size(); }
+ TokenView   operator[](std::size_t i) const { return {mTokens[i], mTables}; }
+
+ ConstIterator begin() const { return {mTokens.cbegin(), mTables}; }
+ ConstIterator cbegin() const { return {mTokens.cbegin(), mTables}; }
+ ConstIterator end() const { return {mTokens.cend(), mTables}; }
+ ConstIterator cend() const { return {mTokens.cend(), mTables}; }
 };
 
 } // namespace plush
@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_LEXER_TOKENSTREAM_H
+#define PLUSH_LEXER_TOKENSTREAM_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/Token.h"
+#include "lexer/LexState.h"
+
+namespace plush {
+
+// Lexes tokens from a source entity on demand, holding at most LOOKAHEAD_SIZE
+// lexed but unconsumed tokens. Encountered errors are handled by the
+// diagnostic manager, the stream ends once its error limit is reached.
+// Ill-formed UTF-8 sequences are reported once reached and skipped over.
+class TokenStream final {
+public:
+ // Maximum number of tokens that can be peeked ahead of the current one.
+ constexpr static std::size_t LOOKAHEAD_SIZE {8};
+
+private:
+ LexState            mState;
+ DiagnosticsManager &mDiagMgr;
+ // Ring buffer of lexed but unconsumed tokens.
+ std::array<Token, LOOKAHEAD_SIZE> mLookahead;
+ // Position of the current token and number of tokens within mLookahead.
+ std::size_t mHead {0}, mCount {0};
+ // Has the end of input or the error limit been reached?
+ bool mDone {false};
+
+ // Lexes until a token is produced, the end of input is reached or the error
+ // limit is reached. Returns false if no token was produced.
+ bool lexToken(Token &out);
+ // Lexes until mLookahead holds more than n tokens or the stream ends.
+ bool fill(std::size_t n);
+
+public:
+ // Begins lexing at the provided byte offset, which must be a token boundary.
+ TokenStream(TokenTables &tables, DiagnosticsManager &diagMgr,
+             std::uint32_t offset = 0);
+
+ constexpr TokenTables &tables() const { return mState.tables(); }
+
+ // Retrieves the nth token ahead of the current one without consuming it.
+ std::optional<TokenView> peek(std::size_t n = 0) {
+  assert(n < LOOKAHEAD_SIZE && "Lookahead exceeds LOOKAHEAD_SIZE");
+  if (!fill(n)) return std::nullopt;
+  return TokenView {mLookahead[(mHead + n) % LOOKAHEAD_SIZE], tables()};
+ }
+
+ // Consumes and retrieves the current token.
+ std::optional<TokenView> next() {
+  if (!fill(0)) return std::nullopt;
+  Token token {mLookahead[mHead]};
+  mHead = (mHead + 1) % LOOKAHEAD_SIZE;
+  --mCount;
+  return TokenView {token, tables()};
+ }
+
+ // Consumes every remaining token, appending them to out.
+ void drain(std::vector<Token> &out);
+};
+
+} // namespace plush
+
+#endif // PLUSH_LEXER_TOKENSTREAM_H
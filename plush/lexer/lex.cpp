@@ -1,187 +1,188 @@
 // SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+
 #include "bits/char.h"
 #include "lexer/LexState.h"
+#include "lexer/KeywordTable.h"
 #include "lexer/LexerDiagnostic.h"
 #include "lexer/Lexlet.h"
+#include "lexer/OperatorTrie.h"
 #include "lexer/lex.h"
+#include "lexer/scan.h"
 
 namespace plush {
 
 constexpr static Lexlet lexWhitespace {
   "whitespace", [](LexState &s) -> Lexlet::Result {
-   SourceLoc beginLoc {s.loc()};
-   SourceLoc endLoc {[&] {
-    while (s && isWhitespace(*s)) ++s;
-    return s.loc();
+   std::uint32_t beginOffset {s.offset()};
+   std::uint32_t endOffset {[&] {
+    while (s) {
+     // Skip over runs of ASCII whitespace in bulk, only decoding when a
+     // non-ASCII byte is encountered.
+     s.advanceTo(scan::skipAsciiWhitespace(s.ptr(), s.endPtr()));
+     if (s && s.curByte() >= 0x80 && isWhitespace(*s))
+      ++s;
+     else
+      break;
+    }
+    return s.offset();
    }()};
 
-   return ((beginLoc == endLoc) ? Lexlet::nothing : Lexlet::parsed());
+   return ((beginOffset == endOffset) ? Lexlet::nothing : Lexlet::parsed());
   }};
 
 constexpr static Lexlet lexComment {
   "comment", [](LexState &s) -> Lexlet::Result {
 #define PLUSH_LINECOMMENT '#'
-   SourceLoc beginLoc {s.loc()};
-   SourceLoc endLoc {[&] {
+   std::uint32_t beginOffset {s.offset()};
+   std::uint32_t endOffset {[&] {
     if (PLUSH_LINECOMMENT == *s)
-     while (s && '\n' != *s) ++s;
-    return s.loc();
+     s.advanceTo(scan::find(s.ptr(), s.endPtr(), '\n'));
+    return s.offset();
    }()};
 
-   return ((beginLoc == endLoc) ? Lexlet::nothing : Lexlet::parsed());
+   return ((beginOffset == endOffset) ? Lexlet::nothing : Lexlet::parsed());
 #undef PLUSH_LINECOMMENT
   }};
 
 constexpr static Lexlet lexId {
   "identifier", [](LexState &s) -> Lexlet::Result {
-#define PLUSH_IDHEAD(x) \
- (((x) >= 'a' && (x) <= 'z') || ((x) >= 'A' && (x) <= 'Z') || (x) == '_')
-#define PLUSH_IDTAIL(x) (PLUSH_IDHEAD(x) || ((x) >= '0' && (x) <= '9'))
-   if (PLUSH_IDHEAD(*s)) {
-    typename LexState::ConstIterator::Base beginIt {s.it().base()};
-    SourceLoc                              beginLoc {s.loc()};
-    typename LexState::ConstIterator::Base endIt {[&] {
+   if (isIdHead(*s)) {
+    std::uint32_t beginOffset {s.offset()};
+    std::uint32_t endOffset {[&] {
      ++s; // Skip over identifier head.
-     while (s && PLUSH_IDTAIL(*s)) ++s;
-     return s.it().base();
+     s.advanceTo(scan::skipIdTail(s.ptr(), s.endPtr()));
+     return s.offset();
     }()};
-    SourceLoc                              endLoc {s.loc()};
-    SourceRegionInfo                      *srcRegionInfo {
-      s.sourceInfo()->makeSourceRegionInfo({beginLoc, endLoc})};
-    IdInfo *idInfo {s.idTable().get(
-      {&*beginIt, static_cast<std::size_t>(std::distance(beginIt, endIt))})};
+    std::string_view id {s.sourceInfo()->sourceContent().substr(
+      beginOffset, endOffset - beginOffset)};
 
-    return Lexlet::parsed({srcRegionInfo, token::Id {idInfo}});
-   }
+    // Keywords are classified without interning them.
+    if (auto kind = KEYWORD_TABLE.find(id))
+     return Lexlet::parsed(
+       {Token::KEYWORD, beginOffset, endOffset - beginOffset, *kind});
 
-   return Lexlet::nothing;
-#undef PLUSH_IDHEAD
-#undef PLUSH_IDTAIL
-  }};
-
-constexpr static Lexlet lexPunctuator {
-  "punctuator", [](LexState &s) -> Lexlet::Result {
-   std::string_view src {
-     &*s.it().base(),
-     static_cast<std::size_t>(std::distance(s.it().base(), s.end().base()))};
-
-   for (token::Punctuator const &punct : token::PUNCTUATORS) {
-    std::string_view stringRep {punct.stringRep()};
-    if (0 == src.compare(0, stringRep.size(), stringRep)) {
-     SourceLoc         beginLoc {s.loc()};
-     SourceLoc         endLoc {[&] {
-      s += stringRep.size(); // Skip over punctuator.
-      return s.loc();
-     }()};
-     SourceRegionInfo *srcRegionInfo {
-       s.sourceInfo()->makeSourceRegionInfo({beginLoc, endLoc})};
-
-     return Lexlet::parsed({srcRegionInfo, punct});
-    }
+    IdInfo *idInfo {s.idTable().get(id)};
+    return Lexlet::parsed({Token::ID, beginOffset, endOffset - beginOffset,
+                           idInfo->index()});
    }
 
    return Lexlet::nothing;
   }};
 
-constexpr static Lexlet lexBinOp {
-  "binop", [](LexState &s) -> Lexlet::Result {
-   std::string_view src {
-     &*s.it().base(),
-     static_cast<std::size_t>(std::distance(s.it().base(), s.end().base()))};
-
-   for (auto &binOp : token::BINOPS) {
-    std::string_view stringRep {binOp.stringRep()};
-    if (0 == src.compare(0, stringRep.size(), stringRep)) {
-     SourceLoc         beginLoc {s.loc()};
-     SourceLoc         endLoc {[&] {
-      s += stringRep.size(); // Skip over binop.
-      return s.loc();
-     }()};
-     SourceRegionInfo *srcRegionInfo {
-       s.sourceInfo()->makeSourceRegionInfo({beginLoc, endLoc})};
-     return Lexlet::parsed({srcRegionInfo, binOp});
-    }
-   }
+constexpr static Lexlet lexOperator {
+  "operator", [](LexState &s) -> Lexlet::Result {
+   OperatorTrie::Match match {
+     OPERATOR_TRIE.longestMatch({s.ptr(), static_cast<std::size_t>(
+                                            s.endPtr() - s.ptr())})};
+   if (!match) return Lexlet::nothing;
 
-   return Lexlet::nothing;
+   std::uint32_t beginOffset {s.offset()};
+   s += match.size; // Skip over operator.
+
+   return Lexlet::parsed({(OperatorTrie::Match::PUNCTUATOR == match.kind)
+                            ? Token::PUNCTUATOR
+                            : Token::BINOP,
+                          beginOffset, match.size, match.value});
   }};
 
 constexpr static Lexlet lexString {
   "string", [](LexState &s) -> Lexlet::Result {
    if (*s == '"') {
-    SourceLoc          beginLoc {s.loc()};
-    std::ostringstream oss;
+    std::uint32_t beginOffset {s.offset()};
+    TokenTables  &tables {s.tables()};
 
     ++s; // Skip over "
-    while (s && *s != '"') {
-     char32_t c {*s};
-     ++s; // Skip over the character.
-
-     // If the character is a backslash, attempt to parse an escape sequence.
-     if ('\\' == c) {
-      if (!s) break;
-      switch (*s) {
-       /* Newline */ case 'n':
-        oss << '\n';
-        ++s;
-        break;
-       /* Escaped quotation mark */ case '"':
-        oss << '"';
-        ++s;
-        break;
-       /* Escaped backslash */ case '\\':
-        oss << '\\';
-        ++s;
-        break;
-      }
-     } else
-      utf8::operator<<(oss, c);
+    char const *it {scan::find(s.ptr(), s.endPtr(), '"', '\\')};
+
+    // Literals without escape sequences refer to their source text.
+    if (it != s.endPtr() && '"' == *it) {
+     s.advanceTo(it + 1);
+     return Lexlet::parsed({Token::STRING, beginOffset,
+                            s.offset() - beginOffset, Token::VERBATIM});
+    }
+
+    // Otherwise decode the literal, copying the runs between escape sequences
+    // as is.
+    char const *runBegin {s.ptr()};
+    while (it != s.endPtr() && '"' != *it) {
+     tables.appendString({runBegin, static_cast<std::size_t>(it - runBegin)});
+     // Skip over the backslash.
+     runBegin = ++it;
+     if (it == s.endPtr()) break;
+
+     switch (*it) {
+      /* Newline */ case 'n':
+       tables.appendString("\n");
+       runBegin = ++it;
+       break;
+      /* Escaped quotation mark */ case '"':
+       tables.appendString("\"");
+       runBegin = ++it;
+       break;
+      /* Escaped backslash */ case '\\':
+       tables.appendString("\\");
+       runBegin = ++it;
+       break;
+     }
+
+     it = scan::find(it, s.endPtr(), '"', '\\');
     }
+    s.advanceTo(it);
 
-    if (!s)
+    if (!s) {
      // End of input, no matching quotation mark was found.
+     tables.discardString();
      return Lexlet::diagnostic(s.makeDiagnostic(
-       {beginLoc, s.loc()}, LexerDiagnostic::UnexpectedEndOfInput {}));
-    else {
-     // Successfully parsed the string. The loop above stops when a matching
-     // quotation mark is found, skip over it.
-     assert(*s == '"');
-     ++s;
+       {beginOffset, s.offset()}, LexerDiagnostic::UnexpectedEndOfInput {}));
     }
 
-    SourceLoc         endLoc {s.loc()};
-    SourceRegionInfo *srcRegionInfo {
-      s.sourceInfo()->makeSourceRegionInfo({beginLoc, endLoc})};
+    // Successfully parsed the string. The loop above stops when a matching
+    // quotation mark is found, skip over it.
+    assert(*s == '"');
+    tables.appendString({runBegin, static_cast<std::size_t>(it - runBegin)});
+    ++s;
 
-    return Lexlet::parsed({srcRegionInfo, token::String {oss.str()}});
+    return Lexlet::parsed({Token::STRING, beginOffset,
+                           s.offset() - beginOffset, tables.finishString()});
    }
 
    return Lexlet::nothing;
   }};
 
-static Lexlet::Result lexOnce(LexState &s) {
- constexpr static Lexlet LEXLETS[] {lexWhitespace, lexComment, lexId,
-                                    lexPunctuator, lexBinOp,   lexString};
+// Lexlet to attempt for each possible first byte of a token, nullptr if no
+// token can begin with that byte.
+constexpr static std::array<Lexlet const *, 256> LEXLET_TABLE {[] {
+ std::array<Lexlet const *, 256> table {};
+ for (std::size_t c = 0; c < table.size(); ++c) {
+  if (c >= 0x80 || isWhitespace(c))
+   // Non-ASCII bytes may begin a multibyte whitespace character.
+   table[c] = &lexWhitespace;
+  else if ('#' == c)
+   table[c] = &lexComment;
+  else if (isIdHead(c))
+   table[c] = &lexId;
+  else if ('"' == c)
+   table[c] = &lexString;
+  else if (OPERATOR_TRIE.startsWith(c))
+   table[c] = &lexOperator;
+ }
+ return table;
+}()};
 
- for (Lexlet const &lexlet : LEXLETS) {
-  if (!s)
-   // Break if lexOnce was called at endOfInput or a lexlet from LEXLETS
-   // consumed the rest.
-   break;
+static Lexlet::Result lexOnce(LexState &s) {
+ if (!s)
+  return Lexlet::diagnostic(
+    s.makeDiagnosticHere(LexerDiagnostic::UnexpectedEndOfInput {}));
 
-  Lexlet::Result result {lexlet(s)};
-  if (result.getIf<Lexlet::Result::Nothing>())
-   continue;
-  else if (result.getIf<Lexlet::Result::Parsed>())
-   return Lexlet::parsed();
-  else if (auto output = result.getIf<Lexlet::Result::ParsedWithOutput>())
-   return Lexlet::parsed(std::move(output->value));
-  else if (LexerDiagnostic *diag = result.getIf<LexerDiagnostic>())
-   return Lexlet::diagnostic(std::move(*diag));
-  else
-   assert(!"Unhandled kind");
+ if (Lexlet const *lexlet = LEXLET_TABLE[s.curByte()]) {
+  Lexlet::Result result {(*lexlet)(s)};
+  if (!result.getIf<Lexlet::Result::Nothing>()) return result;
  }
 
  if (s)
@@ -192,31 +193,165 @@ static Lexlet::Result lexOnce(LexState &s) {
     s.makeDiagnosticHere(LexerDiagnostic::UnexpectedEndOfInput {}));
 }
 
-TokenBuffer lex(SourceInfo *sourceInfo, IdTable &idTable,
-                DiagnosticsManager &diagMgr) {
- std::vector<Token> tokens;
- LexState           s {sourceInfo, idTable};
+TokenStream::TokenStream(TokenTables &tables, DiagnosticsManager &diagMgr,
+                         std::uint32_t offset)
+  : mState {tables, offset}, mDiagMgr {diagMgr} {
+ // Tokens store 32-bit byte offsets.
+ assert(tables.sourceInfo()->sourceContent().size() <= UINT32_MAX &&
+        "Source entity too large");
+}
 
- while (s) {
-  Lexlet::Result result {lexOnce(s)};
+bool TokenStream::lexToken(Token &out) {
+ while (!mDone) {
+  if (!mState) {
+   if (mState.atEnd()) break;
+
+   // Ill-formed sequences are reported once lexing reaches them, so re-lexing
+   // a range doesn't report those past it again. Lexing goes on after them.
+   mDiagMgr.add(mState.makeDiagnostic(mState.invalidRegion(),
+                                      LexerDiagnostic::InvalidUtf8 {}));
+   if (mDiagMgr.errorLimitReached())
+    mDone = true;
+   else
+    mState.skipInvalid();
+   continue;
+  }
+
+  Lexlet::Result result {lexOnce(mState)};
   if (result.getIf<Lexlet::Result::Nothing>())
    assert(!"Impossible");
   else if (result.getIf<Lexlet::Result::Parsed>())
    continue;
-  else if (auto output = result.getIf<Lexlet::Result::ParsedWithOutput>())
-   tokens.push_back(std::move(output->value));
-  else if (LexerDiagnostic *diag = result.getIf<LexerDiagnostic>()) {
-   diagMgr.add(std::move(*diag));
-
-   if (diagMgr.errorLimitReached())
-    return TokenBuffer {sourceInfo, std::move(tokens)};
+  else if (auto output = result.getIf<Lexlet::Result::ParsedWithOutput>()) {
+   out = output->value;
+   return true;
+  } else if (LexerDiagnostic *diag = result.getIf<LexerDiagnostic>()) {
+   mDiagMgr.add(std::move(*diag));
+
+   if (mDiagMgr.errorLimitReached())
+    mDone = true;
    else
     // Attempt to skip over the problematic character(s).
-    if (s) ++s;
+    if (mState) ++mState;
+  }
+ }
+
+ mDone = true;
+ return false;
+}
+
+bool TokenStream::fill(std::size_t n) {
+ while (mCount <= n) {
+  Token token;
+  if (!lexToken(token)) return false;
+  mLookahead[(mHead + mCount) % LOOKAHEAD_SIZE] = token;
+  ++mCount;
+ }
+ return true;
+}
+
+void TokenStream::drain(std::vector<Token> &out) {
+ for (; mCount; --mCount, mHead = (mHead + 1) % LOOKAHEAD_SIZE)
+  out.push_back(mLookahead[mHead]);
+
+ Token token;
+ while (lexToken(token)) out.push_back(token);
+}
+
+TokenBuffer lex(SourceInfo *sourceInfo, IdTable &idTable,
+                DiagnosticsManager &diagMgr) {
+ TokenBuffer tokBuf {sourceInfo, idTable};
+ TokenStream stream {tokBuf.tables(), diagMgr};
+
+ stream.drain(tokBuf.tokens());
+
+ return tokBuf;
+}
+
+std::vector<TokenBuffer> lex(std::vector<SourceInfo *> const &sourceInfos,
+                             IdTable &idTable,
+                             std::vector<DiagnosticsManager *> const &diagMgrs,
+                             ThreadPool                              &pool) {
+ assert(sourceInfos.size() == diagMgrs.size() &&
+        "Expected a diagnostic manager per source entity");
+ assert((idTable.concurrent() || pool.threadCount() == 1) &&
+        "Identifier table shared between threads should be concurrent");
+
+ // Every buffer is constructed up front, tasks hold references into the vector
+ // and it mustn't reallocate.
+ std::vector<TokenBuffer> tokBufs;
+ tokBufs.reserve(sourceInfos.size());
+ for (auto *sourceInfo : sourceInfos) tokBufs.emplace_back(sourceInfo, idTable);
+
+ for (std::size_t i = 0; i < tokBufs.size(); ++i)
+  pool.submit([&tokBuf = tokBufs[i], &diagMgr = *diagMgrs[i]] {
+   TokenStream stream {tokBuf.tables(), diagMgr};
+   stream.drain(tokBuf.tokens());
+  });
+ pool.wait();
+
+ return tokBufs;
+}
+
+void relex(TokenBuffer &tokBuf, SourceEdit const &edit,
+           DiagnosticsManager &diagMgr) {
+ std::vector<Token> &tokens {tokBuf.tokens()};
+ std::uint32_t const editEnd {edit.offset + edit.length};
+ std::int64_t const  delta {static_cast<std::int64_t>(edit.text.size()) -
+                           edit.length};
+
+ // Lexlets examine at most the byte following a token, tokens ending before
+ // the edit are unaffected by it. Restart after the last of them.
+ auto restartIt {std::partition_point(
+   tokens.begin(), tokens.end(),
+   [&](Token tok) { return tok.offset() + tok.length() < edit.offset; })};
+ std::uint32_t restartOffset {
+   restartIt == tokens.begin()
+     ? 0
+     : std::prev(restartIt)->offset() + std::prev(restartIt)->length()};
+
+ tokBuf.sourceInfo()->applyEdit(edit);
+ assert(tokBuf.sourceInfo()->sourceContent().size() <= UINT32_MAX &&
+        "Source entity too large");
+
+ // Old tokens beginning within the unchanged tail, which is shifted by delta.
+ auto tailIt {std::partition_point(restartIt, tokens.end(), [&](Token tok) {
+  return tok.offset() < editEnd;
+ })};
+
+ // Lex until a token begins where an old tail token began. The lexer has no
+ // state between tokens, so every following token is unchanged.
+ TokenStream        stream {tokBuf.tables(), diagMgr, restartOffset};
+ std::vector<Token> fresh;
+ bool               resynced {false};
+ while (auto tok = stream.next()) {
+  std::int64_t oldOffset {tok->offset() - delta};
+  while (tailIt != tokens.end() && tailIt->offset() < oldOffset) ++tailIt;
+  if (tailIt != tokens.end() && tailIt->offset() == oldOffset) {
+   resynced = true;
+   break;
   }
+  fresh.push_back(tok->token());
  }
+ if (!resynced) tailIt = tokens.end();
+
+ for (auto it = tailIt; it != tokens.end(); ++it)
+  *it = {it->kind(), static_cast<std::uint32_t>(it->offset() + delta),
+         it->length(), it->payload()};
+
+ // Replace the old tokens between the restart point and the tail.
+ std::size_t const restartIndex = restartIt - tokens.begin();
+ std::size_t const oldCount = tailIt - restartIt;
+ for (auto it = restartIt; it != tailIt; ++it) tokBuf.tables().drop(*it);
+ if (fresh.size() > oldCount)
+  tokens.insert(tailIt, fresh.size() - oldCount, Token {});
+ else
+  tokens.erase(restartIt + fresh.size(), tailIt);
+ std::copy(fresh.begin(), fresh.end(), tokens.begin() + restartIndex);
 
- return TokenBuffer {sourceInfo, std::move(tokens)};
+ // The decoded contents of the replaced string literals are kept until they
+ // outnumber the others, compacting takes a pass over every token.
+ tokBuf.tables().compactStrings(tokens);
 }
 
 } // namespace plush
@@ -6,19 +6,43 @@
 #ifndef PLUSH_LEXER_LEX_H
 #define PLUSH_LEXER_LEX_H
 
+#include <vector>
+
 #include "basic/DiagnosticsManager.h"
 #include "basic/IdTable.h"
 #include "basic/Token.h"
 #include "bits/Expect.h"
+#include "bits/ThreadPool.h"
 #include "lexer/TokenBuffer.h"
+#include "lexer/TokenStream.h"
 
 namespace plush {
 
-// Performs lexical analysis on the provided source entity. Encountered errors
-// are handled by the diagnostic manager.
+// Performs lexical analysis on the provided source entity, draining a
+// TokenStream into a TokenBuffer. Encountered errors are handled by the
+// diagnostic manager.
 TokenBuffer lex(SourceInfo *sourceInfo, IdTable &idTable,
                 DiagnosticsManager &diagMgr);
 
+// Performs lexical analysis on every provided source entity in parallel using
+// the thread pool, with every source entity sharing the identifier table.
+// Encountered errors are handled by the diagnostic manager at the same index as
+// the source entity. Returns the token buffers in the order of the source
+// entities.
+std::vector<TokenBuffer> lex(std::vector<SourceInfo *> const &sourceInfos,
+                             IdTable &idTable,
+                             std::vector<DiagnosticsManager *> const &diagMgrs,
+                             ThreadPool                              &pool);
+
+// Applies an edit to the source entity of a token buffer, re-lexing from the
+// last token boundary before the edit until the tokens resync with the old
+// ones. The offsets of the unchanged tokens that follow are shifted. Encountered
+// errors within the re-lexed range are handled by the diagnostic manager, those
+// past it aren't reported again. The decoded string literals of the replaced
+// tokens are discarded once they outnumber the others.
+void relex(TokenBuffer &tokBuf, SourceEdit const &edit,
+           DiagnosticsManager &diagMgr);
+
 } // namespace plush
 
 #endif // PLUSH_LEXER_LEX_H
@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <cstdint>
+#include <cstring>
+
+#include "bits/char.h"
+#include "bits/simd.h"
+#include "lexer/scan.h"
+
+namespace plush::scan {
+
+namespace {
+
+constexpr bool isAsciiWhitespace(char c) {
+ return static_cast<std::uint8_t>(c) < 0x80 && isWhitespace(c);
+}
+
+#ifdef PLUSH_SIMD
+
+using namespace simd;
+
+// Finds the first byte of a run at which the matching predicate fails, using
+// vectors while whole vectors remain.
+template <class VecPred, class BytePred>
+inline char const *skipWhile(char const *it, char const *end, VecPred vecPred,
+                             BytePred bytePred) {
+ for (; static_cast<std::size_t>(end - it) >= VEC_SIZE; it += VEC_SIZE) {
+  std::uint32_t m {~mask(vecPred(load(it))) & FULL_MASK};
+  if (m) return it + __builtin_ctz(m);
+ }
+ while (it != end && bytePred(*it)) ++it;
+ return it;
+}
+
+#endif
+
+} // namespace
+
+char const *skipAsciiWhitespace(char const *it, char const *end) {
+#ifdef PLUSH_SIMD
+ return skipWhile(
+   it, end,
+   [](Vec v) {
+    // \t \n \v \f \r are contiguous.
+    return or_(inRange(v, '\t', '\r' - '\t'), eq(v, splat(' ')));
+   },
+   isAsciiWhitespace);
+#else
+ while (it != end && isAsciiWhitespace(*it)) ++it;
+ return it;
+#endif
+}
+
+char const *skipIdTail(char const *it, char const *end) {
+#ifdef PLUSH_SIMD
+ return skipWhile(
+   it, end,
+   [](Vec v) {
+    // Folding to lowercase only maps letters into [a, z].
+    Vec lower {or_(v, splat(0x20))};
+    return or_(or_(inRange(lower, 'a', 'z' - 'a'), inRange(v, '0', 9)),
+               eq(v, splat('_')));
+   },
+   [](char c) { return isIdTail(c); });
+#else
+ while (it != end && isIdTail(*it)) ++it;
+ return it;
+#endif
+}
+
+char const *find(char const *it, char const *end, char c) {
+ void const *found {std::memchr(it, c, end - it)};
+ return found ? static_cast<char const *>(found) : end;
+}
+
+char const *find(char const *it, char const *end, char a, char b) {
+#ifdef PLUSH_SIMD
+ Vec const va {splat(a)}, vb {splat(b)};
+ for (; static_cast<std::size_t>(end - it) >= VEC_SIZE; it += VEC_SIZE) {
+  Vec           v {load(it)};
+  std::uint32_t m {mask(or_(eq(v, va), eq(v, vb)))};
+  if (m) return it + __builtin_ctz(m);
+ }
+#endif
+ while (it != end && *it != a && *it != b) ++it;
+ return it;
+}
+
+} // namespace plush::scan
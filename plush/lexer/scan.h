@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Provides bulk scanning over runs of ASCII bytes, processing 32 (AVX2) or 16
+// (SSE2) bytes at a time where available with a scalar fallback otherwise.
+
+#pragma once
+
+#ifndef PLUSH_LEXER_SCAN_H
+#define PLUSH_LEXER_SCAN_H
+
+namespace plush::scan {
+
+// Finds the first byte within [it, end) that isn't ASCII whitespace. Stops at
+// non-ASCII bytes, which require decoding to classify.
+char const *skipAsciiWhitespace(char const *it, char const *end);
+
+// Finds the first byte within [it, end) that can't continue an identifier.
+char const *skipIdTail(char const *it, char const *end);
+
+// Finds the first occurrence of c within [it, end), or end if there is none.
+char const *find(char const *it, char const *end, char c);
+
+// Finds the first occurrence of either a or b within [it, end), or end if there
+// is none.
+char const *find(char const *it, char const *end, char a, char b);
+
+} // namespace plush::scan
+
+#endif // PLUSH_LEXER_SCAN_H
@@ -2,5 +2,26 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #ifndef PLUSH_NOMAIN
-int main(int argc, char **argv) { return 0; }
+#include "bits/Doc.h"
+#include "driver/interpret.h"
+
+using namespace plush;
+
+int main(int argc, char **argv) {
+ using namespace doc;
+
+ auto eOptions {driver::Options::parseArgs(argc, argv)};
+ if (!eOptions) {
+  DocWriter {2}.line(
+    text(eOptions.takeError<BasicError>().userFriendlyMessage()));
+  return 2;
+ }
+
+ auto eStatus {driver::interpret(*eOptions)};
+ if (!eStatus) {
+  DocWriter {2}.line(text(eStatus.takeError<BasicError>().userFriendlyMessage()));
+  return 1;
+ }
+ return *eStatus;
+}
 #endif // PLUSH_NOMAIN
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "parser/Ast.h"
+
+namespace plush::ast {
+
+// Renders a word token as its identifier or string literal.
+static Doc docWord(TokenView tok) {
+ using namespace doc;
+
+ if (tok.is<token::String>()) return stringLit(tok.get<token::String>().string());
+ return text(tok.get<token::Id>()->stringRep());
+}
+
+Doc Ast::docBlock(Index block) const {
+ using namespace doc;
+
+ Block const &b {get<Block>(block)};
+ List         stmts;
+ for (Index i = b.stmtBegin; i < b.stmtEnd; ++i) stmts += doc(stmt(i));
+ return text("Block") + lparen + stmts.doc() + rparen;
+}
+
+Doc Ast::doc(Ref ref) const {
+ using namespace doc;
+
+ switch (ref.kind()) {
+ case Kind::COMMAND: {
+  Command const &c {get<Command>(ref)};
+  List           words;
+  for (Index i = c.tokBegin; i < c.tokEnd; ++i) words += docWord(tokBuf()[i]);
+  return text("Command") + lparen + words.doc() + rparen;
+ }
+ case Kind::BINOP: {
+  BinOp const &b {get<BinOp>(ref)};
+  return text("BinOp") + lparen +
+         list(text(token::BINOPS[b.op].stringRep()), doc(b.lhs), doc(b.rhs))
+           .doc() +
+         rparen;
+ }
+ case Kind::DO: return text("Do") + lparen + docBlock(ref.index()) + rparen;
+ case Kind::IF: {
+  If const &i {get<If>(ref)};
+  List      parts {doc(i.cond), docBlock(i.thenBlock)};
+  if (NONE != i.elseBlock) parts += docBlock(i.elseBlock);
+  return text("If") + lparen + parts.doc() + rparen;
+ }
+ case Kind::LET: {
+  Let const &l {get<Let>(ref)};
+  return text("Let") + lparen +
+         list(docWord(tokBuf()[l.nameTok]), doc(l.value)).doc() + rparen;
+ }
+ case Kind::MODULE:
+  return text("Module") + lparen +
+         docWord(tokBuf()[get<Module>(ref).nameTok]) + rparen;
+ case Kind::IMPORT: {
+  Import const &i {get<Import>(ref)};
+  List          parts {docWord(tokBuf()[i.pathTok])};
+  if (NONE != i.aliasTok) parts += docWord(tokBuf()[i.aliasTok]);
+  return text("Import") + lparen + parts.doc() + rparen;
+ }
+ }
+
+ assert(!"Unhandled kind");
+}
+
+Doc Ast::doc() const {
+ assert(NONE != mRoot && "Tree has no root");
+ return docBlock(mRoot);
+}
+
+} // namespace plush::ast
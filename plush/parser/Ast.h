@@ -0,0 +1,227 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Provides a flat abstract syntax tree. Nodes of each kind live in their own
+// contiguous array and refer to their children by 32-bit indices, leaves refer
+// to tokens by their index within the parsed TokenBuffer.
+
+#pragma once
+
+#ifndef PLUSH_PARSER_AST_H
+#define PLUSH_PARSER_AST_H
+
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "basic/TokenKinds.h"
+#include "bits/Doc.h"
+#include "lexer/TokenBuffer.h"
+
+namespace plush::ast {
+
+// Index of a node within the array of its kind, or of a token within the
+// parsed TokenBuffer.
+using Index = std::uint32_t;
+
+// Absent optional index.
+constexpr Index NONE {UINT32_MAX};
+
+// Kind of a node.
+enum class Kind : std::uint8_t {
+ // External or builtin command invocation, see Command.
+ COMMAND,
+ // Binary operation, see BinOp.
+ BINOP,
+ // Block evaluated as an expression, see Block.
+ DO,
+ // Conditional, see If.
+ IF,
+ // Variable binding, see Let.
+ LET,
+ // Module declaration, see Module.
+ MODULE,
+ // Module import, see Import.
+ IMPORT
+};
+
+// Reference to a node, its kind selects the array the index refers into.
+class Ref final {
+ Index mIndex;
+ Kind  mKind;
+
+public:
+ constexpr Ref(Kind kind, Index index) : mIndex {index}, mKind {kind} {}
+
+ constexpr Kind  kind() const { return mKind; }
+ constexpr Index index() const { return mIndex; }
+
+ constexpr bool operator==(Ref const &ref) const {
+  return mKind == ref.mKind && mIndex == ref.mIndex;
+ }
+ constexpr bool operator!=(Ref const &ref) const { return !operator==(ref); }
+};
+
+// Command, its words are the identifier and string literal tokens within
+// [tokBegin, tokEnd), the first of them naming the command.
+struct Command {
+ Index tokBegin, tokEnd;
+
+ constexpr static Kind KIND {Kind::COMMAND};
+};
+
+// Binary operation, such as a pipe.
+struct BinOp {
+ Ref                     lhs, rhs;
+ enum token::BinOp::Kind op;
+
+ constexpr static Kind KIND {Kind::BINOP};
+};
+
+// Sequence of statements, referring to [stmtBegin, stmtEnd) of the tree's
+// statement list.
+struct Block {
+ Index stmtBegin, stmtEnd;
+
+ constexpr static Kind KIND {Kind::DO};
+};
+
+// Conditional evaluating its then block if the condition succeeds and its
+// optional else block otherwise. Both blocks are Block indices.
+struct If {
+ Ref   cond;
+ Index thenBlock, elseBlock;
+
+ constexpr static Kind KIND {Kind::IF};
+};
+
+// Binding of the output of an expression to a variable. nameTok is the index
+// of the identifier token naming the variable.
+struct Let {
+ Index nameTok;
+ Ref   value;
+
+ constexpr static Kind KIND {Kind::LET};
+};
+
+// Module declaration. nameTok is the index of the identifier token naming the
+// module.
+struct Module {
+ Index nameTok;
+
+ constexpr static Kind KIND {Kind::MODULE};
+};
+
+// Module import. pathTok is the index of the string literal token holding the
+// module's path and aliasTok the optional identifier token it is bound as.
+struct Import {
+ Index pathTok, aliasTok;
+
+ constexpr static Kind KIND {Kind::IMPORT};
+};
+
+// Abstract syntax tree of a source entity, whose root is a Block of every top
+// level statement. Refers to the parsed TokenBuffer, which must outlive it.
+class Ast final {
+ // Parsed tokens the tree refers to.
+ TokenBuffer const *mTokBuf;
+
+ std::vector<Command> mCommands;
+ std::vector<BinOp>   mBinOps;
+ std::vector<Block>   mBlocks;
+ std::vector<If>      mIfs;
+ std::vector<Let>     mLets;
+ std::vector<Module>  mModules;
+ std::vector<Import>  mImports;
+ // Statements of every block, each block's statements being contiguous.
+ std::vector<Ref> mStmts;
+ // Index of the root Block.
+ Index mRoot {NONE};
+
+ template <class T>
+ constexpr std::vector<T> &nodes() {
+  return const_cast<std::vector<T> &>(std::as_const(*this).nodes<T>());
+ }
+
+ template <class T>
+ constexpr std::vector<T> const &nodes() const {
+  if constexpr (std::is_same_v<T, Command>)
+   return mCommands;
+  else if constexpr (std::is_same_v<T, BinOp>)
+   return mBinOps;
+  else if constexpr (std::is_same_v<T, Block>)
+   return mBlocks;
+  else if constexpr (std::is_same_v<T, If>)
+   return mIfs;
+  else if constexpr (std::is_same_v<T, Let>)
+   return mLets;
+  else if constexpr (std::is_same_v<T, Module>)
+   return mModules;
+  else {
+   static_assert(std::is_same_v<T, Import>, "Unhandled node");
+   return mImports;
+  }
+ }
+
+ Doc doc(Ref ref) const;
+ Doc docBlock(Index block) const;
+
+public:
+ explicit Ast(TokenBuffer const &tokBuf) : mTokBuf {&tokBuf} {}
+
+ constexpr TokenBuffer const &tokBuf() const { return *mTokBuf; }
+ constexpr Index              root() const { return mRoot; }
+ constexpr void               setRoot(Index root) { mRoot = root; }
+
+ // Appends a node, returning a reference to it.
+ template <class T>
+ Ref add(T const &node) {
+  assert(nodes<T>().size() < NONE && "Too many nodes");
+  nodes<T>().push_back(node);
+  return {T::KIND, static_cast<Index>(nodes<T>().size() - 1)};
+ }
+ // Appends the statements of a block, returning the index of the new Block.
+ Index addBlock(Ref const *stmtBegin, Ref const *stmtEnd) {
+  Index begin = mStmts.size();
+  mStmts.insert(mStmts.end(), stmtBegin, stmtEnd);
+  return add(Block {begin, static_cast<Index>(mStmts.size())}).index();
+ }
+
+ // Retrieves the node at the provided index of its array.
+ template <class T>
+ T const &get(Index index) const {
+  assert(index < nodes<T>().size());
+  return nodes<T>()[index];
+ }
+ // Retrieves the referenced node. Fails if the kinds mismatch.
+ template <class T>
+ T const &get(Ref ref) const {
+  assert(T::KIND == ref.kind());
+  return get<T>(ref.index());
+ }
+ // Number of nodes of a kind, each retrievable by index.
+ template <class T>
+ std::size_t count() const {
+  return nodes<T>().size();
+ }
+ // Retrieves the statement at the provided index of the statement list.
+ Ref stmt(Index index) const {
+  assert(index < mStmts.size());
+  return mStmts[index];
+ }
+
+ // Total number of nodes.
+ std::size_t size() const {
+  return mCommands.size() + mBinOps.size() + mBlocks.size() + mIfs.size() +
+         mLets.size() + mModules.size() + mImports.size();
+ }
+
+ // Renders the tree as nested lists.
+ Doc doc() const;
+};
+
+} // namespace plush::ast
+
+#endif // PLUSH_PARSER_AST_H
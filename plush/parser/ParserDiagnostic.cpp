@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "parser/ParserDiagnostic.h"
+
+namespace plush {
+
+Diagnostic::Level ParserDiagnostic::level() const {
+ if (std::holds_alternative<Expected>(mKind))
+  return Level::ERROR;
+ else
+  assert(!"Unhandled kind");
+}
+
+SourceInfo *ParserDiagnostic::sourceInfo() const { return mSourceInfo; }
+
+std::optional<SourceRegion> ParserDiagnostic::sourceRegion() const {
+ return mSourceRegion;
+}
+
+Doc ParserDiagnostic::doc() const {
+ using namespace doc;
+
+ if (Expected const *e = std::get_if<Expected>(&mKind))
+  return text("Expected") + hpad() + text(e->what);
+ else
+  assert(!"Unhandled kind");
+}
+
+} // namespace plush
@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_PARSER_PARSERDIAGNOSTIC_H
+#define PLUSH_PARSER_PARSERDIAGNOSTIC_H
+
+#include <string_view>
+#include <variant>
+
+#include "basic/DiagnosticsManager.h"
+
+namespace plush {
+
+// Diagnostic specific to the parser phase.
+class ParserDiagnostic final : public Diagnostic {
+public:
+ // Expected a construct, described by what, that wasn't found.
+ struct Expected {
+  std::string_view what;
+ };
+
+private:
+ SourceInfo            *mSourceInfo;
+ SourceRegion           mSourceRegion;
+ std::variant<Expected> mKind;
+
+public:
+ template <class K>
+ ParserDiagnostic(SourceInfo *sourceInfo, SourceRegion srcRegion, K &&kind)
+   : mSourceInfo {sourceInfo}, mSourceRegion {srcRegion},
+     mKind {std::forward<K>(kind)} {}
+
+ Level                       level() const override;
+ SourceInfo                 *sourceInfo() const override;
+ std::optional<SourceRegion> sourceRegion() const override;
+ Doc                         doc() const override;
+};
+
+} // namespace plush
+
+#endif // PLUSH_PARSER_PARSERDIAGNOSTIC_H
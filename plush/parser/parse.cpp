@@ -0,0 +1,254 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <optional>
+#include <vector>
+
+#include "parser/ParserDiagnostic.h"
+#include "parser/parse.h"
+
+namespace plush {
+
+namespace {
+
+using token::BinOp;
+using token::Keyword;
+using token::Punctuator;
+
+// Recursive descent parser over a TokenBuffer, with binary operators parsed by
+// precedence climbing.
+class Parser final {
+ TokenBuffer const        &mTokBuf;
+ std::vector<Token> const &mTokens;
+ DiagnosticsManager       &mDiagMgr;
+ ast::Ast                  mAst;
+ // Index of the current token.
+ ast::Index mPos {0};
+ // Statements of every block being parsed, innermost last. Each block's
+ // statements are moved into the tree at once when it ends so they stay
+ // contiguous.
+ std::vector<ast::Ref> mStmtStack;
+
+ bool atEnd() const { return mPos == mTokens.size(); }
+
+ template <class K>
+ bool is() const {
+  return !atEnd() && mTokens[mPos].is<K>();
+ }
+ bool is(enum Punctuator::Kind kind) const {
+  return is<Punctuator>() && kind == mTokens[mPos].payload();
+ }
+ bool is(enum Keyword::Kind kind) const {
+  return is<Keyword>() && kind == mTokens[mPos].payload();
+ }
+
+ template <class K>
+ bool accept(K kind) {
+  if (!is(kind)) return false;
+  ++mPos;
+  return true;
+ }
+
+ // Reports the expected construct at the current token.
+ void expected(std::string_view what) {
+  // Errors following the limit are only fallout from recovering.
+  if (mDiagMgr.errorLimitReached()) return;
+
+  std::uint32_t begin, end;
+  if (atEnd())
+   begin = end = mTokBuf.sourceInfo()->sourceContent().size();
+  else {
+   begin = mTokens[mPos].offset();
+   end   = begin + mTokens[mPos].length();
+  }
+  mDiagMgr.add(ParserDiagnostic {mTokBuf.sourceInfo(), {begin, end},
+                                 ParserDiagnostic::Expected {what}});
+ }
+
+ // Expects a token of the provided kind, returning its index.
+ template <class K>
+ std::optional<ast::Index> expect(std::string_view what) {
+  if (!is<K>()) {
+   expected(what);
+   return std::nullopt;
+  }
+  return mPos++;
+ }
+
+ // Skips to the start of the next statement, past a ';' or up to the '}'
+ // closing the current block.
+ void recover(bool nested) {
+  std::size_t depth {0};
+  for (; !atEnd(); ++mPos) {
+   if (is(Punctuator::LPAREN) || is(Punctuator::LCURLYBRACK))
+    ++depth;
+   else if (is(Punctuator::RPAREN) || is(Punctuator::RCURLYBRACK)) {
+    if (depth)
+     --depth;
+    else if (nested && is(Punctuator::RCURLYBRACK))
+     return;
+   } else if (!depth && is(Punctuator::SEMICOLON)) {
+    ++mPos;
+    return;
+   }
+  }
+ }
+
+ // block := '{' stmts '}'
+ std::optional<ast::Index> parseBlock() {
+  if (!accept(Punctuator::LCURLYBRACK)) {
+   expected("'{'");
+   return std::nullopt;
+  }
+
+  std::size_t mark {mStmtStack.size()};
+  parseStmts(true);
+  if (!accept(Punctuator::RCURLYBRACK)) {
+   expected("'}'");
+   mStmtStack.erase(mStmtStack.begin() + mark, mStmtStack.end());
+   return std::nullopt;
+  }
+
+  ast::Index block {mAst.addBlock(mStmtStack.data() + mark,
+                                  mStmtStack.data() + mStmtStack.size())};
+  mStmtStack.erase(mStmtStack.begin() + mark, mStmtStack.end());
+  return block;
+ }
+
+ // prefix := (ID | STRING)+ | '(' expr ')' | 'do' block
+ //         | 'if' expr block block?
+ std::optional<ast::Ref> parsePrefix() {
+  if (is<token::Id>() || is<token::String>()) {
+   ast::Index begin {mPos};
+   do ++mPos;
+   while (is<token::Id>() || is<token::String>());
+   return mAst.add(ast::Command {begin, mPos});
+  } else if (accept(Punctuator::LPAREN)) {
+   auto expr {parseExpr(0)};
+   if (!expr) return std::nullopt;
+   if (!accept(Punctuator::RPAREN)) {
+    expected("')'");
+    return std::nullopt;
+   }
+   return expr;
+  } else if (accept(Keyword::DO)) {
+   auto block {parseBlock()};
+   if (!block) return std::nullopt;
+   return ast::Ref {ast::Kind::DO, *block};
+  } else if (accept(Keyword::IF)) {
+   auto cond {parseExpr(0)};
+   if (!cond) return std::nullopt;
+   auto thenBlock {parseBlock()};
+   if (!thenBlock) return std::nullopt;
+   ast::Index elseBlock {ast::NONE};
+   if (is(Punctuator::LCURLYBRACK)) {
+    auto block {parseBlock()};
+    if (!block) return std::nullopt;
+    elseBlock = *block;
+   }
+   return mAst.add(ast::If {*cond, *thenBlock, elseBlock});
+  }
+
+  expected("expression");
+  return std::nullopt;
+ }
+
+ // expr := prefix (BINOP expr)*
+ //
+ // Only binary operators of at least minPrec are consumed, a left associative
+ // operator's right operand is restricted to higher precedences so equal ones
+ // are folded into the left operand instead.
+ std::optional<ast::Ref> parseExpr(std::uint8_t minPrec) {
+  auto lhs {parsePrefix()};
+  if (!lhs) return std::nullopt;
+
+  while (is<BinOp>()) {
+   BinOp op {static_cast<enum BinOp::Kind>(mTokens[mPos].payload())};
+   if (op.prec() < minPrec) break;
+   ++mPos;
+
+   auto rhs {parseExpr(BinOp::LASSOC == op.assoc() ? op.prec() + 1
+                                                   : op.prec())};
+   if (!rhs) return std::nullopt;
+   lhs = mAst.add(ast::BinOp {*lhs, *rhs, op.kind()});
+  }
+
+  return lhs;
+ }
+
+ // stmt := 'module' ID | 'import' STRING ('as' ID)? | 'let' ID ':' expr
+ //       | expr
+ std::optional<ast::Ref> parseStmt() {
+  if (accept(Keyword::MODULE)) {
+   auto name {expect<token::Id>("module name")};
+   if (!name) return std::nullopt;
+   return mAst.add(ast::Module {*name});
+  } else if (accept(Keyword::IMPORT)) {
+   auto path {expect<token::String>("module path")};
+   if (!path) return std::nullopt;
+   ast::Index alias {ast::NONE};
+   if (accept(Keyword::AS)) {
+    auto id {expect<token::Id>("module alias")};
+    if (!id) return std::nullopt;
+    alias = *id;
+   }
+   return mAst.add(ast::Import {*path, alias});
+  } else if (accept(Keyword::LET)) {
+   auto name {expect<token::Id>("variable name")};
+   if (!name) return std::nullopt;
+   if (!accept(Punctuator::COLON)) {
+    expected("':'");
+    return std::nullopt;
+   }
+   auto value {parseExpr(0)};
+   if (!value) return std::nullopt;
+   return mAst.add(ast::Let {*name, *value});
+  }
+
+  return parseExpr(0);
+ }
+
+ // stmts := (stmt (';' | <after '}'>))* stmt?
+ void parseStmts(bool nested) {
+  while (!atEnd() && !(nested && is(Punctuator::RCURLYBRACK))) {
+   if (mDiagMgr.errorLimitReached()) return;
+
+   auto stmt {parseStmt()};
+   if (!stmt) {
+    recover(nested);
+    continue;
+   }
+
+   // Statements ending with a block need no separator.
+   if (accept(Punctuator::SEMICOLON) || atEnd() ||
+       is(Punctuator::RCURLYBRACK) ||
+       (mTokens[mPos - 1].is<Punctuator>() &&
+        Punctuator::RCURLYBRACK == mTokens[mPos - 1].payload()))
+    mStmtStack.push_back(*stmt);
+   else {
+    expected("';'");
+    recover(nested);
+   }
+  }
+ }
+
+public:
+ Parser(TokenBuffer const &tokBuf, DiagnosticsManager &diagMgr)
+   : mTokBuf {tokBuf}, mTokens {tokBuf.tokens()}, mDiagMgr {diagMgr},
+     mAst {tokBuf} {}
+
+ ast::Ast parse() && {
+  parseStmts(false);
+  mAst.setRoot(mAst.addBlock(mStmtStack.data(),
+                             mStmtStack.data() + mStmtStack.size()));
+  return std::move(mAst);
+ }
+};
+
+} // namespace
+
+ast::Ast parse(TokenBuffer const &tokBuf, DiagnosticsManager &diagMgr) {
+ return Parser {tokBuf, diagMgr}.parse();
+}
+
+} // namespace plush
@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_PARSER_PARSE_H
+#define PLUSH_PARSER_PARSE_H
+
+#include "basic/DiagnosticsManager.h"
+#include "lexer/TokenBuffer.h"
+#include "parser/Ast.h"
+
+namespace plush {
+
+// Performs syntactic analysis on the provided tokens, building a flat Ast of
+// the following grammar:
+//
+//   program := stmts
+//   stmts   := (stmt (';' | <after '}'>))* stmt?
+//   stmt    := 'module' ID | 'import' STRING ('as' ID)? | 'let' ID ':' expr
+//            | expr
+//   expr    := prefix (BINOP expr)*
+//   prefix  := (ID | STRING)+ | '(' expr ')' | 'do' block
+//            | 'if' expr block block?
+//   block   := '{' stmts '}'
+//
+// Binary operators are parsed by precedence climbing over their precedence and
+// associativity from TokenKinds.def. Encountered errors are handled by the
+// diagnostic manager, parsing resumes at the next statement until the error
+// limit is reached.
+ast::Ast parse(TokenBuffer const &tokBuf, DiagnosticsManager &diagMgr);
+
+} // namespace plush
+
+#endif // PLUSH_PARSER_PARSE_H
@@ -0,0 +1,434 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "bits/Doc.h"
+#include "bits/platform.h"
+#include "exec/Pipe.h"
+#include "vm/Builtins.h"
+#include "vm/Vm.h"
+
+#ifdef PLUSH_POSIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace plush::vm {
+
+// Size of the buffer cat copies through when it can't splice, kept small since
+// thousands of cat stages may run at once.
+constexpr std::size_t CAT_BUFFER_SIZE {1 << 14};
+
+// Reports a builtin's failure to stderr, returning the provided exit status.
+static int fail(BuiltinCall const &call, std::string_view message,
+                int status = 1) {
+ using namespace doc;
+ DocWriter {2}.line(text(*call.argBegin) + colon + hpad() + text(message));
+ return status;
+}
+
+// Writes a whole string to a descriptor, returning the builtin's exit status.
+// A reader going away (EPIPE) fails silently, the same way an external command
+// killed by SIGPIPE would.
+static Task writeAll(BuiltinCall call, std::string_view string) {
+ while (!string.empty()) {
+  int n {co_await call.vm.loop().write(call.out, string.data(),
+                                       string.size())};
+  if (n < 0) co_return EPIPE == -n ? 1 : fail(call, std::strerror(-n));
+  string.remove_prefix(n);
+ }
+ co_return 0;
+}
+
+// Parses a whole string as an integer.
+template <typename T>
+static std::optional<T> parseInt(std::string_view string) {
+ if (!string.empty() && '+' == string.front()) string.remove_prefix(1);
+ T value;
+ auto [ptr, ec] =
+   std::from_chars(string.data(), string.data() + string.size(), value);
+ if (string.empty() || ec != std::errc {} ||
+     ptr != string.data() + string.size())
+  return std::nullopt;
+ return value;
+}
+
+// cd [dir], changes the working directory to dir or $HOME. Isolated, it only
+// checks that it could.
+static Task cd(BuiltinCall call) {
+ std::size_t argc = call.argEnd - call.argBegin;
+ if (argc > 2) co_return fail(call, "Too many arguments");
+
+ std::string dir;
+ if (argc == 2)
+  dir = call.argBegin[1];
+ else if (char const *home = std::getenv("HOME"))
+  dir = home;
+ else
+  co_return fail(call, "HOME not set");
+
+#ifdef PLUSH_POSIX
+ if (call.isolated) {
+  struct stat info;
+  if (::stat(dir.c_str(), &info)) co_return fail(call, std::strerror(errno));
+  if (!S_ISDIR(info.st_mode)) co_return fail(call, std::strerror(ENOTDIR));
+  if (::access(dir.c_str(), X_OK)) co_return fail(call, std::strerror(errno));
+  co_return 0;
+ }
+ if (::chdir(dir.c_str())) co_return fail(call, std::strerror(errno));
+ co_return 0;
+#else
+ co_return fail(call, "Unsupported on this platform");
+#endif
+}
+
+// exit [status], stops Plush with status or 0. Isolated, it only returns
+// status.
+static Task exit(BuiltinCall call) {
+ std::size_t argc = call.argEnd - call.argBegin;
+ if (argc > 2) co_return fail(call, "Too many arguments");
+
+ int status {0};
+ if (argc == 2) {
+  auto optStatus {parseInt<int>(call.argBegin[1])};
+  if (!optStatus) co_return fail(call, "Invalid exit status");
+  status = *optStatus;
+ }
+
+ if (!call.isolated) call.vm.exit(status);
+ co_return status;
+}
+
+// true, succeeds.
+static Task success(BuiltinCall) { co_return 0; }
+
+// false, fails.
+static Task failure(BuiltinCall) { co_return 1; }
+
+// echo ["-n"] [arg...], writes its arguments separated by spaces, followed by a
+// newline unless "-n" is given.
+static Task echo(BuiltinCall call) {
+ std::string_view const *arg {call.argBegin + 1};
+ bool                    newline {true};
+ if (arg != call.argEnd && "-n" == *arg) {
+  newline = false;
+  ++arg;
+ }
+
+ std::string output;
+ for (auto it = arg; it != call.argEnd; ++it) {
+  if (it != arg) output += ' ';
+  output += *it;
+ }
+ if (newline) output += '\n';
+ co_return co_await writeAll(call, output);
+}
+
+// Moves everything readable from a descriptor to the builtin's stdout,
+// returning the builtin's exit status.
+static Task transfer(BuiltinCall call, int fd) {
+ // Pipes on either side are spliced within the kernel, cat between two pipeline
+ // stages never copies through Plush. Splicing moves nothing when it fails, so
+ // copying through a buffer picks up from there.
+ for (;;) {
+  int n {co_await call.vm.loop().splice(fd, call.out, exec::Pipe::CAPACITY)};
+  if (!n) co_return 0;
+  if (n > 0) continue;
+  if (EPIPE == -n) co_return 1;
+  if (EINVAL == -n || EAGAIN == -n) break;
+  co_return fail(call, std::strerror(-n));
+ }
+
+ std::unique_ptr<char[]> buffer {new char[CAT_BUFFER_SIZE]};
+ for (;;) {
+  int n {co_await call.vm.loop().read(fd, buffer.get(), CAT_BUFFER_SIZE)};
+  if (n < 0) co_return fail(call, std::strerror(-n));
+  if (!n) co_return 0;
+  std::string_view const data {buffer.get(), static_cast<std::size_t>(n)};
+  if (int written = co_await writeAll(call, data)) co_return written;
+ }
+}
+
+// cat [file...], writes the content of every file, "-" or no file at all
+// standing for stdin.
+static Task cat(BuiltinCall call) {
+ std::string_view const  stdinArg[] {"-"};
+ std::string_view const *begin {call.argBegin + 1}, *end {call.argEnd};
+ if (begin == end) {
+  begin = std::begin(stdinArg);
+  end   = std::end(stdinArg);
+ }
+
+ // Transfers are awaited on the event loop, a cat stage waiting on either of
+ // its pipes lets every other stage run meanwhile.
+ int status {0};
+ for (auto it = begin; it != end; ++it) {
+  int fd {call.in};
+  if ("-" != *it) {
+#ifdef PLUSH_POSIX
+   fd = ::open(std::string {*it}.c_str(), O_RDONLY | O_CLOEXEC);
+#else
+   fd = -1;
+#endif
+   if (fd < 0) {
+    status = fail(call, std::string {*it} + ": " + std::strerror(errno));
+    continue;
+   }
+  }
+
+  if (int transferred = co_await transfer(call, fd)) status = transferred;
+#ifdef PLUSH_POSIX
+  if (fd != call.in) ::close(fd);
+#endif
+ }
+ co_return status;
+}
+
+// Appends the character of the backslash escape starting past the backslash at
+// index i of string, returning the index following the escape.
+static std::size_t appendEscape(std::string &output, std::string_view string,
+                                std::size_t i) {
+ if (i == string.size()) {
+  output += '\\';
+  return i;
+ }
+
+ char c {string[i++]};
+ switch (c) {
+ case 'a': output += '\a'; break;
+ case 'b': output += '\b'; break;
+ case 'f': output += '\f'; break;
+ case 'n': output += '\n'; break;
+ case 'r': output += '\r'; break;
+ case 't': output += '\t'; break;
+ case 'v': output += '\v'; break;
+ case '\\':
+ case '"':
+ case '\'': output += c; break;
+ default:
+  if (c >= '0' && c <= '7') {
+   // Up to 3 octal digits.
+   int value {c - '0'};
+   for (int digits = 1; digits < 3 && i < string.size() && string[i] >= '0' &&
+                        string[i] <= '7';
+        ++digits)
+    value = value * 8 + (string[i++] - '0');
+   output += static_cast<char>(value);
+  } else {
+   output += '\\';
+   output += c;
+  }
+ }
+ return i;
+}
+
+// Appends a value formatted with the provided printf conversion.
+template <typename T>
+static void appendFormatted(std::string &output, std::string const &spec,
+                            T value) {
+ int n {std::snprintf(nullptr, 0, spec.c_str(), value)};
+ if (n <= 0) return;
+ std::size_t size {output.size()};
+ output.resize(size + n + 1);
+ std::snprintf(&output[size], n + 1, spec.c_str(), value);
+ output.resize(size + n);
+}
+
+// Parses a numeric printf argument, a leading quote taking the value of the
+// following character.
+static std::optional<long long> parsePrintfInt(std::string_view arg) {
+ if (arg.empty()) return 0;
+ if ('"' == arg.front() || '\'' == arg.front())
+  return arg.size() > 1 ? static_cast<unsigned char>(arg[1]) : 0;
+ return parseInt<long long>(arg);
+}
+
+// printf format [arg...], writes its arguments formatted with the conversions
+// %s, %c, %d, %i, %u, %o, %x and %X, with flags, width and precision, and the
+// backslash escapes of format. format is reused while arguments remain.
+static Task printf(BuiltinCall call) {
+ if (call.argEnd - call.argBegin < 2) co_return fail(call, "Expected a format");
+
+ std::string_view const  format {call.argBegin[1]};
+ std::string_view const *arg {call.argBegin + 2};
+ std::string             output;
+ int                     status {0};
+ for (;;) {
+  std::string_view const *firstArg {arg};
+  for (std::size_t i = 0; i < format.size();) {
+   char c {format[i]};
+   if ('\\' == c) {
+    i = appendEscape(output, format, i + 1);
+    continue;
+   }
+   if ('%' != c) {
+    output += c;
+    ++i;
+    continue;
+   }
+   if (i + 1 < format.size() && '%' == format[i + 1]) {
+    output += '%';
+    i += 2;
+    continue;
+   }
+
+   // Flags, width and precision are passed on to snprintf as is.
+   std::size_t begin {i++};
+   i = std::min(format.find_first_not_of("-+ #0", i), format.size());
+   while (i < format.size() && std::isdigit(format[i])) ++i;
+   if (i < format.size() && '.' == format[i])
+    do ++i;
+    while (i < format.size() && std::isdigit(format[i]));
+   if (i == format.size()) co_return fail(call, "Missing conversion");
+
+   char             conversion {format[i++]};
+   std::string      spec {format.substr(begin, i - 1 - begin)};
+   std::string_view value {arg != call.argEnd ? *arg++ : std::string_view {}};
+   switch (conversion) {
+   case 's':
+   case 'c':
+    spec += 's';
+    appendFormatted(output, spec,
+                    std::string {'c' == conversion ? value.substr(0, 1) : value}
+                      .c_str());
+    break;
+   case 'd':
+   case 'i':
+   case 'u':
+   case 'o':
+   case 'x':
+   case 'X': {
+    auto optInt {parsePrintfInt(value)};
+    if (!optInt)
+     status = fail(call, std::string {value} + ": Invalid number");
+    spec += "ll";
+    spec += conversion;
+    appendFormatted(output, spec, optInt.value_or(0));
+    break;
+   }
+   default:
+    co_return fail(call, std::string {"Invalid conversion %"} + conversion);
+   }
+  }
+
+  // Reuse the format only if it consumed arguments, or it would never end.
+  if (arg == call.argEnd || arg == firstArg) break;
+ }
+
+ int writeStatus {co_await writeAll(call, output)};
+ co_return writeStatus ? writeStatus : status;
+}
+
+// Negates a test's status, keeping errors as is.
+static int negate(int status) { return status > 1 ? status : !status; }
+
+// Evaluates a unary test, returning its status.
+static int unaryTest(BuiltinCall const &call, std::string_view op,
+                     std::string_view operand) {
+ if ("-n" == op) return operand.empty();
+ if ("-z" == op) return !operand.empty();
+
+#ifdef PLUSH_POSIX
+ std::string path {operand};
+ struct stat st;
+ if ("-e" == op) return 0 != ::stat(path.c_str(), &st);
+ if ("-f" == op) return 0 != ::stat(path.c_str(), &st) || !S_ISREG(st.st_mode);
+ if ("-d" == op) return 0 != ::stat(path.c_str(), &st) || !S_ISDIR(st.st_mode);
+ if ("-s" == op) return 0 != ::stat(path.c_str(), &st) || !st.st_size;
+ if ("-L" == op || "-h" == op)
+  return 0 != ::lstat(path.c_str(), &st) || !S_ISLNK(st.st_mode);
+ if ("-r" == op) return 0 != ::access(path.c_str(), R_OK);
+ if ("-w" == op) return 0 != ::access(path.c_str(), W_OK);
+ if ("-x" == op) return 0 != ::access(path.c_str(), X_OK);
+#endif
+
+ return fail(call, std::string {op} + ": Unknown unary operator", 2);
+}
+
+// Evaluates a binary test, returning its status, or nullopt if op isn't a
+// binary operator.
+static std::optional<int> binaryTest(BuiltinCall const &call,
+                                     std::string_view lhs, std::string_view op,
+                                     std::string_view rhs) {
+ if ("=" == op) return lhs != rhs;
+ if ("!=" == op) return lhs == rhs;
+
+ constexpr std::string_view INT_OPS[] {"-eq", "-ne", "-lt",
+                                       "-le", "-gt", "-ge"};
+ auto it {std::find(std::begin(INT_OPS), std::end(INT_OPS), op)};
+ if (it == std::end(INT_OPS)) return std::nullopt;
+
+ auto optLhs {parseInt<long long>(lhs)}, optRhs {parseInt<long long>(rhs)};
+ if (!optLhs || !optRhs)
+  return fail(call, std::string {optLhs ? rhs : lhs} + ": Expected an integer",
+              2);
+
+ long long l {*optLhs}, r {*optRhs};
+ switch (it - std::begin(INT_OPS)) {
+ case 0: return !(l == r);
+ case 1: return !(l != r);
+ case 2: return !(l < r);
+ case 3: return !(l <= r);
+ case 4: return !(l > r);
+ default: return !(l >= r);
+ }
+}
+
+// Evaluates a test expression following the POSIX rules for up to 4
+// arguments, returning its status.
+static int evaluateTest(BuiltinCall const &call, std::string_view const *begin,
+                        std::string_view const *end) {
+ switch (end - begin) {
+ case 0: return 1;
+ case 1: return begin[0].empty();
+ case 2:
+  if ("!" == begin[0]) return negate(evaluateTest(call, begin + 1, end));
+  return unaryTest(call, begin[0], begin[1]);
+ case 3:
+  if (auto optStatus = binaryTest(call, begin[0], begin[1], begin[2]))
+   return *optStatus;
+  if ("!" == begin[0]) return negate(evaluateTest(call, begin + 1, end));
+  if ("(" == begin[0] && ")" == begin[2])
+   return evaluateTest(call, begin + 1, end - 1);
+  return fail(call, std::string {begin[1]} + ": Unknown binary operator", 2);
+ case 4:
+  if ("!" == begin[0]) return negate(evaluateTest(call, begin + 1, end));
+  [[fallthrough]];
+ default: return fail(call, "Too many arguments", 2);
+ }
+}
+
+// test [expr], succeeds if expr holds, failing with 2 on invalid expressions.
+static Task test(BuiltinCall call) {
+ co_return evaluateTest(call, call.argBegin + 1, call.argEnd);
+}
+
+std::array<Builtin, 8> const BUILTINS {{
+  {"cd", cd, true},
+  {"exit", exit, true},
+  {"true", success, false},
+  {"false", failure, false},
+  {"echo", echo, false},
+  {"cat", cat, false},
+  {"printf", printf, false},
+  {"test", test, false},
+}};
+
+BuiltinRegistry::BuiltinRegistry(IdTable &idTable) {
+ for (std::uint32_t i = 0; i < BUILTINS.size(); ++i)
+  mIds[i] = idTable.get(BUILTINS[i].name);
+}
+
+} // namespace plush::vm
@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_VM_BUILTINS_H
+#define PLUSH_VM_BUILTINS_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "basic/IdTable.h"
+#include "bits/Task.h"
+
+namespace plush::vm {
+
+class Vm;
+
+// Invocation of a builtin, running within the Plush process.
+struct BuiltinCall {
+ Vm &vm;
+ // Arguments, the first naming the builtin.
+ std::string_view const *argBegin, *argEnd;
+ // Descriptors standing in for stdin and stdout.
+ int in, out;
+ // Does it run as a pipeline stage, which mustn't affect Plush itself?
+ bool isolated {false};
+};
+
+// Runs a builtin as a coroutine returning its exit status, awaiting its reads
+// and writes on the Vm's event loop.
+using BuiltinFn = Task (*)(BuiltinCall call);
+
+// Command run within the Plush process instead of being launched, either
+// because it affects Plush itself or is too trivial to pay a launch for.
+struct Builtin {
+ std::string_view name;
+ BuiltinFn        fn;
+ // Does it affect Plush itself? As a pipeline stage such a builtin runs
+ // isolated, only returning the exit status it would have.
+ bool affectsPlush;
+};
+
+// Every builtin, referred to by index from bytecode.
+extern std::array<Builtin, 8> const BUILTINS;
+
+// Maps the identifiers naming builtins to their index within BUILTINS. Since
+// identifiers are interned, looking up a command's name compares it against
+// the identifier of each builtin pointer by pointer, rather than string by
+// string. A quoted command name is a string, not an identifier, and always
+// launches the external command.
+class BuiltinRegistry final {
+ // Identifier naming each builtin, by index within BUILTINS.
+ std::array<IdInfo const *, BUILTINS.size()> mIds;
+
+public:
+ // Interns the name of every builtin within the IdTable.
+ explicit BuiltinRegistry(IdTable &idTable);
+
+ // Finds the index within BUILTINS of the builtin named by the identifier.
+ std::optional<std::uint32_t> find(IdInfo const *id) const {
+  for (std::uint32_t i = 0; i < mIds.size(); ++i)
+   if (id == mIds[i]) return i;
+  return std::nullopt;
+ }
+};
+
+} // namespace plush::vm
+
+#endif // PLUSH_VM_BUILTINS_H
@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <tuple>
+
+#include "vm/Bytecode.h"
+
+namespace plush::vm {
+
+void Chunk::disassemble(DocWriter &writer) const {
+ using namespace doc;
+
+ Doc d;
+ for (std::uint32_t offset = 0; offset < mCode.size();) {
+  std::uint32_t word {mCode[offset]};
+  Op            op {opOf(word)};
+  Reg const     regs[] {aOf(word), bOf(word), cOf(word)};
+  std::uint32_t const *operands {mCode.data() + offset + 1};
+
+  List args;
+  for (std::size_t i = 0; i < OP_REG_TABLE[op]; ++i)
+   args += text("r") + integer(std::uintmax_t {regs[i]});
+  for (std::size_t i = 0; i < OP_OPERAND_TABLE[op]; ++i)
+   args += integer(std::uintmax_t {operands[i]});
+
+  d.clear();
+  d += hpad(4);
+  d += integer(std::uintmax_t {offset});
+  d += colon;
+  d += hpad();
+  d += text(OP_NAME_TABLE[op]);
+  d += hpad();
+  d += args.doc();
+
+  // Annotate constants with what they refer to.
+  std::string_view const *begin {nullptr}, *end {nullptr};
+  if (SPAWN == op || LAUNCH == op)
+   std::tie(begin, end) = command(operands[0]);
+  else if (BUILTIN == op || START == op)
+   std::tie(begin, end) = command(operands[1]);
+  else if (CAPTURE == op) {
+   begin = &mStrings[operands[0]];
+   end   = begin + 1;
+  }
+  if (begin != end) {
+   d += hpad();
+   d += text("#");
+   for (auto it = begin; it != end; ++it) {
+    d += hpad();
+    d += stringLit(*it);
+   }
+  }
+
+  writer.line(d);
+  offset += 1 + OP_OPERAND_TABLE[op];
+ }
+}
+
+} // namespace plush::vm
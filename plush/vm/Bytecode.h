@@ -0,0 +1,138 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Provides the bytecode executed by the Vm. Code is a flat array of 32-bit
+// words, each instruction being one word holding its opcode and register
+// operands followed by the operand words of its opcode, see Opcodes.def.
+
+#pragma once
+
+#ifndef PLUSH_VM_BYTECODE_H
+#define PLUSH_VM_BYTECODE_H
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bits/Doc.h"
+
+namespace plush::vm {
+
+// Kind of instruction.
+enum Op : std::uint8_t {
+#define PLUSH_OPCODE(KIND, ...) KIND,
+#include "vm/Opcodes.def"
+ // Total number of every opcode.
+ _SIZE
+};
+
+// Total number of every opcode.
+constexpr std::size_t OP_SIZE {_SIZE};
+
+// Table of every opcode's name.
+constexpr std::array<std::string_view, OP_SIZE> OP_NAME_TABLE {[] {
+ using namespace std::literals::string_view_literals;
+ return std::array<std::string_view, OP_SIZE> {
+#define PLUSH_OPCODE(KIND, NAME, ...) NAME##sv,
+#include "vm/Opcodes.def"
+ };
+}()};
+
+// Table of every opcode's number of register operands.
+constexpr std::array<std::uint8_t, OP_SIZE> OP_REG_TABLE {
+#define PLUSH_OPCODE(KIND, NAME, REGS, ...) REGS,
+#include "vm/Opcodes.def"
+};
+
+// Table of every opcode's number of operand words.
+constexpr std::array<std::uint8_t, OP_SIZE> OP_OPERAND_TABLE {
+#define PLUSH_OPCODE(KIND, NAME, REGS, OPERAND_WORDS) OPERAND_WORDS,
+#include "vm/Opcodes.def"
+};
+
+// Index of a register.
+using Reg = std::uint8_t;
+
+// Total number of registers of a frame.
+constexpr std::size_t REG_SIZE {256};
+
+// Register holding the descriptor code reads from.
+constexpr Reg REG_IN {0};
+// Register holding the descriptor code writes to.
+constexpr Reg REG_OUT {1};
+
+constexpr std::uint32_t encode(Op op, Reg a = 0, Reg b = 0, Reg c = 0) {
+ return op | a << 8 | b << 16 | static_cast<std::uint32_t>(c) << 24;
+}
+
+constexpr Op  opOf(std::uint32_t word) { return static_cast<Op>(word & 0xFF); }
+constexpr Reg aOf(std::uint32_t word) { return word >> 8; }
+constexpr Reg bOf(std::uint32_t word) { return word >> 16; }
+constexpr Reg cOf(std::uint32_t word) { return word >> 24; }
+
+// Compiled code along with the constants it refers to.
+class Chunk final {
+ std::vector<std::uint32_t> mCode;
+ // String constants, referring to the compiled tree's tokens.
+ std::vector<std::string_view> mStrings;
+ // Range of mStrings holding each command's arguments.
+ std::vector<std::pair<std::uint32_t, std::uint32_t>> mCommands;
+
+public:
+ Chunk() = default;
+ // Constructs a chunk from the parts of another, see code, strings and
+ // commands.
+ Chunk(std::vector<std::uint32_t>                           code,
+       std::vector<std::string_view>                        strings,
+       std::vector<std::pair<std::uint32_t, std::uint32_t>> commands)
+     : mCode {std::move(code)}, mStrings {std::move(strings)},
+       mCommands {std::move(commands)} {}
+
+ std::vector<std::uint32_t> const    &code() const { return mCode; }
+ std::vector<std::string_view> const &strings() const { return mStrings; }
+ std::vector<std::pair<std::uint32_t, std::uint32_t>> const &commands() const {
+  return mCommands;
+ }
+
+ // Appends an instruction, returning its offset.
+ template <class... Operands>
+ std::uint32_t emit(Op op, Reg a, Reg b, Reg c, Operands... operands) {
+  assert(sizeof...(Operands) == OP_OPERAND_TABLE[op]);
+  std::uint32_t offset = mCode.size();
+  mCode.push_back(encode(op, a, b, c));
+  (mCode.push_back(static_cast<std::uint32_t>(operands)), ...);
+  return offset;
+ }
+ // Overwrites the operand word of the instruction at the provided offset.
+ void patch(std::uint32_t offset, std::uint32_t operand, std::size_t i = 0) {
+  mCode[offset + 1 + i] = operand;
+ }
+
+ std::uint32_t addString(std::string_view string) {
+  mStrings.push_back(string);
+  return mStrings.size() - 1;
+ }
+ std::string_view string(std::uint32_t index) const { return mStrings[index]; }
+
+ // Adds a command whose arguments are the strings within [begin, end).
+ std::uint32_t addCommand(std::uint32_t begin, std::uint32_t end) {
+  mCommands.emplace_back(begin, end);
+  return mCommands.size() - 1;
+ }
+ // Arguments of a command.
+ std::pair<std::string_view const *, std::string_view const *>
+ command(std::uint32_t index) const {
+  auto [begin, end] = mCommands[index];
+  return {mStrings.data() + begin, mStrings.data() + end};
+ }
+
+ // Writes a line per instruction.
+ void disassemble(DocWriter &writer) const;
+};
+
+} // namespace plush::vm
+
+#endif // PLUSH_VM_BYTECODE_H
@@ -0,0 +1,281 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "bits/Fd.h"
+#include "bits/platform.h"
+#include "exec/Pipe.h"
+#include "vm/Schedule.h"
+#include "vm/compile.h"
+
+#ifdef PLUSH_POSIX
+#include <unistd.h>
+#endif
+
+namespace plush::vm {
+
+namespace {
+
+// What a statement does that other statements may observe.
+struct Effects {
+ bool barrier {false};
+ bool setsEnv {false};
+
+ Effects &operator|=(Effects const &effects) {
+  barrier |= effects.barrier;
+  setsEnv |= effects.setsEnv;
+  return *this;
+ }
+};
+
+class Analyzer final {
+ ast::Ast const        &mAst;
+ BuiltinRegistry const &mBuiltins;
+
+ Effects effectsOfBlock(ast::Index block) const {
+  Effects           effects;
+  ast::Block const &b {mAst.get<ast::Block>(block)};
+  for (ast::Index i = b.stmtBegin; i < b.stmtEnd; ++i)
+   effects |= effectsOf(mAst.stmt(i));
+  return effects;
+ }
+
+public:
+ Analyzer(ast::Ast const &ast, BuiltinRegistry const &builtins)
+     : mAst {ast}, mBuiltins {builtins} {}
+
+ Effects effectsOf(ast::Ref expr) const {
+  switch (expr.kind()) {
+  case ast::Kind::COMMAND: {
+   TokenView name {mAst.tokBuf()[mAst.get<ast::Command>(expr).tokBegin]};
+   if (!name.is<token::Id>()) return {};
+   auto builtin {mBuiltins.find(name.get<token::Id>().id())};
+   return {builtin && BUILTINS[*builtin].affectsPlush, false};
+  }
+  // Builtins affecting Plush run isolated when they're pipe stages.
+  case ast::Kind::BINOP: return {};
+  case ast::Kind::DO: return effectsOfBlock(expr.index());
+  case ast::Kind::IF: {
+   ast::If const &i {mAst.get<ast::If>(expr)};
+   Effects        effects {effectsOf(i.cond)};
+   effects |= effectsOfBlock(i.thenBlock);
+   if (ast::NONE != i.elseBlock) effects |= effectsOfBlock(i.elseBlock);
+   return effects;
+  }
+  case ast::Kind::LET: {
+   Effects effects {effectsOf(mAst.get<ast::Let>(expr).value)};
+   effects.setsEnv = true;
+   return effects;
+  }
+  case ast::Kind::MODULE:
+  case ast::Kind::IMPORT: return {};
+  }
+  return {};
+ }
+
+ // Appends the statements of a block, and of the `do` blocks within it.
+ void flatten(ast::Index block, std::vector<ast::Ref> &stmts) const {
+  ast::Block const &b {mAst.get<ast::Block>(block)};
+  for (ast::Index i = b.stmtBegin; i < b.stmtEnd; ++i) {
+   ast::Ref stmt {mAst.stmt(i)};
+   if (ast::Kind::DO == stmt.kind())
+    flatten(stmt.index(), stmts);
+   else
+    stmts.push_back(stmt);
+  }
+ }
+};
+
+} // namespace
+
+[[nodiscard]] Expect<Schedule> Schedule::analyze(
+  ast::Ast const &ast, BuiltinRegistry const &builtins) {
+ Analyzer              analyzer {ast, builtins};
+ std::vector<ast::Ref> stmts;
+ analyzer.flatten(ast.root(), stmts);
+
+ Schedule schedule;
+ auto    &tasks {schedule.mTasks};
+ tasks.reserve(stmts.size());
+ auto depend = [&](std::uint32_t task, std::uint32_t predecessor) {
+  tasks[predecessor].successors.push_back(task);
+  ++tasks[task].predecessorCount;
+ };
+
+ // Environment setters wait for the previous one, so they run in program order
+ // and every task only needs to wait for the latest setter and barrier before
+ // it. A barrier waits for every task since the previous one.
+ std::uint32_t              lastBarrier {ast::NONE}, lastEnvTask {ast::NONE};
+ std::vector<std::uint32_t> sinceBarrier;
+ for (ast::Ref stmt : stmts) {
+  auto eChunk {compile(ast, stmt, builtins)};
+  if (!eChunk) return eChunk.takeError<BasicError>();
+
+  std::uint32_t const index = tasks.size();
+  Effects const       effects {analyzer.effectsOf(stmt)};
+  Task               &task {tasks.emplace_back(Task {std::move(*eChunk)})};
+  task.envTask = lastEnvTask;
+  task.setsEnv = effects.setsEnv;
+
+  if (effects.barrier) {
+   if (ast::NONE != lastBarrier) depend(index, lastBarrier);
+   for (std::uint32_t previous : sinceBarrier) depend(index, previous);
+   sinceBarrier.clear();
+   lastBarrier = index;
+  } else {
+   if (ast::NONE != lastEnvTask &&
+       (ast::NONE == lastBarrier || lastEnvTask > lastBarrier))
+    depend(index, lastEnvTask);
+   else if (ast::NONE != lastBarrier)
+    depend(index, lastBarrier);
+   sinceBarrier.push_back(index);
+  }
+  if (effects.setsEnv) lastEnvTask = index;
+ }
+
+ return schedule;
+}
+
+class Schedule::Run final {
+ std::vector<Task> const &mTasks;
+ WorkStealingPool        &mPool;
+ int const                mIn, mOut;
+ // Environment before the first task.
+ std::vector<std::string> const mEnv;
+ // Vm of each worker.
+ std::deque<Vm> mVms;
+ // Number of unfinished predecessors of each task.
+ std::unique_ptr<std::atomic<std::uint32_t>[]> mRemaining;
+ // Environment after each task setting environment variables, written before
+ // its successors start.
+ std::vector<std::vector<std::string>> mEnvs;
+ std::vector<int>                      mStatuses;
+ // Set once a task fails or runs exit, skipping every task not yet started.
+ std::atomic<bool> mStopped {false};
+
+ // Guards every member below.
+ std::mutex mMutex;
+ // Buffered output of each finished task until it's written.
+ std::vector<Fd>   mOutputs;
+ std::vector<bool> mFinished;
+ // First task whose output wasn't written.
+ std::size_t mNextOutput {0};
+ // Latest task setting environment variables that ran.
+ std::optional<std::uint32_t> mLastEnvTask;
+ std::optional<int>            mExitStatus;
+ std::optional<BasicError>     mError;
+
+ void fail(BasicError &&error) {
+  std::lock_guard guard {mMutex};
+  if (!mError) mError.emplace(std::move(error));
+  mStopped = true;
+ }
+
+ void execute(std::uint32_t index) {
+  Task const &task {mTasks[index]};
+  Vm         &vm {mVms[mPool.workerIndex()]};
+  vm.launcher().setEnvOverrides(
+    ast::NONE == task.envTask ? mEnv : mEnvs[task.envTask]);
+
+  Fd output {openTmpFile()};
+  if (!output.valid()) {
+   fail(BasicError {std::strerror(errno)});
+   return;
+  }
+  auto eStatus {vm.run(task.chunk, mIn, output.get())};
+  if (!eStatus) {
+   fail(eStatus.takeError<BasicError>());
+   return;
+  }
+  mStatuses[index] = *eStatus;
+  if (task.setsEnv) mEnvs[index] = vm.launcher().envOverrides();
+
+  std::lock_guard guard {mMutex};
+  mOutputs[index] = std::move(output);
+  if (task.setsEnv && (!mLastEnvTask || *mLastEnvTask < index))
+   mLastEnvTask = index;
+  if (vm.exited()) {
+   mExitStatus = *eStatus;
+   mStopped    = true;
+  }
+ }
+
+ // Writes the output of every finished task not preceded by an unfinished
+ // one.
+ void flush() {
+#ifdef PLUSH_POSIX
+  for (; mNextOutput < mTasks.size() && mFinished[mNextOutput];
+       ++mNextOutput) {
+   Fd output {std::move(mOutputs[mNextOutput])};
+   if (!output.valid()) continue;
+   if (::lseek(output.get(), 0, SEEK_SET) < 0) {
+    if (!mError) mError.emplace(std::strerror(errno));
+    continue;
+   }
+   // A closed output only loses the output, like it would sequentially.
+   (void)exec::transfer(output.get(), mOut);
+  }
+#endif
+ }
+
+public:
+ Run(std::vector<Task> const &tasks, WorkStealingPool &pool, Vm &vm, int in,
+     int out)
+     : mTasks {tasks}, mPool {pool}, mIn {in}, mOut {out},
+       mEnv {vm.launcher().envOverrides()},
+       mVms(pool.threadCount()),
+       mRemaining {new std::atomic<std::uint32_t>[tasks.size()]},
+       mEnvs(tasks.size()), mStatuses(tasks.size()),
+       mOutputs(tasks.size()), mFinished(tasks.size()) {
+  for (std::size_t i = 0; i < tasks.size(); ++i)
+   mRemaining[i] = tasks[i].predecessorCount;
+ }
+
+ // Queues a task whose predecessors finished.
+ void start(std::uint32_t index) {
+  mPool.submit([this, index] {
+   if (!mStopped) execute(index);
+   {
+    std::lock_guard guard {mMutex};
+    mFinished[index] = true;
+    flush();
+   }
+   for (std::uint32_t successor : mTasks[index].successors)
+    if (1 == mRemaining[successor].fetch_sub(1, std::memory_order_acq_rel))
+     start(successor);
+  });
+ }
+
+ // Leaves the environment of the latest setter within vm, returning the exit
+ // status of the run.
+ Expect<int> finish(Vm &vm) {
+  if (mError) return std::move(*mError);
+  if (mLastEnvTask) vm.launcher().setEnvOverrides(mEnvs[*mLastEnvTask]);
+  if (mExitStatus) {
+   vm.exit(*mExitStatus);
+   return *mExitStatus;
+  }
+  return mStatuses.back();
+ }
+};
+
+[[nodiscard]] Expect<int> Schedule::run(Vm &vm, WorkStealingPool &pool, int in,
+                                        int out) const {
+ if (mTasks.empty()) return 0;
+
+ Run run {mTasks, pool, vm, in, out};
+ for (std::uint32_t i = 0; i < mTasks.size(); ++i)
+  if (!mTasks[i].predecessorCount) run.start(i);
+ pool.wait();
+ return run.finish(vm);
+}
+
+} // namespace plush::vm
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_VM_SCHEDULE_H
+#define PLUSH_VM_SCHEDULE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "bits/Expect.h"
+#include "bits/WorkStealingPool.h"
+#include "parser/Ast.h"
+#include "vm/Builtins.h"
+#include "vm/Bytecode.h"
+#include "vm/Vm.h"
+
+namespace plush::vm {
+
+// Top level statements of a tree compiled separately, along with which of them
+// must wait for which. Statements of top level `do` blocks count as top level
+// statements, since blocks don't scope anything. A statement waits for an
+// earlier one if either:
+//  - runs a builtin affecting Plush itself, such as cd or exit, making it a
+//    barrier every statement is ordered against;
+//  - the earlier one sets environment variables, since any launched command
+//    may read them.
+// Every other pair of statements is independent. Nothing is known of what
+// launched commands do besides reading their environment, so statements
+// sharing files or stdin must be ordered by the script, e.g. within a pipe.
+class Schedule final {
+ // Statement run as a unit.
+ struct Task {
+  Chunk chunk;
+  // Tasks waiting for this one.
+  std::vector<std::uint32_t> successors;
+  // Number of tasks this one waits for.
+  std::uint32_t predecessorCount {0};
+  // Latest earlier task setting environment variables, whose environment this
+  // one runs with, or ast::NONE.
+  std::uint32_t envTask {ast::NONE};
+  bool          setsEnv {false};
+ };
+
+ // State of a single run, shared by its tasks.
+ class Run;
+
+ std::vector<Task> mTasks;
+
+ Schedule() = default;
+
+public:
+ // Splits a tree into statements and orders them. The statements refer to the
+ // tree's tokens.
+ [[nodiscard]] static Expect<Schedule> analyze(ast::Ast const        &ast,
+                                               BuiltinRegistry const &builtins);
+
+ // Number of statements.
+ std::size_t size() const { return mTasks.size(); }
+ Chunk const &chunk(std::size_t task) const { return mTasks[task].chunk; }
+ // Later statements waiting for a statement, in program order.
+ std::vector<std::uint32_t> const &successors(std::size_t task) const {
+  return mTasks[task].successors;
+ }
+
+ // Runs every statement on the pool as soon as the statements it waits for
+ // finish, each with its own Vm per worker, starting from the environment of
+ // the provided Vm. The output of each statement is buffered and written to
+ // out in program order, while every statement reads from in. Once a
+ // statement runs exit, statements after it are skipped. Returns the exit
+ // status of the last statement, or the one requested by exit, leaving the
+ // environment of the last statement run within the provided Vm.
+ [[nodiscard]] Expect<int> run(Vm &vm, WorkStealingPool &pool, int in = 0,
+                               int out = 1) const;
+};
+
+} // namespace plush::vm
+
+#endif // PLUSH_VM_SCHEDULE_H
@@ -0,0 +1,274 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <array>
+#include <csignal>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include "bits/Doc.h"
+#include "bits/Fd.h"
+#include "bits/platform.h"
+#include "exec/Pipe.h"
+#include "vm/Builtins.h"
+#include "vm/Vm.h"
+
+#ifdef PLUSH_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PLUSH_COMPUTED_GOTO
+#endif
+
+namespace plush::vm {
+
+// Process identifier of a command that couldn't be launched.
+constexpr int NOT_LAUNCHED {-1};
+
+#ifdef PLUSH_POSIX
+// Reads a whole file from its start.
+static Expect<std::string> readFile(int fd) {
+ std::string content;
+ char        buffer[1 << 14];
+ for (off_t offset = 0;;) {
+  ssize_t n {::pread(fd, buffer, sizeof buffer, offset)};
+  if (n < 0) {
+   if (EINTR == errno) continue;
+   return BasicError {std::strerror(errno)};
+  }
+  if (!n) return content;
+  content.append(buffer, n);
+  offset += n;
+ }
+}
+
+// Runs a builtin pipeline stage, closing its descriptors once it returns.
+static Task runStage(Task builtin, int in, int out) {
+ int status {co_await builtin};
+ ::close(in);
+ ::close(out);
+ co_return status;
+}
+#endif
+
+// Awaits a launched pipeline stage.
+static Task awaitStage(exec::EventLoop &loop, exec::Pid pid) {
+ if (NOT_LAUNCHED == pid) co_return 127;
+ co_return co_await loop.wait(pid);
+}
+
+Vm::Vm(exec::EventLoop::Backend backend) : mLoop {backend} {
+#ifdef PLUSH_POSIX
+ std::signal(SIGPIPE, SIG_IGN);
+#endif
+}
+
+[[nodiscard]] Expect<int> Vm::run(Chunk const &chunk, int in, int out) {
+ auto eStatus {execute(chunk, in, out)};
+ // A chunk stopping early may leave jobs behind.
+ for (auto &job : mJobs)
+  if (!job.done())
+   if (auto eFinished = mLoop.finish(job); !eFinished && eStatus)
+    eStatus = eFinished.takeError<BasicError>();
+ mJobs.clear();
+ exec::Pipe::release(mGrown);
+ mGrown = 0;
+ return eStatus;
+}
+
+[[nodiscard]] Expect<int> Vm::execute(Chunk const &chunk, int in, int out) {
+#ifdef PLUSH_POSIX
+ std::array<int, REG_SIZE> regs;
+ regs[REG_IN]  = in;
+ regs[REG_OUT] = out;
+ mExitStatus.reset();
+
+ std::uint32_t const *const code {chunk.code().data()};
+ std::uint32_t const       *pc {code};
+ std::uint32_t              word;
+
+ // Each handler decodes its instruction, runs it and dispatches the next one.
+ // With computed gotos every handler ends in its own indirect jump, which
+ // branch predictors track separately, instead of sharing the switch's single
+ // jump.
+#ifdef PLUSH_COMPUTED_GOTO
+ static void *const LABELS[] {
+#define PLUSH_OPCODE(KIND, ...) &&op_##KIND,
+#include "vm/Opcodes.def"
+ };
+#define DISPATCH()                                                             \
+ do {                                                                          \
+  word = *pc;                                                                  \
+  goto *LABELS[opOf(word)];                                                    \
+ } while (0)
+#define CASE(KIND) op_##KIND:
+ DISPATCH();
+#else
+#define DISPATCH() continue
+#define CASE(KIND) case KIND:
+ for (;;) {
+  word = *pc;
+  switch (opOf(word)) {
+#endif
+
+ CASE(LOADI) {
+  regs[aOf(word)] = static_cast<int>(pc[1]);
+  pc += 2;
+  DISPATCH();
+ }
+ CASE(PIPE) {
+  auto ePipe {exec::Pipe::open(pc[1])};
+  if (!ePipe) return ePipe.takeError<BasicError>();
+  regs[aOf(word)]     = (*ePipe).read.release();
+  regs[aOf(word) + 1] = (*ePipe).write.release();
+  mGrown += (*ePipe).grown;
+  pc += 2;
+  DISPATCH();
+ }
+ CASE(TMPFILE) {
+  int fd {openTmpFile().release()};
+  if (fd < 0) return BasicError {std::strerror(errno)};
+  regs[aOf(word)] = fd;
+  pc += 1;
+  DISPATCH();
+ }
+ CASE(CLOSE) {
+  ::close(regs[aOf(word)]);
+  pc += 1;
+  DISPATCH();
+ }
+ CASE(SPAWN) {
+  auto [argBegin, argEnd] = chunk.command(pc[1]);
+  exec::Redirect const redirects[] {
+    exec::Redirect::dup(0, regs[bOf(word)]),
+    exec::Redirect::dup(1, regs[cOf(word)])};
+  auto ePid {mLauncher.spawn(argBegin, argEnd, std::begin(redirects),
+                             std::end(redirects))};
+  if (ePid)
+   regs[aOf(word)] = *ePid;
+  else {
+   using namespace doc;
+   DocWriter {2}.line(text(ePid.takeError<BasicError>().userFriendlyMessage()));
+   regs[aOf(word)] = NOT_LAUNCHED;
+  }
+  pc += 2;
+  DISPATCH();
+ }
+ CASE(WAIT) {
+  int pid {regs[bOf(word)]};
+  if (NOT_LAUNCHED == pid)
+   regs[aOf(word)] = 127;
+  else {
+   auto eStatus {mLoop.join(pid)};
+   if (!eStatus) return eStatus.takeError<BasicError>();
+   regs[aOf(word)] = *eStatus;
+  }
+  pc += 1;
+  DISPATCH();
+ }
+ CASE(BUILTIN) {
+  auto [argBegin, argEnd] = chunk.command(pc[2]);
+  Task task {BUILTINS[pc[1]].fn(
+    {*this, argBegin, argEnd, regs[bOf(word)], regs[cOf(word)]})};
+  if (auto eRan = mLoop.run(task); !eRan) return eRan.takeError<BasicError>();
+  regs[aOf(word)] = task.result();
+  if (mExitStatus) return *mExitStatus;
+  pc += 3;
+  DISPATCH();
+ }
+ CASE(START) {
+  // The job owns duplicates of its descriptors so the chunk closes pipe ends
+  // right away for every stage alike, the job's ends stay open until it
+  // returns.
+  int jobIn {::fcntl(regs[bOf(word)], F_DUPFD_CLOEXEC, 0)};
+  if (jobIn < 0) return BasicError {std::strerror(errno)};
+  int jobOut {::fcntl(regs[cOf(word)], F_DUPFD_CLOEXEC, 0)};
+  if (jobOut < 0) {
+   ::close(jobIn);
+   return BasicError {std::strerror(errno)};
+  }
+
+  auto [argBegin, argEnd] = chunk.command(pc[2]);
+  mJobs.push_back(runStage(
+    BUILTINS[pc[1]].fn({*this, argBegin, argEnd, jobIn, jobOut, true}),
+    jobIn, jobOut));
+  mLoop.start(mJobs.back());
+  regs[aOf(word)] = static_cast<int>(mJobs.size() - 1);
+  pc += 3;
+  DISPATCH();
+ }
+ CASE(LAUNCH) {
+  auto [argBegin, argEnd] = chunk.command(pc[1]);
+  exec::Redirect const redirects[] {
+    exec::Redirect::dup(0, regs[bOf(word)]),
+    exec::Redirect::dup(1, regs[cOf(word)])};
+  auto ePid {mLauncher.spawn(argBegin, argEnd, std::begin(redirects),
+                             std::end(redirects))};
+  exec::Pid pid {NOT_LAUNCHED};
+  if (ePid)
+   pid = *ePid;
+  else {
+   using namespace doc;
+   DocWriter {2}.line(text(ePid.takeError<BasicError>().userFriendlyMessage()));
+  }
+  mJobs.push_back(awaitStage(mLoop, pid));
+  mLoop.start(mJobs.back());
+  regs[aOf(word)] = static_cast<int>(mJobs.size() - 1);
+  pc += 2;
+  DISPATCH();
+ }
+ CASE(JOIN) {
+  // The loop interleaves every started job while it runs, so finishing them in
+  // order waits no longer than the slowest one.
+  std::size_t const first {static_cast<std::size_t>(regs[bOf(word)])};
+  for (std::size_t i = first; i < first + pc[1]; ++i) {
+   if (auto eFinished = mLoop.finish(mJobs[i]); !eFinished)
+    return eFinished.takeError<BasicError>();
+   if (mJobs[i].result() < 0)
+    return BasicError {std::strerror(-mJobs[i].result())};
+  }
+  regs[aOf(word)] = mJobs[first + pc[1] - 1].result();
+  // Every stage exited, closing its pipe ends.
+  exec::Pipe::release(mGrown);
+  mGrown = 0;
+  pc += 2;
+  DISPATCH();
+ }
+ CASE(CAPTURE) {
+  int  fd {regs[aOf(word)]};
+  auto eContent {readFile(fd)};
+  ::close(fd);
+  if (!eContent) return eContent.takeError<BasicError>();
+  std::string &content {*eContent};
+  if (!content.empty() && '\n' == content.back()) content.pop_back();
+  mLauncher.setEnv(chunk.string(pc[1]), content);
+  pc += 2;
+  DISPATCH();
+ }
+ CASE(JUMP) {
+  pc = code + pc[1];
+  DISPATCH();
+ }
+ CASE(JUMPFAIL) {
+  pc = regs[aOf(word)] ? code + pc[1] : pc + 2;
+  DISPATCH();
+ }
+ CASE(HALT) { return regs[aOf(word)]; }
+
+#ifndef PLUSH_COMPUTED_GOTO
+  }
+ }
+#endif
+#undef DISPATCH
+#undef CASE
+#else
+ return BasicError {"Running is unsupported on this platform"};
+#endif
+}
+
+} // namespace plush::vm
@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_VM_VM_H
+#define PLUSH_VM_VM_H
+
+#include <optional>
+#include <vector>
+
+#include "bits/Expect.h"
+#include "bits/Task.h"
+#include "exec/EventLoop.h"
+#include "exec/Launcher.h"
+#include "vm/Bytecode.h"
+
+namespace plush::vm {
+
+// Register-based virtual machine executing compiled Chunks. Registers hold
+// descriptors, process identifiers, jobs and exit statuses. Builtins and the
+// stages of pipes run as coroutines on the Vm's event loop, on the thread
+// running the Vm.
+class Vm final {
+ exec::Launcher  mLauncher;
+ exec::EventLoop mLoop;
+ // Exit status requested by a builtin, stopping execution.
+ std::optional<int> mExitStatus;
+ // Pipeline stages started by the running chunk, their register holds their
+ // index.
+ std::vector<Task> mJobs;
+ // Capacity taken by the pipes grown since the last join.
+ std::size_t mGrown {0};
+
+ [[nodiscard]] Expect<int> execute(Chunk const &chunk, int in, int out);
+
+public:
+ // Ignores SIGPIPE within the Plush process, so builtins writing to a pipe
+ // whose reader exited fail with EPIPE instead of killing Plush. The event
+ // loop uses the given backend, or the next one supported.
+ explicit Vm(exec::EventLoop::Backend backend =
+               exec::EventLoop::Backend::IO_URING);
+
+ exec::Launcher  &launcher() { return mLauncher; }
+ exec::EventLoop &loop() { return mLoop; }
+
+ // Stops the running chunk once the current instruction finishes.
+ void exit(int status) { mExitStatus = status; }
+ // Did the last run chunk stop because of exit?
+ bool exited() const { return mExitStatus.has_value(); }
+
+ // Runs a chunk reading from in and writing to out. Returns the exit status
+ // of its last statement, or the one requested by exit.
+ [[nodiscard]] Expect<int> run(Chunk const &chunk, int in = 0, int out = 1);
+};
+
+} // namespace plush::vm
+
+#endif // PLUSH_VM_VM_H
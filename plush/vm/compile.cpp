@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <optional>
+#include <vector>
+
+#include "vm/Builtins.h"
+#include "vm/compile.h"
+
+namespace plush::vm {
+
+namespace {
+
+class Compiler final {
+ ast::Ast const        &mAst;
+ BuiltinRegistry const &mBuiltins;
+ Chunk                  mChunk;
+ // Next free register, registers are allocated and freed as a stack.
+ std::size_t mNextReg {REG_OUT + 1};
+ // First error encountered, compilation continues but its result is dropped.
+ std::optional<BasicError> mError;
+
+ void fail(std::string message) {
+  if (!mError) mError.emplace(std::move(message));
+ }
+
+ // Allocates count consecutive registers.
+ Reg alloc(std::size_t count = 1) {
+  if (mNextReg + count > REG_SIZE) {
+   fail("Expression needs too many registers");
+   return 0;
+  }
+  Reg reg = mNextReg;
+  mNextReg += count;
+  return reg;
+ }
+
+ // Adds a command's words as string constants.
+ std::uint32_t addCommand(ast::Command const &command) {
+  std::uint32_t begin {0};
+  for (ast::Index i = command.tokBegin; i < command.tokEnd; ++i) {
+   TokenView        tok {mAst.tokBuf()[i]};
+   std::uint32_t    index {mChunk.addString(
+     tok.is<token::String>() ? tok.get<token::String>().string()
+                                : tok.get<token::Id>()->stringRep())};
+   if (i == command.tokBegin) begin = index;
+  }
+  return mChunk.addCommand(begin, begin + (command.tokEnd - command.tokBegin));
+ }
+
+ // Appends the stages of a pipe in the direction data flows.
+ void flatten(ast::Ref expr, std::vector<ast::Command const *> &stages) {
+  if (ast::Kind::COMMAND == expr.kind()) {
+   stages.push_back(&mAst.get<ast::Command>(expr));
+   return;
+  }
+  if (ast::Kind::BINOP != expr.kind()) {
+   fail("Only commands and pipes can be piped");
+   return;
+  }
+
+  ast::BinOp const &binOp {mAst.get<ast::BinOp>(expr)};
+  bool const        lpipe {token::BinOp::LPIPE == binOp.op};
+  flatten(lpipe ? binOp.rhs : binOp.lhs, stages);
+  flatten(lpipe ? binOp.lhs : binOp.rhs, stages);
+ }
+
+ // Finds the builtin a command names, if any.
+ std::optional<std::uint32_t> findBuiltin(ast::Command const &command) const {
+  TokenView name {mAst.tokBuf()[command.tokBegin]};
+  if (!name.is<token::Id>()) return std::nullopt;
+  return mBuiltins.find(name.get<token::Id>().id());
+ }
+
+ void compileCommand(ast::Command const &command, Reg in, Reg out, Reg dst) {
+  std::uint32_t commandIndex {addCommand(command)};
+
+  if (auto builtin = findBuiltin(command)) {
+   mChunk.emit(BUILTIN, dst, in, out, *builtin, commandIndex);
+   return;
+  }
+
+  std::size_t mark {mNextReg};
+  Reg         pid {alloc()};
+  mChunk.emit(SPAWN, pid, in, out, commandIndex);
+  mChunk.emit(WAIT, dst, pid, 0);
+  mNextReg = mark;
+ }
+
+ void compilePipe(ast::Ref expr, Reg in, Reg out, Reg dst) {
+  std::vector<ast::Command const *> stages;
+  flatten(expr, stages);
+
+  // Jobs are numbered in start order, so only the first stage's job is kept.
+  // Pipes alternate between two register pairs, each pair being free again once
+  // the stage after its reader started, so a pipe of any length needs a handful
+  // of registers.
+  std::size_t mark {mNextReg};
+  Reg         firstJob {alloc()}, job {alloc()}, pipes {alloc(4)};
+  Reg         prevRead {in};
+  for (std::size_t i = 0; i < stages.size(); ++i) {
+   bool const last {i + 1 == stages.size()};
+   Reg        pipe {out};
+   auto       builtin {findBuiltin(*stages[i])};
+   if (!last) {
+    // Only pipes between two commands are grown. Builtins splice through
+    // default sized pipes just as well, and long pipes of them would use up
+    // the budget.
+    bool const grow {!builtin && !findBuiltin(*stages[i + 1])};
+    pipe = pipes + 2 * (i % 2);
+    mChunk.emit(PIPE, pipe, 0, 0, grow);
+   }
+
+   Reg const     stageOut = last ? out : pipe + 1;
+   Reg const     stageJob = i ? job : firstJob;
+   std::uint32_t commandIndex {addCommand(*stages[i])};
+   if (builtin)
+    mChunk.emit(START, stageJob, prevRead, stageOut, *builtin, commandIndex);
+   else
+    mChunk.emit(LAUNCH, stageJob, prevRead, stageOut, commandIndex);
+   // Only the stages hold on to the pipe ends, so each side sees end of file
+   // or a broken pipe as soon as its neighbour exits.
+   if (i) mChunk.emit(CLOSE, prevRead, 0, 0);
+   if (!last) mChunk.emit(CLOSE, pipe + 1, 0, 0);
+   prevRead = pipe;
+  }
+
+  mChunk.emit(JOIN, dst, firstJob, 0, stages.size());
+  mNextReg = mark;
+ }
+
+ void compileBlock(ast::Index block, Reg in, Reg out, Reg dst) {
+  ast::Block const &b {mAst.get<ast::Block>(block)};
+  if (b.stmtBegin == b.stmtEnd) mChunk.emit(LOADI, dst, 0, 0, 0);
+  for (ast::Index i = b.stmtBegin; i < b.stmtEnd; ++i)
+   compileExpr(mAst.stmt(i), in, out, dst);
+ }
+
+ void compileExpr(ast::Ref expr, Reg in, Reg out, Reg dst) {
+  switch (expr.kind()) {
+  case ast::Kind::COMMAND:
+   compileCommand(mAst.get<ast::Command>(expr), in, out, dst);
+   break;
+  case ast::Kind::BINOP: compilePipe(expr, in, out, dst); break;
+  case ast::Kind::DO: compileBlock(expr.index(), in, out, dst); break;
+  case ast::Kind::IF: {
+   ast::If const &i {mAst.get<ast::If>(expr)};
+   compileExpr(i.cond, in, out, dst);
+   std::uint32_t jumpElse {mChunk.emit(JUMPFAIL, dst, 0, 0, 0)};
+   compileBlock(i.thenBlock, in, out, dst);
+   std::uint32_t jumpEnd {mChunk.emit(JUMP, 0, 0, 0, 0)};
+   mChunk.patch(jumpElse, mChunk.code().size());
+   if (ast::NONE != i.elseBlock)
+    compileBlock(i.elseBlock, in, out, dst);
+   else
+    mChunk.emit(LOADI, dst, 0, 0, 0);
+   mChunk.patch(jumpEnd, mChunk.code().size());
+   break;
+  }
+  case ast::Kind::LET: {
+   ast::Let const &l {mAst.get<ast::Let>(expr)};
+   std::size_t     mark {mNextReg};
+   Reg             file {alloc()};
+   mChunk.emit(TMPFILE, file, 0, 0);
+   compileExpr(l.value, in, file, dst);
+   mChunk.emit(CAPTURE, file, 0, 0,
+               mChunk.addString(
+                 mAst.tokBuf()[l.nameTok].get<token::Id>()->stringRep()));
+   mNextReg = mark;
+   break;
+  }
+  case ast::Kind::MODULE:
+  case ast::Kind::IMPORT: mChunk.emit(LOADI, dst, 0, 0, 0); break;
+  }
+ }
+
+public:
+ Compiler(ast::Ast const &ast, BuiltinRegistry const &builtins)
+     : mAst {ast}, mBuiltins {builtins} {}
+
+ Expect<Chunk> compile() && {
+  return std::move(*this).compile(ast::Ref {ast::Kind::DO, mAst.root()});
+ }
+
+ Expect<Chunk> compile(ast::Ref expr) && {
+  Reg status {alloc()};
+  compileExpr(expr, REG_IN, REG_OUT, status);
+  mChunk.emit(HALT, status, 0, 0);
+
+  if (mError) return std::move(*mError);
+  return std::move(mChunk);
+ }
+};
+
+} // namespace
+
+[[nodiscard]] Expect<Chunk> compile(ast::Ast const         &ast,
+                                    BuiltinRegistry const &builtins) {
+ return Compiler {ast, builtins}.compile();
+}
+
+[[nodiscard]] Expect<Chunk> compile(ast::Ast const &ast, ast::Ref stmt,
+                                    BuiltinRegistry const &builtins) {
+ return Compiler {ast, builtins}.compile(stmt);
+}
+
+} // namespace plush::vm
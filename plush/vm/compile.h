@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: Copyright (c) 2023, Maxine DeAndrade
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#ifndef PLUSH_VM_COMPILE_H
+#define PLUSH_VM_COMPILE_H
+
+#include "bits/Expect.h"
+#include "parser/Ast.h"
+#include "vm/Builtins.h"
+#include "vm/Bytecode.h"
+
+namespace plush::vm {
+
+// Compiles a tree to bytecode. Every statement leaves its exit status in a
+// register:
+//  - commands launch and wait for their process, or invoke their builtin;
+//  - pipes start every stage as a job before waiting for any, taking the exit
+//    status of the last stage in data flow order. Stages must be commands,
+//    builtin stages run isolated as coroutines on the Vm's event loop;
+//  - `if` runs its then block if the condition's status is 0, else its else
+//    block, if any;
+//  - `let` exports the output of its expression to launched commands as an
+//    environment variable;
+//  - `module` and `import` don't run anything, the driver runs imported
+//    modules beforehand.
+// Builtins are looked up within the registry, built from the IdTable the tree
+// was lexed with. The chunk refers to the tree's tokens.
+[[nodiscard]] Expect<Chunk> compile(ast::Ast const         &ast,
+                                    BuiltinRegistry const &builtins);
+// Compiles a single statement of a tree, to be run by itself.
+[[nodiscard]] Expect<Chunk> compile(ast::Ast const         &ast,
+                                    ast::Ref                stmt,
+                                    BuiltinRegistry const &builtins);
+
+} // namespace plush::vm
+
+#endif // PLUSH_VM_COMPILE_H
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "exec/EventLoop.h"
+#include "exec/Pipe.h"
+#include "harness.h"
+
+using namespace plush;
+using Backend = exec::EventLoop::Backend;
+
+static char const *name(Backend backend) {
+ switch (backend) {
+ case Backend::IO_URING: return "io_uring";
+ case Backend::EPOLL: return "epoll";
+ case Backend::POLL: return "poll";
+ }
+ return "?";
+}
+
+// Writes every byte, then closes the descriptor.
+static Task writeAll(exec::EventLoop &loop, int fd, std::string_view data) {
+ while (!data.empty()) {
+  int n {co_await loop.write(fd, data.data(), data.size())};
+  if (n <= 0) co_return 1;
+  data.remove_prefix(n);
+ }
+ ::close(fd);
+ co_return 0;
+}
+
+// Reads until end of file, then closes the descriptor.
+static Task readAll(exec::EventLoop &loop, int fd, std::string &data) {
+ char buffer[1 << 12];
+ for (;;) {
+  int n {co_await loop.read(fd, buffer, sizeof buffer)};
+  if (n < 0) co_return 1;
+  if (!n) break;
+  data.append(buffer, n);
+ }
+ ::close(fd);
+ co_return 0;
+}
+
+// Splices until end of file, then closes both descriptors.
+static Task spliceAll(exec::EventLoop &loop, int in, int out) {
+ for (;;) {
+  int n {co_await loop.splice(in, out, 1 << 16)};
+  if (n < 0) co_return 1;
+  if (!n) break;
+ }
+ ::close(in);
+ ::close(out);
+ co_return 0;
+}
+
+// Awaits a process, then creates the file at the path, if any.
+static Task awaitThenCreate(exec::EventLoop &loop, exec::Pid pid,
+                            std::filesystem::path path) {
+ int status {co_await loop.wait(pid)};
+ if (!path.empty()) std::ofstream {path};
+ co_return status;
+}
+
+static Expect<exec::Pid> launch(exec::Launcher &launcher,
+                                std::string_view script) {
+ std::string_view const args[] {"sh", "-c", script};
+ return launcher.spawn(std::begin(args), std::end(args));
+}
+
+// Moves data through a pipe and awaits processes on a loop of the backend.
+static bool checkLoop(Backend backend) {
+ exec::EventLoop loop {backend};
+ bool            ok {true};
+
+ // A writer far outpacing the pipe's capacity interleaves with its reader.
+ auto ePipe {exec::Pipe::open()};
+ if (!ePipe) return false;
+ std::string const sent(1 << 20, 'x');
+ std::string       received;
+ Task writer {writeAll(loop, (*ePipe).write.release(), sent)};
+ Task reader {readAll(loop, (*ePipe).read.release(), received)};
+ loop.start(writer);
+ ok &= loop.run(reader) && loop.finish(writer);
+ ok &= !writer.result() && !reader.result() && received == sent;
+
+ // Splicing between pipes moves the data as is.
+ auto eIn {exec::Pipe::open()}, eOut {exec::Pipe::open()};
+ if (!eIn || !eOut) return false;
+ std::string spliced;
+ Task        feeder {writeAll(loop, (*eIn).write.release(), sent)};
+ Task splicer {spliceAll(loop, (*eIn).read.release(), (*eOut).write.release())};
+ Task drainer {readAll(loop, (*eOut).read.release(), spliced)};
+ loop.start(feeder);
+ loop.start(splicer);
+ ok &= loop.run(drainer) && loop.finish(feeder) && loop.finish(splicer);
+ ok &= !splicer.result() && !drainer.result() && spliced == sent;
+
+ exec::Launcher launcher;
+ auto           ePid {launch(launcher, "exit 7")};
+ if (!ePid) return false;
+ auto eStatus {loop.join(*ePid)};
+ ok &= eStatus && 7 == *eStatus;
+
+ // Processes are awaited at once: each one waits for a file created once the
+ // next one exited, giving up after 10s, so awaiting them one at a time would
+ // leave all but the last waiting in vain.
+ auto const dir {std::filesystem::temp_directory_path() /
+                 ("plush_eventloop_" + std::to_string(::getpid()))};
+ std::filesystem::create_directories(dir);
+ std::vector<Task> waits;
+ for (int i = 0; i < 8; ++i) {
+  auto eWaiting {launch(launcher, "i=0; until test -e " +
+                                    (dir / std::to_string(i)).string() +
+                                    "; do i=$((i+1)); test $i -gt 1000 && "
+                                    "exit 100; sleep 0.01; done; exit " +
+                                    std::to_string(i))};
+  if (!eWaiting) return false;
+  waits.push_back(awaitThenCreate(
+    loop, *eWaiting, i ? dir / std::to_string(i - 1) : ""));
+  loop.start(waits.back());
+ }
+ std::ofstream {dir / std::to_string(waits.size() - 1)};
+ for (std::size_t i = 0; i < waits.size(); ++i)
+  ok &= loop.finish(waits[i]) && waits[i].result() == static_cast<int>(i);
+ std::filesystem::remove_all(dir);
+
+ if (!ok)
+  std::cerr << "Event loop checks failed with " << name(loop.backend())
+            << "\n";
+ return ok;
+}
+
+// Compiles and runs the source on a Vm of the backend, checking its output and
+// exit status.
+static bool check(Backend backend, std::string_view source,
+                  std::string_view expected, int expectedStatus = 0) {
+ Backend used {backend};
+ bool    ok {test::checkWith(source, expected, expectedStatus,
+                             [&](test::Parsed const &parsed, int out) {
+                              vm::Vm vm {backend};
+                              used = vm.loop().backend();
+                              return test::run(vm, parsed, out);
+                             })};
+ if (!ok) std::cerr << "  with " << name(used) << "\n";
+ return ok;
+}
+
+int main(int argc, char **argv) {
+ bool ok {true};
+
+ // Every stage holds a couple of descriptors until the pipe finishes.
+ rlimit limit;
+ ::getrlimit(RLIMIT_NOFILE, &limit);
+ limit.rlim_cur = limit.rlim_max;
+ ::setrlimit(RLIMIT_NOFILE, &limit);
+ std::size_t const stages {std::min<std::size_t>(
+   1000, (std::min<rlim_t>(limit.rlim_cur, 1 << 16) - 64) / 3)};
+ std::string pipe {"echo a"}, mixed {"printf \"%s\\n\" a b"};
+ for (std::size_t i = 0; i < stages; ++i) {
+  pipe += " |> cat";
+  mixed += i % 10 ? " |> cat" : " |> \"cat\"";
+ }
+
+ for (Backend backend : {Backend::IO_URING, Backend::EPOLL, Backend::POLL}) {
+  ok &= checkLoop(backend);
+  ok &= check(backend, "echo a |> cat |> tr a b |> cat", "b\n");
+  ok &= check(backend, "cat \"test/plush_sources/vm.psh\" |> test \"-n\" x",
+              "");
+  ok &= check(backend, "echo a |> false |> cat", "");
+  ok &= check(backend, "echo a |> cat |> false", "", 1);
+  ok &= check(backend, "echo a |> plush_no_such_command", "", 127);
+  ok &= check(backend, pipe, "a\n");
+  ok &= check(backend, mixed, "a\nb\n");
+ }
+
+ return !ok;
+}
@@ -0,0 +1,106 @@
+// Fixture shared by the tests compiling and running Plush sources.
+
+#pragma once
+
+#ifndef PLUSH_TEST_HARNESS_H
+#define PLUSH_TEST_HARNESS_H
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "bits/Expect.h"
+#include "lexer/lex.h"
+#include "parser/parse.h"
+#include "vm/Builtins.h"
+#include "vm/Vm.h"
+#include "vm/compile.h"
+
+namespace plush::test {
+
+// Source lexed and parsed, along with the tables its tree refers to.
+struct Parsed {
+ IdTable             idTable;
+ SourceManager       srcMgr;
+ DiagnosticsManager  diagMgr;
+ TokenBuffer         tokBuf;
+ ast::Ast            ast;
+ vm::BuiltinRegistry builtins;
+
+ explicit Parsed(std::string_view source)
+   : tokBuf {lex(srcMgr.addShellInput(std::string {source}), idTable,
+                 diagMgr)},
+     ast {parse(tokBuf, diagMgr)}, builtins {idTable} {}
+ Parsed(Parsed &&)                 = delete;
+ Parsed(Parsed const &)            = delete;
+ Parsed &operator=(Parsed &&)      = delete;
+ Parsed &operator=(Parsed const &) = delete;
+};
+
+// Reads back everything written to a file.
+inline std::string readBack(std::FILE *file) {
+ std::string content;
+ std::rewind(file);
+ for (int c; (c = std::fgetc(file)) != EOF;) content += static_cast<char>(c);
+ return content;
+}
+
+// Calls fn with the descriptor of a temporary file, storing what it wrote to
+// the file within output. Returns the result of fn.
+template <class Fn>
+auto capture(Fn &&fn, std::string &output) {
+ std::FILE *file {std::tmpfile()};
+ auto       result {fn(fileno(file))};
+ output = readBack(file);
+ std::fclose(file);
+ return result;
+}
+
+// Compiles the parsed source, then runs it on machine writing to out.
+inline Expect<int> run(vm::Vm &machine, Parsed const &parsed, int out) {
+ auto eChunk {vm::compile(parsed.ast, parsed.builtins)};
+ if (!eChunk) return eChunk.takeError<BasicError>();
+ return machine.run(*eChunk, 0, out);
+}
+
+// Parses the source, then runs it with run, called with the parsed source and
+// the descriptor to write to. Checks its output and exit status.
+template <class Run>
+bool checkWith(std::string_view source, std::string_view expected,
+               int expectedStatus, Run &&run) {
+ Parsed parsed {source};
+ if (parsed.diagMgr.dump()) return false;
+
+ std::string actual;
+ auto        eStatus {
+   capture([&](int out) { return run(parsed, out); }, actual)};
+ if (eStatus && *eStatus == expectedStatus && actual == expected) return true;
+
+ std::cerr << "Running \"" << source.substr(0, 80) << "\"\n  expected: \""
+           << expected.substr(0, 80) << "\" (" << expectedStatus
+           << ")\n  actual:   \"" << actual.substr(0, 80) << "\" ("
+           << (eStatus ? *eStatus : -1) << ")\n";
+ if (!eStatus)
+  std::cerr << "  "
+            << eStatus.template takeError<BasicError>().userFriendlyMessage()
+            << "\n";
+ return false;
+}
+
+// Compiles and runs the source on a Vm, checking its output and exit status.
+inline bool check(std::string_view source, std::string_view expected,
+                  int expectedStatus = 0) {
+ return checkWith(source, expected, expectedStatus,
+                  [](Parsed const &parsed, int out) {
+                   vm::Vm vm;
+                   return test::run(vm, parsed, out);
+                  });
+}
+
+} // namespace plush::test
+
+#endif // PLUSH_TEST_HARNESS_H
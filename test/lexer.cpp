@@ -1,10 +1,39 @@
-#include "driver/interpret.h"
+#include <cstdint>
+#include <string>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/FileManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "lexer/lex.h"
 
 using namespace plush;
 
 int main(int argc, char **argv) {
- return !driver::interpret({
-   /* debugEnabled */ true,
-   /* filePaths */ {"test/plush_sources/lexer.psh"},
- });
+ FileManager fileMgr;
+ auto        eFileInfo {fileMgr.readFile("test/plush_sources/lexer.psh")};
+ if (!eFileInfo) return 1;
+
+ SourceManager      srcMgr;
+ IdTable            idTable;
+ DiagnosticsManager diagMgr;
+ TokenBuffer tokBuf {lex(srcMgr.addFile(*eFileInfo), idTable, diagMgr)};
+ if (diagMgr.dump()) return 1;
+
+ DocWriter writer {1};
+ for (auto tok : tokBuf) writer.line(tok.doc());
+
+ // Lexing goes on past ill-formed UTF-8 sequences unless the error limit is
+ // reached.
+ std::string const  illFormed {"a b c \xff d \xC3("};
+ DiagnosticsManager illFormedDiagMgr {SIZE_MAX};
+ TokenBuffer illFormedTokBuf {
+   lex(srcMgr.addShellInput(illFormed), idTable, illFormedDiagMgr)};
+ if (5 != illFormedTokBuf.size() ||
+     2 != illFormedDiagMgr.count(Diagnostic::ERROR))
+  return 1;
+ DiagnosticsManager limitedDiagMgr;
+ if (3 != lex(srcMgr.addShellInput(illFormed), idTable, limitedDiagMgr).size())
+  return 1;
+ return 0;
 }
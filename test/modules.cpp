@@ -0,0 +1,112 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "driver/ModuleLoader.h"
+#include "driver/interpret.h"
+
+using namespace plush;
+
+static std::filesystem::path gDir;
+
+static void write(std::filesystem::path const &path, std::string_view content) {
+ std::filesystem::create_directories((gDir / path).parent_path());
+ std::ofstream {gDir / path} << content;
+}
+
+// Loads the provided files, checking the names of the loaded modules in order,
+// or that loading fails with an error containing expected if it starts with
+// "!".
+static bool check(std::vector<std::filesystem::path> paths,
+                  std::vector<std::string_view> const &expected,
+                  std::size_t                          threadCount = 4) {
+ for (auto &path : paths) path = gDir / path;
+
+ FileManager   fileMgr;
+ SourceManager srcMgr;
+ IdTable       idTable {threadCount > 1};
+ ThreadPool    pool {threadCount};
+ fileMgr.addLookupDir(gDir / "include");
+ driver::ModuleLoader loader {fileMgr, srcMgr, idTable, pool};
+ auto                 eModules {loader.load(paths)};
+
+ std::vector<std::string> actual;
+ if (eModules)
+  for (auto *module : *eModules)
+   actual.push_back(module->path.filename().string());
+ else
+  actual.push_back("!" +
+                   eModules.takeError<BasicError>().userFriendlyMessage());
+
+ bool ok {actual.size() == expected.size()};
+ for (std::size_t i = 0; ok && i < actual.size(); ++i)
+  ok = '!' == expected[i][0]
+         ? actual[i].find(expected[i].substr(1)) != std::string::npos
+         : actual[i] == expected[i];
+ if (ok) return true;
+
+ std::cerr << "Loading " << paths.front() << "\n  expected:";
+ for (auto name : expected) std::cerr << " " << name;
+ std::cerr << "\n  actual:  ";
+ for (auto &name : actual) std::cerr << " " << name;
+ std::cerr << "\n";
+ return false;
+}
+
+int main(int argc, char **argv) {
+ gDir = std::filesystem::temp_directory_path() /
+        ("plush_modules_" + std::to_string(::getpid()));
+ std::filesystem::create_directories(gDir);
+
+ // Imports resolve relative to the importing module, then to the working
+ // directory and lookup directories.
+ write("main.psh", "import \"a.psh\"; import \"lib/b.psh\" as b; "
+                   "import \"d.psh\"; echo \"main\"");
+ write("a.psh", "module a; import \"lib/b.psh\"; echo \"a\"");
+ write("lib/b.psh", "import \"c.psh\"; echo \"b\"");
+ write("lib/c.psh", "echo \"c\"");
+ write("include/d.psh", "if true { import \"../lib/c.psh\" }; echo \"d\"");
+ write("cycle1.psh", "import \"cycle2.psh\"");
+ write("cycle2.psh", "import \"cycle3.psh\"");
+ write("cycle3.psh", "import \"cycle1.psh\"");
+ write("missing.psh", "import \"nowhere.psh\"");
+ write("self.psh", "import \"./self.psh\"");
+
+ bool ok {true};
+ for (std::size_t threadCount : {1, 4}) {
+  ok &= check({"main.psh"}, {"c.psh", "b.psh", "a.psh", "d.psh", "main.psh"},
+              threadCount);
+  // Modules given twice or imported by other inputs are loaded once.
+  ok &= check({"lib/b.psh", "main.psh", "lib/../main.psh"},
+              {"c.psh", "b.psh", "a.psh", "d.psh", "main.psh"}, threadCount);
+  ok &= check({"cycle1.psh"}, {"!Import cycle"}, threadCount);
+  ok &= check({"self.psh"}, {"!Import cycle"}, threadCount);
+  ok &= check({"missing.psh"}, {"!Couldn't find module \"nowhere.psh\""},
+              threadCount);
+  ok &= check({"nowhere.psh"}, {"!Couldn't find file"}, threadCount);
+ }
+
+ // The driver runs every module once, imported modules first.
+ std::string const output {(gDir / "output").string()};
+ write("run.psh", "import \"lib/b.psh\"; import \"lib/c.psh\"; "
+                  "sh \"-c\" \"echo run >> $PLUSH_TEST_OUTPUT\"");
+ write("lib/b.psh", "import \"c.psh\"; "
+                    "sh \"-c\" \"echo b >> $PLUSH_TEST_OUTPUT\"");
+ write("lib/c.psh", "sh \"-c\" \"echo c >> $PLUSH_TEST_OUTPUT\"");
+ ::setenv("PLUSH_TEST_OUTPUT", output.c_str(), 1);
+ auto eStatus {driver::interpret({false, {gDir / "run.psh"}})};
+ std::ifstream in {output};
+ std::string   ran {std::istreambuf_iterator<char> {in}, {}};
+ if (!eStatus || *eStatus || ran != "c\nb\nrun\n") {
+  std::cerr << "Running run.psh printed \"" << ran << "\"\n";
+  ok = false;
+ }
+
+ std::filesystem::remove_all(gDir);
+ return !ok;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <string_view>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "lexer/lex.h"
+#include "parser/parse.h"
+
+using namespace plush;
+
+// Parses the source, checking the rendered tree and the number of errors.
+static bool check(std::string_view source, std::string_view expected,
+                  std::size_t errorCount = 0) {
+ IdTable            idTable;
+ SourceManager      srcMgr;
+ DiagnosticsManager diagMgr {SIZE_MAX};
+ TokenBuffer tokBuf {lex(srcMgr.addShellInput(std::string {source}), idTable,
+                         diagMgr)};
+ ast::Ast    ast {parse(tokBuf, diagMgr)};
+
+ std::string actual {ast.doc().toString()};
+ if (actual == expected && diagMgr.count(Diagnostic::ERROR) == errorCount)
+  return true;
+
+ std::cerr << "Parsing \"" << source << "\"\n  expected: " << expected << " ("
+           << errorCount << " errors)\n  actual:   " << actual << " ("
+           << diagMgr.count(Diagnostic::ERROR) << " errors)\n";
+ return false;
+}
+
+int main(int argc, char **argv) {
+ bool ok {true};
+
+ ok &= check("", "Block()");
+ ok &= check("echo \"hi\" there", "Block(Command(echo, \"hi\", there))");
+ ok &= check("a; b;", "Block(Command(a), Command(b))");
+ // |> is left associative.
+ ok &= check("a |> b |> c", "Block(BinOp(|>, BinOp(|>, Command(a), "
+                            "Command(b)), Command(c)))");
+ // <| is right associative.
+ ok &= check("a <| b <| c", "Block(BinOp(<|, Command(a), BinOp(<|, "
+                            "Command(b), Command(c))))");
+ // |> binds tighter than <|.
+ ok &= check("a |> b <| c", "Block(BinOp(<|, BinOp(|>, Command(a), "
+                            "Command(b)), Command(c)))");
+ ok &= check("a <| b |> c", "Block(BinOp(<|, Command(a), BinOp(|>, "
+                            "Command(b), Command(c))))");
+ ok &= check("(a <| b) |> c", "Block(BinOp(|>, BinOp(<|, Command(a), "
+                              "Command(b)), Command(c)))");
+ ok &= check("let x: ls |> sort",
+             "Block(Let(x, BinOp(|>, Command(ls), Command(sort))))");
+ ok &= check("module m; import \"a/b\" as b; import \"c\"",
+             "Block(Module(m), Import(\"a/b\", b), Import(\"c\"))");
+ ok &= check("if test x { a; b } { c } d",
+             "Block(If(Command(test, x), Block(Command(a), Command(b)), "
+             "Block(Command(c))), Command(d))");
+ ok &= check("do { a |> b; } |> c",
+             "Block(BinOp(|>, Do(Block(BinOp(|>, Command(a), Command(b)))), "
+             "Command(c)))");
+
+ // Statements are recovered from, up to the next ';' or closing '}'.
+ ok &= check("let : a; b", "Block(Command(b))", 1);
+ ok &= check("a b (c; d", "Block()", 1);
+ ok &= check("a |> ; b", "Block(Command(b))", 1);
+ ok &= check("do { a |> } ; b", "Block(Do(Block()), Command(b))", 1);
+ ok &= check("} a", "Block()", 1);
+ ok &= check("if a { b", "Block()", 1);
+
+ return !ok;
+}
@@ -0,0 +1,129 @@
+#include <cstdio>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "exec/Launcher.h"
+#include "exec/Pipe.h"
+#include "harness.h"
+
+using namespace plush;
+using test::check;
+
+// Checks transferring through pipes and between regular files.
+static bool checkTransfer() {
+ std::string data;
+ // Small enough to fit a default sized pipe without a concurrent reader.
+ for (int i = 0; i < 10000; ++i) data += std::to_string(i);
+
+ std::FILE *src {std::tmpfile()}, *dst {std::tmpfile()};
+ std::fwrite(data.data(), 1, data.size(), src);
+ std::fflush(src);
+ std::rewind(src);
+
+ // File to file is copied.
+ auto eMoved {exec::transfer(fileno(src), fileno(dst))};
+ bool ok {eMoved && *eMoved == data.size() && test::readBack(dst) == data};
+
+ // File to pipe is spliced.
+ auto ePipe {exec::Pipe::open()};
+ ::lseek(fileno(src), 0, SEEK_SET);
+ eMoved = exec::transfer(fileno(src), (*ePipe).write.get());
+ (*ePipe).write.close();
+ std::string piped;
+ char        buffer[4096];
+ for (ssize_t n; (n = ::read((*ePipe).read.get(), buffer, sizeof buffer)) > 0;)
+  piped.append(buffer, n);
+ ok &= eMoved && *eMoved == data.size() && piped == data;
+
+ std::fclose(src);
+ std::fclose(dst);
+ if (!ok) std::cerr << "Transfer mismatch\n";
+ return ok;
+}
+
+// Checks grown pipes take up at most the budget at once.
+static bool checkBudget() {
+ bool                    ok {true};
+ std::vector<exec::Pipe> pipes;
+ std::size_t             grown {0};
+ for (std::size_t i = 0; i <= exec::Pipe::BUDGET / exec::Pipe::CAPACITY; ++i) {
+  auto ePipe {exec::Pipe::open(true)};
+  if (!ePipe) return false;
+  grown += (*ePipe).grown;
+  pipes.push_back(std::move(*ePipe));
+ }
+ auto ePlain {exec::Pipe::open()};
+ ok &= grown <= exec::Pipe::BUDGET && !pipes.back().grown && ePlain &&
+       !(*ePlain).grown;
+
+ // Released capacity can be taken again.
+ pipes.clear();
+ exec::Pipe::release(grown);
+ auto ePipe {exec::Pipe::open(true)};
+ ok &= ePipe && (*ePipe).grown;
+ exec::Pipe::release(ePipe ? (*ePipe).grown : 0);
+
+ if (!ok) std::cerr << "Pipe budget mismatch\n";
+ return ok;
+}
+
+// Checks launching with redirections and an overridden environment.
+static bool checkLauncher() {
+ char path[] {"/tmp/plush-launcherXXXXXX"};
+ ::close(::mkstemp(path));
+
+ exec::Launcher launcher;
+ launcher.setEnv("PLUSH_TEST", "first");
+ launcher.setEnv("PLUSH_TEST", "second");
+ std::string_view const argv[] {"sh", "-c", "echo $PLUSH_TEST; echo err >&2"};
+ exec::Redirect const   redirects[] {
+   exec::Redirect::open(1, path, O_WRONLY | O_TRUNC),
+   exec::Redirect::dup(2, 1)};
+
+ bool ok {true};
+ // The launcher's arena and resolved paths are reused between launches.
+ for (int i = 0; i < 3; ++i) {
+  auto ePid {launcher.spawn(std::begin(argv), std::end(argv),
+                            std::begin(redirects), std::end(redirects))};
+  if (!ePid) {
+   ok = false;
+   continue;
+  }
+  auto eStatus {exec::Launcher::wait(*ePid)};
+  ok &= eStatus && 0 == *eStatus;
+ }
+
+ std::FILE  *file {std::fopen(path, "r")};
+ std::string actual {test::readBack(file)};
+ std::fclose(file);
+ ::unlink(path);
+
+ std::string_view const missing[] {"plush_no_such_command"};
+ ok &= actual == "second\nerr\n" &&
+       !launcher.spawn(std::begin(missing), std::end(missing));
+ if (!ok) std::cerr << "Launcher mismatch: \"" << actual << "\"\n";
+ return ok;
+}
+
+int main(int argc, char **argv) {
+ bool ok {true};
+
+ ok &= check("echo hi", "hi\n");
+ ok &= check("printf \"b\\na\\nc\\n\" |> sort |> head \"-n\" \"2\"", "a\nb\n");
+ // Data flows from right to left through <|.
+ ok &= check("tr a b <| echo aaa", "bbb\n");
+ ok &= check("wc \"-l\" <| printf \"x\\ny\\n\" |> cat", "2\n");
+ // Every stage runs concurrently, the producer outruns any pipe's capacity.
+ ok &= check("yes |> head \"-c\" \"4000000\" |> wc \"-c\"", "4000000\n");
+ ok &= check("echo |> false", "", 1);
+ ok &= check("plush_no_such_command", "", 127);
+ ok &= checkTransfer();
+ ok &= checkBudget();
+ ok &= checkLauncher();
+
+ return !ok;
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "basic/DiagnosticsManager.h"
+#include "basic/IdTable.h"
+#include "basic/SourceManager.h"
+#include "lexer/lex.h"
+
+using namespace plush;
+
+// Checks if both buffers hold the same tokens.
+static bool same(TokenBuffer const &a, TokenBuffer const &b) {
+ if (a.size() != b.size()) return false;
+ for (std::size_t i = 0; i < a.size(); ++i) {
+  TokenView x {a[i]}, y {b[i]};
+  if (x.token().kind() != y.token().kind() || x.offset() != y.offset() ||
+      x.length() != y.length())
+   return false;
+  if (x.is<token::String>()
+        ? x.get<token::String>().string() != y.get<token::String>().string()
+        : x.token().payload() != y.token().payload())
+   return false;
+ }
+ return true;
+}
+
+// Applies random edits, checking the re-lexed tokens and the incrementally
+// found ill-formed UTF-8 sequences against lexing and validating from scratch.
+static bool check(std::uint64_t seed, bool illFormed) {
+ constexpr std::string_view FRAGMENTS[] {
+   "a", "let", " ", "\n", "#", "\"", "\"x\\n\"", "|>", "<|", "(", ":", "é",
+   "\\", "$", "\xC3", "\x80", "\xED\xA0\x80", "\xF0\x9F"};
+ // Number of leading fragments that are well-formed UTF-8.
+ constexpr std::size_t WELL_FORMED_SIZE {std::size(FRAGMENTS) - 4};
+
+ std::mt19937_64 engine {seed};
+ IdTable         idTable;
+ SourceManager   srcMgr;
+ SourceInfo        *srcInfo {srcMgr.addShellInput(
+   "let hi there (:module ;|><| \"im in a string!\\n\" # comment\n"
+   "x |> y <| z \"a\\\\b\" [ ] { } # end")};
+
+ // Lexing continues after errors so every edit can be compared.
+ DiagnosticsManager initialDiagMgr {SIZE_MAX};
+ TokenBuffer        tokBuf {lex(srcInfo, idTable, initialDiagMgr)};
+
+ for (int i = 0; i < 2000; ++i) {
+  DiagnosticsManager diagMgr {SIZE_MAX};
+  std::string_view content {srcInfo->sourceContent()};
+  std::uint32_t    offset = engine() % (content.size() + 1);
+  std::uint32_t    length = engine() % 4;
+  // Keep edits on codepoint boundaries.
+  auto boundary = [&](std::uint32_t o) {
+   while (o < content.size() && (content[o] & 0b11000000) == 0b10000000) ++o;
+   return o;
+  };
+  offset = boundary(offset);
+  length = boundary(std::min<std::size_t>(offset + length, content.size())) -
+           offset;
+  std::string text;
+  for (std::uint64_t n = engine() % 3; n; --n)
+   text += FRAGMENTS[engine() %
+                     (illFormed ? std::size(FRAGMENTS) : WELL_FORMED_SIZE)];
+
+  relex(tokBuf, {offset, length, text}, diagMgr);
+
+  auto const &invalid {srcInfo->invalidRegions()};
+  auto const &expectedInvalid {
+    srcMgr.addShellInput(std::string {srcInfo->sourceContent()})
+      ->invalidRegions()};
+  if (!std::equal(invalid.begin(), invalid.end(), expectedInvalid.begin(),
+                  expectedInvalid.end(),
+                  [](SourceRegion a, SourceRegion b) {
+                   return a.beginOffset() == b.beginOffset() &&
+                          a.endOffset() == b.endOffset();
+                  })) {
+   std::cerr << "Invalid UTF-8 mismatch after edit " << i << "\n";
+   return false;
+  }
+
+  TokenBuffer expected {lex(srcInfo, idTable, diagMgr)};
+  if (!same(tokBuf, expected)) {
+   std::cerr << "Mismatch after edit " << i << " of \"" << srcInfo->sourceContent()
+             << "\"\n";
+   return false;
+  }
+ }
+
+ std::cout << "Re-lexed " << tokBuf.size() << " tokens.\n";
+ return true;
+}
+
+// Checks edits only report the ill-formed UTF-8 sequences they re-lex over.
+static bool checkDiagnostics() {
+ IdTable            idTable;
+ SourceManager      srcMgr;
+ SourceInfo        *srcInfo {srcMgr.addShellInput("a b c \xff d")};
+ DiagnosticsManager initialDiagMgr {SIZE_MAX};
+ TokenBuffer        tokBuf {lex(srcInfo, idTable, initialDiagMgr)};
+ bool               ok {1 == initialDiagMgr.count(Diagnostic::ERROR)};
+
+ // Edits resyncing before the sequence don't report it again.
+ for (int i = 0; i < 3; ++i) {
+  DiagnosticsManager diagMgr {SIZE_MAX};
+  relex(tokBuf, {0, 1, "x"}, diagMgr);
+  ok &= !diagMgr.count(Diagnostic::ERROR);
+ }
+
+ // Edits lexing over it do.
+ DiagnosticsManager diagMgr {SIZE_MAX};
+ relex(tokBuf, {4, 1, "y"}, diagMgr);
+ ok &= 1 == diagMgr.count(Diagnostic::ERROR);
+
+ if (!ok) std::cerr << "Unexpected ill-formed UTF-8 diagnostics\n";
+ return ok;
+}
+
+int main(int argc, char **argv) {
+ return !(check(1, false) && check(2, true) && checkDiagnostics());
+}
@@ -0,0 +1,90 @@
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "harness.h"
+#include "vm/Schedule.h"
+
+using namespace plush;
+
+// Schedules the source, checking the successors of every statement, then runs
+// it on jobs workers, checking its output and exit status.
+static bool check(std::string_view source,
+                  std::vector<std::vector<std::uint32_t>> const &successors,
+                  std::string_view expected, int expectedStatus = 0,
+                  std::size_t jobs = 4) {
+ return test::checkWith(
+   source, expected, expectedStatus,
+   [&](test::Parsed const &parsed, int out) -> Expect<int> {
+    auto eSchedule {vm::Schedule::analyze(parsed.ast, parsed.builtins)};
+    if (!eSchedule) return eSchedule.takeError<BasicError>();
+    vm::Schedule const &schedule {*eSchedule};
+
+    bool ok {schedule.size() == successors.size()};
+    for (std::size_t i = 0; ok && i < successors.size(); ++i)
+     ok = schedule.successors(i) == successors[i];
+    if (!ok) {
+     std::string message {"Actual successors:"};
+     for (std::size_t i = 0; i < schedule.size(); ++i) {
+      message += " {";
+      for (auto successor : schedule.successors(i))
+       message += " " + std::to_string(successor);
+      message += " }";
+     }
+     return BasicError {message};
+    }
+
+    vm::Vm           vm;
+    WorkStealingPool pool {jobs};
+    return schedule.run(vm, pool, 0, out);
+   });
+}
+
+int main(int argc, char **argv) {
+ bool ok {true};
+
+ ok &= check("", {}, "");
+ ok &= check("true; false", {{}, {}}, "", 1);
+ // Output is written in program order, however long each statement takes.
+ ok &= check("sh \"-c\" \"sleep 0.2; echo a\"; echo b; echo c |> cat",
+             {{}, {}, {}}, "a\nb\nc\n");
+ // Statements of do blocks are scheduled like top level statements.
+ ok &= check("do { echo a; do { echo b } }; echo c", {{}, {}, {}},
+             "a\nb\nc\n");
+ // Statements after a let wait for it, yet run with the environment before
+ // later lets.
+ ok &= check("let x: echo a; sh \"-c\" \"echo $x\"; let x: echo b; "
+             "sh \"-c\" \"echo $x\"",
+             {{1, 2}, {}, {3}, {}}, "a\nb\n");
+ ok &= check("echo a; let x: echo b; if true { let y: echo c }; echo d",
+             {{}, {2}, {3}, {}}, "a\nd\n");
+ // Barriers wait for every statement before them and are waited for by every
+ // statement after them.
+ ok &= check("echo a; echo b; cd \"/\"; pwd; pwd",
+             {{2}, {2}, {3, 4}, {}, {}}, "a\nb\n/\n/\n");
+ ok &= check("echo a; exit \"3\"; echo b", {{1}, {2}, {}}, "a\n", 3);
+ ok &= check("if false { exit } { echo a }; echo b", {{1}, {}}, "a\nb\n");
+ // Builtins affecting Plush run isolated within pipelines, so such pipes
+ // aren't barriers.
+ ok &= check("echo a |> exit \"3\"; echo b", {{}, {}}, "b\n");
+ ok &= check("echo a |> cd \"/\"; echo b", {{}, {}}, "b\n");
+
+ // Independent statements overlap: each creates a file then waits for the
+ // other's, giving up after 10s. Both only meet if they run at once.
+ auto const dir {std::filesystem::temp_directory_path() /
+                 ("plush_schedule_" + std::to_string(::getpid()))};
+ std::string rendezvous;
+ for (auto [self, other] : {std::pair {"a", "b"}, std::pair {"b", "a"}})
+  rendezvous += "sh \"-c\" \"touch " + (dir / self).string() +
+                "; i=0; until test -e " + (dir / other).string() +
+                "; do i=$((i+1)); test $i -gt 1000 && { echo alone; exit; };" +
+                " sleep 0.01; done; echo met\";";
+ std::filesystem::create_directories(dir);
+ ok &= check(rendezvous, {{}, {}}, "met\nmet\n", 0, 2);
+ std::filesystem::remove_all(dir);
+
+ return !ok;
+}
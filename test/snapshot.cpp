@@ -0,0 +1,149 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+#include "driver/Snapshot.h"
+#include "driver/interpret.h"
+#include "harness.h"
+
+using namespace plush;
+
+// Runs a chunk, returning its output.
+static std::string run(vm::Chunk const &chunk) {
+ vm::Vm      vm;
+ std::string output;
+ auto        eStatus {test::capture(
+   [&](int out) { return vm.run(chunk, 0, out); }, output)};
+ return eStatus ? output : "<error>";
+}
+
+static void write(std::filesystem::path const &path, std::string_view content) {
+ std::ofstream {path} << content;
+}
+
+// Saves then maps a snapshot, checking identifiers and the prelude survive.
+static bool checkRoundTrip(std::filesystem::path const &path) {
+ bool ok {true};
+
+ test::Parsed parsed {"echo \"hi\" |> tr h H; foo"};
+ IdTable     &idTable {parsed.idTable};
+ auto         eChunk {vm::compile(parsed.ast, parsed.builtins)};
+ if (parsed.diagMgr.dump() || !eChunk) return false;
+
+ ok &= bool {driver::Snapshot::save(path, 42, idTable, &*eChunk)};
+ ok &= !driver::Snapshot::map(path, 43);
+ auto eSnapshot {driver::Snapshot::map(path, 42)};
+ if (!ok || !eSnapshot) return false;
+
+ // Identifiers keep their index and keyword kind.
+ IdTable restored {IdTable::EmptyTag {}};
+ (*eSnapshot).restore(restored);
+ idTable.forEach([&](IdInfo const &idInfo, std::size_t) {
+  IdInfo *other {restored.at(idInfo.index())};
+  ok &= other->stringRep() == idInfo.stringRep();
+  ok &= other->isKeyword() == idInfo.isKeyword();
+  if (idInfo.isKeyword()) ok &= other->keywordKind() == idInfo.keywordKind();
+ });
+ ok &= restored.get("foo")->index() == idTable.get("foo")->index();
+ ok &= restored.get("module")->isKeyword(token::Keyword::MODULE);
+
+ auto optPrelude {(*eSnapshot).prelude()};
+ ok &= optPrelude && optPrelude->code() == (*eChunk).code();
+ ok &= optPrelude && "Hi\n" == run(*optPrelude);
+ ok &= "Hi\n" == run(*eChunk);
+
+ // A corrupted or truncated image is rejected.
+ {
+  std::fstream image {path, std::ios::in | std::ios::out | std::ios::binary};
+  image.seekp(-1, std::ios::end);
+  image.put('\x7f');
+ }
+ ok &= !driver::Snapshot::map(path, 42);
+ std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+ ok &= !driver::Snapshot::map(path, 42);
+ std::filesystem::remove(path);
+
+ if (!ok) std::cerr << "Snapshot round trip failed\n";
+ return ok;
+}
+
+// Saves images whose code refers to anything missing, checking they're
+// rejected.
+static bool checkMalformedCode(std::filesystem::path const &path) {
+ using namespace vm;
+ IdTable idTable;
+ auto    rejected {[&](std::vector<std::uint32_t> code) {
+  Chunk chunk {std::move(code), {"echo", "x"}, {{0, 2}}};
+  if (!driver::Snapshot::save(path, 42, idTable, &chunk)) return false;
+  return !driver::Snapshot::map(path, 42);
+ }};
+
+ bool ok {true};
+ ok &= !rejected({encode(SPAWN, 2, 0, 1), 0, encode(JUMP), 4, encode(HALT, 2)});
+ // Missing commands, strings and builtins.
+ ok &= rejected({encode(SPAWN, 2, 0, 1), 1, encode(HALT, 2)});
+ ok &= rejected({encode(CAPTURE, 2), 2, encode(HALT, 2)});
+ ok &= rejected({encode(BUILTIN, 2, 0, 1), 8, 0, encode(HALT, 2)});
+ // Pipes whose write end is past the last register.
+ ok &= rejected({encode(PIPE, REG_SIZE - 1), 0, encode(HALT, 2)});
+ // Jumps past the end or within an instruction.
+ ok &= rejected({encode(JUMP), 3, encode(HALT, 2)});
+ ok &= rejected({encode(JUMP), 1, encode(HALT, 2)});
+ // Unknown opcodes, missing operand words, running past the end.
+ ok &= rejected({std::uint32_t {OP_SIZE}});
+ ok &= rejected({encode(LOADI, 2)});
+ ok &= rejected({encode(LOADI, 2), 0});
+ std::filesystem::remove(path);
+
+ if (!ok) std::cerr << "Malformed snapshot code was accepted\n";
+ return ok;
+}
+
+// Runs a script with a prelude through the driver, first saving a snapshot
+// then mapping it.
+static bool checkDriver(std::filesystem::path const &dir) {
+ auto prelude {dir / "prelude.psh"}, script {dir / "script.psh"},
+   image {dir / "image"};
+ write(prelude, "let greeting: echo \"hi\" |> tr h H");
+ write(script, "sh \"-c\" \"test \\\"$greeting\\\" = Hi\"");
+
+ driver::Options options {false, {script}};
+ options.preludePath  = prelude;
+ options.snapshotPath = image;
+
+ bool ok {true};
+ auto eStatus {driver::interpret(options)};
+ ok &= eStatus && 0 == *eStatus;
+ ok &= std::filesystem::exists(image);
+ eStatus = driver::interpret(options);
+ ok &= eStatus && 0 == *eStatus;
+
+ // Editing the prelude makes the snapshot stale, even keeping its size and
+ // modification time.
+ auto const modified {std::filesystem::last_write_time(prelude)};
+ write(prelude, "let greeting: echo \"ho\" |> tr h H");
+ std::filesystem::last_write_time(prelude, modified);
+ eStatus = driver::interpret(options);
+ ok &= eStatus && 1 == *eStatus;
+
+ if (!ok) std::cerr << "Driver snapshot failed\n";
+ return ok;
+}
+
+int main(int argc, char **argv) {
+ auto dir {std::filesystem::temp_directory_path() /
+           ("plush_snapshot_" + std::to_string(::getpid()))};
+ std::filesystem::create_directories(dir);
+
+ bool ok {true};
+ ok &= checkRoundTrip(dir / "roundtrip");
+ ok &= checkMalformedCode(dir / "malformed");
+ ok &= checkDriver(dir);
+
+ std::filesystem::remove_all(dir);
+ return !ok;
+}
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <string_view>
+
+#include "bits/utf8.h"
+
+using namespace plush;
+
+int main(int argc, char **argv) {
+ struct Case {
+  std::string_view input;
+  // Offset and size of the first ill-formed sequence, offset is the input's
+  // size if there is none.
+  std::size_t offset, size;
+ };
+
+ constexpr Case CASES[] {
+   {"plain ascii text, long enough to fill a whole vector or two", 59, 0},
+   {"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x90\x9A", 14, 0},
+   // Truncated at the end of input.
+   {"abc\xE2\x82", 3, 2},
+   {"\xF0\x9F\x90", 0, 3},
+   // Lone continuation byte.
+   {"a\x80z", 1, 1},
+   // Overlong encodings.
+   {"\xC0\xAF", 0, 1},
+   {"\xE0\x80\xAF", 0, 1},
+   // Surrogate.
+   {"xx\xED\xA0\x80", 2, 1},
+   // Above U+10FFFF.
+   {"\xF4\x90\x80\x80", 0, 1},
+   {"\xF5\x80", 0, 1},
+   // Ill-formed sequence past a whole vector of ASCII.
+   {"0123456789abcdef0123456789abcdef0123456789\xC3(", 42, 1},
+ };
+
+ for (auto &c : CASES) {
+  char const *begin {c.input.data()}, *end {begin + c.input.size()};
+  char const *it {utf8::findInvalid(begin, end)};
+  std::size_t offset = it - begin;
+  std::size_t size {it == end ? 0 : utf8::invalidSize(it, end)};
+  if (offset != c.offset || size != c.size) {
+   std::cerr << "Expected " << c.offset << "+" << c.size << ", found "
+             << offset << "+" << size << " for \"" << c.input << "\"\n";
+   return 1;
+  }
+ }
+
+ std::cout << "Validated " << std::size(CASES) << " inputs.\n";
+}
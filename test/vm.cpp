@@ -0,0 +1,115 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+#include "driver/interpret.h"
+#include "harness.h"
+
+using namespace plush;
+using test::check;
+
+// Checks commands are looked up in PATH as set by let, with or without jobs.
+static bool checkPath() {
+ auto const dir {std::filesystem::temp_directory_path() /
+                 ("plush_path_" + std::to_string(::getpid()))};
+ std::string source;
+ for (char const *name : {"a", "b"}) {
+  auto const tool {dir / name / "plush_path_tool"};
+  std::filesystem::create_directories(tool.parent_path());
+  std::ofstream {tool} << "#!/bin/sh\necho " << name << "\n";
+  std::filesystem::permissions(tool, std::filesystem::perms::owner_all);
+  source += "let PATH: echo \"" + tool.parent_path().string() +
+            ":/usr/bin:/bin\";\n";
+  source += std::string {"let "} + name + ": plush_path_tool;\n";
+ }
+ source += "sh \"-c\" \"test \\\"$a$b\\\" = ab\"\n";
+ bool ok {check(source, "")};
+
+ std::ofstream {dir / "path.psh"} << source;
+ driver::Options options;
+ options.filePaths = {dir / "path.psh"};
+ options.jobs      = 2;
+ auto eStatus {driver::interpret(options)};
+ ok &= eStatus && 0 == *eStatus;
+
+ std::filesystem::remove_all(dir);
+ return ok;
+}
+
+int main(int argc, char **argv) {
+ bool ok {true};
+
+ // The whole driver runs a file, with --debug dumping its bytecode.
+ auto eStatus {driver::interpret({
+   /* debugEnabled */ true,
+   /* filePaths */ {"test/plush_sources/vm.psh"},
+ })};
+ ok &= eStatus && 0 == *eStatus;
+
+ // Running exit stops every later input file, with or without jobs, and so
+ // does running it within the prelude.
+ for (std::size_t jobs : {0, 2}) {
+  driver::Options options;
+  options.filePaths = {"test/plush_sources/exit.psh",
+                       "test/plush_sources/false.psh"};
+  options.jobs      = jobs;
+  eStatus           = driver::interpret(options);
+  ok &= eStatus && 3 == *eStatus;
+
+  options.filePaths   = {"test/plush_sources/false.psh"};
+  options.preludePath = "test/plush_sources/exit.psh";
+  eStatus             = driver::interpret(options);
+  ok &= eStatus && 3 == *eStatus;
+ }
+
+ ok &= check("", "");
+ ok &= check("echo a; echo b", "a\nb\n");
+ ok &= check("false", "", 1);
+ ok &= check("echo a |> tr a b |> tr b c", "c\n");
+ ok &= check("tr a b <| echo a", "b\n");
+ ok &= check("if true { echo yes } { echo no }", "yes\n");
+ ok &= check("if false { echo yes } { echo no }", "no\n");
+ // Without an else block a failed condition succeeds.
+ ok &= check("if false { echo yes }", "");
+ ok &= check("do { echo a; false }", "a\n", 1);
+ ok &= check("let x: echo \"a b\"; sh \"-c\" \"echo $x\"", "a b\n");
+ ok &= check("let x: echo a |> tr a b; let x: sh \"-c\" \"echo $x$x\"; "
+             "sh \"-c\" \"echo $x\"",
+             "bb\n");
+ ok &= check("echo a; exit \"3\"; echo b", "a\n", 3);
+ ok &= check("plush_no_such_command", "", 127);
+
+ // Builtins, alone and as pipeline stages running as coroutines.
+ ok &= check("echo \"-n\" a b", "a b");
+ ok &= check("true |> false", "", 1);
+ ok &= check("echo a |> cat |> cat", "a\n");
+ ok &= check("echo a |> cat |> tr a b |> cat", "b\n");
+ ok &= check("printf \"%s=%03d\\n\" a \"7\" b \"42\"", "a=007\nb=042\n");
+ ok &= check("printf \"%x %c|%-3s|\\n\" \"255\" xyz ab", "ff x|ab |\n");
+ ok &= check("printf \"%d\\n\" nope", "0\n", 1);
+ ok &= check("test a \"=\" a", "");
+ ok &= check("test a \"!=\" a", "", 1);
+ ok &= check("test \"3\" \"-lt\" \"12\"", "");
+ ok &= check("test \"!\" \"-z\" a", "");
+ ok &= check("test \"-d\" \"/\"", "");
+ ok &= check("test \"-f\" \"/\"", "", 1);
+ ok &= check("test a \"-eq\" \"1\"", "", 2);
+ ok &= check("if test a \"=\" b { echo yes } { echo no }", "no\n");
+ ok &= check("cat \"test/plush_sources/vm.psh\" |> test \"-n\" x", "");
+ // A quoted name launches the external command.
+ ok &= check("\"echo\" a |> \"cat\"", "a\n");
+ // Builtins affecting Plush run isolated within pipelines, only returning
+ // their status.
+ ok &= check("echo a |> exit \"3\"", "", 3);
+ ok &= check("echo a |> exit \"3\"; echo b", "b\n");
+ ok &= check("echo a |> cd \"/\"; test \"-f\" \"Makefile\"", "");
+ ok &= check("echo a |> cd \"plush_no_such_dir\"", "", 1);
+ ok &= check("echo a |> cd \"Makefile\"", "", 1);
+ ok &= checkPath();
+ // Runs last, the working directory stays changed.
+ ok &= check("cd \"/\"; pwd", "/\n");
+
+ return !ok;
+}